@@ -3,16 +3,31 @@ from dataclasses import dataclass
 from datetime import datetime
 from enum import Enum
 import heapq
-from typing import Dict, List, Optional, Self, Tuple
+from itertools import chain
+from typing import ClassVar, Dict, List, Optional, Self, Tuple
 
 from card import CardType, TargetType
 from unit import IDUnit, Owner, UnitTarget, UnitTargetType
 from util import DATE_FORMAT, is_time_elapsed
 from util import logger as logging
 
+try:
+    from bindings import GridPathfinder, SpatialGrid
+except ImportError:  # Headless servers can run without the compiled extension
+    GridPathfinder = None
+    SpatialGrid = None
+
 KING_MAX_HP = 1000
 PRINCESS_MAX_HP = 500
 
+# One bit per layer so SpatialGrid can match any of a unit's target types in one test
+LAYER_BITS = {layer: 1 << i for i, layer in enumerate(TargetType)}
+
+
+def layer_bit(layer) -> int:
+    """Bit for a TargetType, or its string value as cards deserialized from packets carry."""
+    return LAYER_BITS[TargetType(layer)]
+
 
 class TileType(Enum):
     EMPTY = 0  # Walkable tile
@@ -44,8 +59,13 @@ class TowerId(Enum):
 
 
 class Arena:
-    WIDTH: int = 19
-    HEIGHT: int = 30
+    WIDTH: ClassVar[int] = 19
+    HEIGHT: ClassVar[int] = 30
+
+    # The state sent to clients, which the packet schema is built from
+    tiles: List[List[int]]
+    units: List[IDUnit]
+    towers: List[Tower]
 
     def __init__(self) -> None:
         self.tiles = [
@@ -143,6 +163,12 @@ class Arena:
             ),
         ]
 
+        self._pathfinder = (
+            GridPathfinder(self.WIDTH, self.HEIGHT) if GridPathfinder else None
+        )
+        self._spatial = SpatialGrid(self.WIDTH, self.HEIGHT) if SpatialGrid else None
+        self._indexed_units: List[IDUnit] = []
+
         self._set_tower_tiles()
 
     def _set_tower_tiles(self) -> None:
@@ -167,6 +193,13 @@ class Arena:
                         ] = TileType.CROWN_TOWER.value
 
         # self.tiles = t.copy()
+        self.sync_tiles()
+
+    def sync_tiles(self) -> bool:
+        """Pushes the tiles to the native pathfinder. Flow fields rebuild lazily if they changed."""
+        if self._pathfinder is None:
+            return False
+        return self._pathfinder.set_tiles(bytes(chain.from_iterable(self.tiles)))
 
     def has_won(self, owner: Owner) -> bool:
         """Checks if the given owner has won the game."""
@@ -177,6 +210,32 @@ class Arena:
         self, start: Tuple[int, int], goal: Tuple[int, int]
     ) -> List[Tuple[int, int]]:
         """Finds the shortest path from start to goal using A* algorithm."""
+        if self._pathfinder is None:
+            return self._find_path_py(start, goal)
+
+        # Tiles can be edited in place, so resync; the native side skips the copy if nothing changed
+        self.sync_tiles()
+        path = self._pathfinder.find_path(start[0], start[1], goal[0], goal[1])
+        return [(x, y) for x, y in path.tolist()]
+
+    def flow_path(
+        self, start: Tuple[int, int], goal: Tuple[int, int]
+    ) -> List[Tuple[int, int]]:
+        """Path from start to a fixed goal, such as a tower's attack tile, read off a cached flow field.
+
+        Unlike find_path this does not resync the tiles; they are pushed by _set_tower_tiles.
+        """
+        if self._pathfinder is None:
+            return self.find_path(start, goal)
+
+        field = self._pathfinder.flow_field(goal[0], goal[1])
+        path = self._pathfinder.flow_path(field, start[0], start[1])
+        return [(x, y) for x, y in path.tolist()]
+
+    def _find_path_py(
+        self, start: Tuple[int, int], goal: Tuple[int, int]
+    ) -> List[Tuple[int, int]]:
+        """Pure Python A*, used when the bindings module is unavailable."""
         if self.tiles[start[1]][start[0]] in {1, 3, 4} or self.tiles[goal[1]][
             goal[0]
         ] in {1, 3, 4}:
@@ -243,13 +302,37 @@ class Arena:
     def add_unit(self, unit: IDUnit):
         self.units.append(unit)
 
-    def get_target(
+    def index_units(self, units: List[IDUnit]) -> None:
+        """Buckets the living units for get_target's nearest-enemy lookups."""
+        if self._spatial is None:
+            return
+
+        self._spatial.clear()
+        self._indexed_units = [u for u in units if u.inner.unit_data.hitpoints > 0]
+        for i, unit in enumerate(self._indexed_units):
+            self._spatial.insert(
+                i,
+                unit.inner.unit_data.x,
+                unit.inner.unit_data.y,
+                unit.inner.owner.value,
+                layer_bit(unit.inner.underlying.layer),
+            )
+
+    def _closest_enemy(
         self,
         current_pos: Tuple[int, int],
         target_owner: Owner,
         target_types: List[TargetType],
-    ) -> Optional[UnitTarget]:
-        """Determines the closest valid target based on owner and target types, prioritizing enemy units."""
+    ) -> Optional[IDUnit]:
+        if self._spatial is not None and self._indexed_units:
+            mask = 0
+            for layer in target_types:
+                mask |= layer_bit(layer)
+            found = self._spatial.nearest(
+                current_pos[0], current_pos[1], target_owner.value, mask
+            )
+            return self._indexed_units[found] if found != -1 else None
+
         enemy_units: List[IDUnit] = [
             unit
             for unit in self.units
@@ -257,12 +340,23 @@ class Arena:
             and unit.inner.underlying.layer in target_types
             and unit.inner.unit_data.hitpoints > 0
         ]
-        if enemy_units:
-            closest_enemy = min(
-                enemy_units,
-                key=lambda unit: abs(current_pos[0] - unit.inner.unit_data.x)
-                + abs(current_pos[1] - unit.inner.unit_data.y),
-            )
+        if not enemy_units:
+            return None
+        return min(
+            enemy_units,
+            key=lambda unit: abs(current_pos[0] - unit.inner.unit_data.x)
+            + abs(current_pos[1] - unit.inner.unit_data.y),
+        )
+
+    def get_target(
+        self,
+        current_pos: Tuple[int, int],
+        target_owner: Owner,
+        target_types: List[TargetType],
+    ) -> Optional[UnitTarget]:
+        """Determines the closest valid target based on owner and target types, prioritizing enemy units."""
+        closest_enemy = self._closest_enemy(current_pos, target_owner, target_types)
+        if closest_enemy:
             # path = self.find_path(
             #     current_pos,
             #     (closest_enemy.inner.unit_data.x, closest_enemy.inner.unit_data.y),
@@ -342,7 +436,7 @@ class Arena:
             key=lambda adj: abs(current_pos[0] - adj[0]) + abs(current_pos[1] - adj[1]),
         )
 
-        path = self.find_path(current_pos, best_adjacent_tile)
+        path = self.flow_path(current_pos, best_adjacent_tile)
 
         return UnitTarget(closest_target[3].value, closest_target[0], path)
 
@@ -388,6 +482,7 @@ class Arena:
     def tick(self, units: List[IDUnit]) -> List[IDUnit]:
         """Processes unit actions in the arena."""
         u = units.copy()
+        by_id = {_unit.id: _unit for _unit in u}
 
         for unit in u:
             if unit.inner.unit_data.current_target and unit.inner.underlying.range:
@@ -399,10 +494,10 @@ class Arena:
                         unit.inner.unit_data.current_target.unit_type
                         == UnitTargetType.TROOP
                     ):
-                        for _unit in u:
+                        _unit = by_id.get(unit.inner.unit_data.current_target.uuid)
+                        if _unit is not None:
                             if (
-                                _unit.id == unit.inner.unit_data.current_target.uuid
-                                and unit.inner.underlying.damage
+                                unit.inner.underlying.damage
                                 and unit.inner.underlying.attack_speed
                                 and _unit.inner.unit_data.hitpoints > 0
                             ):
@@ -447,6 +542,9 @@ class Arena:
         # self.towers = [tower for tower in self.towers if tower.current_hp > 0]
         # self._set_tower_tiles()
 
+        # After damage, so units killed this tick are no longer targetable
+        self.index_units(units)
+
         return units
 
     @classmethod
@@ -538,3 +636,18 @@ def test_no_valid_path():
 
     path = arena.find_path(start, goal)
     assert not path, "Path should be empty when no valid path exists"
+
+
+def test_flow_path_matches_search_cost():
+    """Flow field paths toward a tower should be as cheap as the A* path."""
+    arena = Arena()
+    tower = arena.towers[0]
+    goal = (tower.center_x, tower.center_y + 2)
+
+    def cost(path):
+        return sum(1 if arena.tiles[y][x] == 0 else 0.5 for x, y in path[1:])
+
+    for start in [(5, 25), (10, 20), (1, 1)]:
+        flow = arena.flow_path(start, goal)
+        assert flow[0] == start and flow[-1] == goal
+        assert cost(flow) <= cost(arena.find_path(start, goal))
@@ -11,12 +11,14 @@ from deck import Deck
 class LoginRequest:
     password_hash: str
     username: str
+    binary: bool = False  # The client can use the binary packet format
 
 
 @dataclass
 class LoginResponse:
     uuid: str
     username: str
+    binary: bool = False  # Both ends use the binary format from here on
 
 
 @dataclass
@@ -68,3 +70,5 @@ class UserMap:
 @dataclass
 class DataRequest:
     uuid: str
+    ack: int = 0  # Last STATE_DELTA sequence applied, 0 for a full state
+    deltas: bool = False  # The client can apply STATE_DELTA; full states otherwise
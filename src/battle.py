@@ -0,0 +1,326 @@
+from itertools import chain
+from typing import Dict, List, Optional
+
+from arena import Arena, layer_bit
+from card import CardType, MovementSpeed
+from unit import IDUnit, Owner, UnitTarget, UnitTargetType
+
+try:
+    from bindings import (
+        BattleSim,
+        BattleTarget,
+        MatchRecorder,
+        MatchReplay,
+        MatchScheduler,
+        TowerKind,
+    )
+except ImportError:  # Headless servers can run without the compiled extension
+    BattleSim = None
+    MatchRecorder = None
+    MatchReplay = None
+    MatchScheduler = None
+
+
+class NativeBattle:
+    """Runs a match's units on the native BattleSim and mirrors the results onto the Battle state.
+
+    The simulation owns hitpoints, positions, targets and cooldowns. The IDUnit objects are
+    only written back after each step so the state sent to clients keeps its shape.
+
+    With a record_path every deploy is appended to a replay file that MatchReplay can
+    re-simulate; call checkpoint after each step and close once the match ends.
+    """
+
+    def __init__(
+        self, arena: Arena, tick_rate: int, record_path: Optional[str] = None
+    ) -> None:
+        if BattleSim is None:
+            raise RuntimeError("bindings module is not available")
+
+        self.arena = arena
+        self.sim = BattleSim(arena.WIDTH, arena.HEIGHT, tick_rate)
+        self.sim.set_tiles(bytes(chain.from_iterable(arena.tiles)))
+        for tower in arena.towers:
+            self.sim.add_tower(
+                tower.center_x,
+                tower.center_y,
+                tower.owner.value,
+                (
+                    TowerKind.KING
+                    if tower.tower_type == UnitTargetType.KING_TOWER
+                    else TowerKind.PRINCESS
+                ),
+                tower.current_hp,
+            )
+        self._slots: Dict[int, IDUnit] = {}
+
+        self.recorder: Optional[MatchRecorder] = None
+        if record_path:
+            recorder = MatchRecorder()
+            if recorder.open(record_path, self.sim):
+                self.recorder = recorder
+
+    @classmethod
+    def available(cls) -> bool:
+        return BattleSim is not None
+
+    def spawn(self, unit: IDUnit) -> None:
+        """Adds a deployed unit. Cards from packets carry enum values as strings."""
+        card = unit.inner.underlying
+        targets = 0
+        for layer in card.targets:
+            targets |= layer_bit(layer)
+
+        spec = dict(
+            x=unit.inner.unit_data.x,
+            y=unit.inner.unit_data.y,
+            owner=unit.inner.owner.value,
+            hitpoints=unit.inner.unit_data.hitpoints,
+            damage=card.damage or 0,
+            range=card.range or 0.0,
+            attack_speed=card.attack_speed or 0.0,
+            move_speed=MovementSpeed.to_num(MovementSpeed(card.movement_speed).value),
+            layer=layer_bit(card.layer),
+            targets=targets,
+            mobile=CardType(card.card_type) == CardType.TROOP,
+        )
+        slot = self.sim.spawn(**spec)
+        if self.recorder:
+            self.recorder.deploy(self.sim.tick, card.name, **spec)
+        self._slots[slot] = unit
+
+    def step(self) -> None:
+        self.sim.step()
+
+    def checkpoint(self) -> None:
+        """Records the simulation's checksum every so often, to find desyncs on replay."""
+        if self.recorder:
+            self.recorder.checkpoint(self.sim)
+
+    def close(self) -> None:
+        """Writes the result to the replay file, if recording. Safe to call twice."""
+        if self.recorder:
+            self.recorder.finish(self.sim)
+            self.recorder = None
+
+    def sync(self, units: List[IDUnit]) -> None:
+        """Writes the last step back onto units (removing the dead) and the arena's towers.
+
+        units is rebuilt in place, so nothing else may append to it while this runs.
+        """
+        records = self.sim.units()
+        dead: List[IDUnit] = []
+
+        for slot, unit in list(self._slots.items()):
+            record = records[slot]
+            data = unit.inner.unit_data
+            data.x = int(record["x"])
+            data.y = int(record["y"])
+            data.hitpoints = int(record["hitpoints"])
+            data.current_target = self._target(record)
+
+            if not record["alive"]:
+                dead.append(unit)
+                del self._slots[slot]
+
+        if dead:
+            # By uuid rather than ==, which would compare every field of the dataclasses
+            dead_ids = {unit.id for unit in dead}
+            units[:] = [unit for unit in units if unit.id not in dead_ids]
+
+        for tower, hp in zip(self.arena.towers, self.sim.tower_hitpoints()):
+            tower.current_hp = int(hp)
+
+    def winner(self) -> Optional[Owner]:
+        side = self.sim.winner()
+        return Owner(side) if side != -1 else None
+
+    def _target(self, record) -> Optional[UnitTarget]:
+        kind = int(record["targetKind"])
+        index = int(record["target"])
+        if kind == BattleTarget.NONE.value:
+            return None
+
+        # Only the next step is kept; the full route lives in the simulation
+        path = [(int(record["x"]), int(record["y"]))]
+        if record["nextX"] != -1:
+            path.append((int(record["nextX"]), int(record["nextY"])))
+
+        if kind == BattleTarget.TROOP.value:
+            target = self._slots.get(index)
+            return UnitTarget(target.id, UnitTargetType.TROOP, path) if target else None
+
+        tower = self.arena.towers[index]
+        return UnitTarget(tower.tower_id.value, tower.tower_type, path)
+
+
+import dataclasses
+import random
+from datetime import datetime, timedelta
+from types import SimpleNamespace
+
+import pytest
+import arena as arena_module
+import card_tick as card_tick_module
+import util
+from card import GOBLIN_SHAMAN, LUMBERJACK_GOBLIN, ROCK_GOLEM, SKY_ARCHER
+from unit import Unit, UnitData
+from util import DATE_FORMAT
+
+native_battle = pytest.mark.skipif(
+    BattleSim is None, reason="needs BattleSim from the bindings extension"
+)
+
+
+def _deploy(battle: NativeBattle, card, owner: Owner, x: int, y: int) -> None:
+    data = UnitData(x, y, None, card.hitpoints or 0, "", "")
+    battle.spawn(IDUnit.from_unit(Unit(card, owner, data)))
+
+
+def _record(path: str, ticks: int) -> NativeBattle:
+    battle = NativeBattle(Arena(), 20, path)
+    _deploy(battle, ROCK_GOLEM, Owner.P1, 4, 9)
+    _deploy(battle, SKY_ARCHER, Owner.P2, 14, 20)
+    for tick in range(ticks):
+        if tick == ticks // 2:
+            _deploy(battle, SKY_ARCHER, Owner.P1, 9, 6)
+        battle.step()
+        battle.checkpoint()
+    battle.close()
+    return battle
+
+
+@native_battle
+def test_replay_round_trip(tmp_path):
+    path = str(tmp_path / "match.replay")
+    battle = _record(path, 450)
+
+    replay = MatchReplay()
+    assert replay.load(path) and replay.loaded
+    assert replay.cards == [ROCK_GOLEM.name, SKY_ARCHER.name]
+    assert len(replay.deploys()) == 3
+    assert replay.end_tick == battle.sim.tick
+    assert replay.first_divergence() == -1
+
+    replay.seek(battle.sim.tick)
+    assert list(replay.tower_hitpoints()) == list(battle.sim.tower_hitpoints())
+    assert replay.winner() == battle.sim.winner()
+
+
+@native_battle
+def test_replay_truncated_file(tmp_path):
+    path = str(tmp_path / "match.replay")
+    _record(path, 450)
+    with open(path, "rb") as file:
+        data = file.read()
+
+    cut = str(tmp_path / "cut.replay")
+    # Losing the end record keeps every deploy, but the result is unknown
+    with open(cut, "wb") as file:
+        file.write(data[:-1])
+    replay = MatchReplay()
+    assert replay.load(cut)
+    assert len(replay.deploys()) == 3 and replay.recorded_winner == -1
+    assert replay.first_divergence() == -1
+
+    # Without a whole header there's nothing to replay, and the previous load is gone
+    with open(cut, "wb") as file:
+        file.write(data[:10])
+    assert not replay.load(cut)
+    assert not replay.loaded and len(replay.deploys()) == 0
+    with pytest.raises(ValueError):
+        replay.units()
+    with pytest.raises(ValueError):
+        replay.seek(10)
+
+
+@native_battle
+def test_replay_needs_load():
+    replay = MatchReplay()
+    for call in (replay.units, replay.tower_hitpoints, replay.winner, replay.reset):
+        with pytest.raises(ValueError):
+            call()
+    with pytest.raises(ValueError):
+        replay.advance(1)
+
+
+class _Clock(datetime):
+    """datetime whose now() the parity test advances, so the Python cooldowns follow ticks."""
+
+    current = datetime(2024, 1, 1)
+
+    @classmethod
+    def now(cls, tz=None):
+        return cls.current
+
+
+def _as_sent(card):
+    """The card with its enums as the values deploy packets carry, which card_tick compares against."""
+    return dataclasses.replace(
+        card,
+        card_type=card.card_type.value,
+        layer=card.layer.value,
+        movement_speed=card.movement_speed.value,
+        targets=[target.value for target in card.targets],
+    )
+
+
+def _unit_state(unit: IDUnit):
+    data = unit.inner.unit_data
+    target = data.current_target
+    return (
+        unit.id,
+        data.x,
+        data.y,
+        data.hitpoints,
+        target.uuid if target else None,
+        target.path[1] if target and len(target.path) > 1 else None,
+    )
+
+
+@native_battle
+def test_native_matches_python_step(monkeypatch):
+    from matchmaking import MatchThread
+
+    # Whole seconds at one tick per second, so DATE_FORMAT's seconds don't round anything away
+    for module in (util, arena_module, card_tick_module):
+        monkeypatch.setattr(module, "datetime", _Clock)
+    monkeypatch.setattr(_Clock, "current", datetime(2024, 1, 1))
+
+    python_arena = Arena()
+    python = SimpleNamespace(arena=python_arena)
+    state = SimpleNamespace(units=[])
+    native = NativeBattle(Arena(), 1)
+    native_units: List[IDUnit] = []
+
+    rng = random.Random(1234)
+    cards = [_as_sent(c) for c in (GOBLIN_SHAMAN, LUMBERJACK_GOBLIN, ROCK_GOLEM, SKY_ARCHER)]
+    empty = [
+        (x, y)
+        for y in range(Arena.HEIGHT)
+        for x in range(Arena.WIDTH)
+        if python_arena.tiles[y][x] == 0
+    ]
+    for i in range(8):
+        card = rng.choice(cards)
+        owner = Owner.P1 if i % 2 == 0 else Owner.P2
+        x, y = rng.choice([tile for tile in empty if Arena.get_tile_owner(tile) == owner])
+        now = _Clock.now().strftime(DATE_FORMAT)
+        for units in (state.units, native_units):
+            data = UnitData(x, y, None, card.hitpoints, now, now)
+            units.append(IDUnit(Unit(card, owner, data), f"unit-{i}"))
+        python_arena.add_unit(state.units[-1])
+        native.spawn(native_units[-1])
+
+    for tick in range(120):
+        _Clock.current += timedelta(seconds=1)
+        MatchThread.python_step(python, state)
+        native.step()
+        native.sync(native_units)
+
+        assert [_unit_state(u) for u in native_units] == [
+            _unit_state(u) for u in state.units
+        ], f"diverged at tick {tick + 1}"
+        assert [t.current_hp for t in native.arena.towers] == [
+            t.current_hp for t in python_arena.towers
+        ], f"towers diverged at tick {tick + 1}"
@@ -35,6 +35,9 @@ from util import Pair, logger
 import uuid
 
 from bindings import (
+    AssetState,
+    CullMode,
+    MeshMode,
     SDL_KeyboardEvent,
     SDLWrapper,
     SDL_EventType,
@@ -44,6 +47,13 @@ from bindings import (
 
 from typing import List, Tuple
 
+# Event codes as plain ints, for matching records returned by SDLWrapper.poll_events
+EVENT_QUIT = int(SDL_EventType.QUIT)
+EVENT_KEYDOWN = int(SDL_EventType.KEYDOWN)
+EVENT_KEYUP = int(SDL_EventType.KEYUP)
+EVENT_MOUSEBUTTONDOWN = int(SDL_EventType.MOUSEBUTTONDOWN)
+EVENT_MOUSEBUTTONUP = int(SDL_EventType.MOUSEBUTTONUP)
+
 
 def intersects(p: Tuple[float, float], v: List[Tuple[float, float]]) -> bool:
     return (
@@ -72,6 +82,11 @@ T = TypeVar("T")
 
 
 class InternalEngine:
+    EVENT_BATCH = 64
+    # Render thread time per frame for turning background loads into textures,
+    # sprites and fonts
+    ASSET_UPLOAD_BUDGET_MS = 2.0
+
     def __init__(
         self,
         pipeline: FramePipeline[EngineFrameData],
@@ -80,11 +95,20 @@ class InternalEngine:
         window_title: str = "Game Engine",
         width: int = 800,
         height: int = 600,
+        target_fps: int = 60,
+        vsync: bool = False,
+        headless: bool = False,
     ):
         self.sdl = bindings.SDLWrapper(width, height, window_title)
-        self.sdl.initialize()
-        self.sdl.create_window()
-        self.sdl.create_renderer()
+        # Headless renders offscreen with no window or display server, e.g. for replays;
+        # frames come out through sdl.read_frame or sdl.save_frame_png
+        self.sdl.initialize(headless)
+        if headless:
+            self.sdl.create_headless_renderer()
+        else:
+            self.sdl.create_window()
+            self.sdl.create_renderer(bindings.RendererMode.ACCELERATED, vsync)
+        self.sdl.set_target_fps(target_fps)
         self.running = False
         self.game_objects: List[GameObject] = []
         self.camera: Optional[Union["Camera", "Camera3D"]] = None
@@ -94,6 +118,7 @@ class InternalEngine:
         self.states: Dict[
             str, Tuple[Callable[[], Optional[Any]], Callable[[Optional[Any]], None]]
         ] = {}
+        self.profile_trace_path: Optional[str] = None
 
     def event_loop(self) -> None:
         while True:
@@ -112,30 +137,63 @@ class InternalEngine:
         threading.Thread(
             target=lambda: self.run_with_delay(0, secondary), daemon=True
         ).start()
-        threading.Thread(
-            target=lambda: self.run_with_delay(0, lambda: self.handle_events()),
-            daemon=True,
-        ).start()
         while self.running:
+            # SDL only allows pumping events on the thread that made the window, and not
+            # alongside rendering, so events are drained here once per frame
+            self.handle_events()
+            self.sdl.upload_assets(self.ASSET_UPLOAD_BUDGET_MS)
             self.update()
             self.render()
-            self.sdl.delay(16)  # ~60 FPS
+            self.sdl.pace_frame()
+
+        # Only once the last frame is done, so the trace isn't written mid-render
+        if self.profile_trace_path is not None:
+            self.sdl.write_chrome_trace(self.profile_trace_path)
+        exit(0)
 
     def quit(self):
+        """Stops the main loop after the current frame, which then writes any trace and exits."""
         self.running = False
-        exit(0)
+
+    def start_profiling(self, trace_path: Optional[str] = None) -> None:
+        """
+        Records draw calls and frame timings for the last few hundred frames. With a
+        trace_path, every wrapper call is kept too and written there as a Chrome trace
+        on quit.
+        """
+        self.profile_trace_path = trace_path
+        self.sdl.set_profiling(True, trace_path is not None)
+
+    def profile_summary(self) -> Dict[str, float]:
+        """Averages over the profiled frames, in milliseconds and calls per frame."""
+        records = self.sdl.get_frame_records()
+        if len(records) == 0:
+            return {}
+        durations = records["duration"] * 1000.0
+        return {
+            "frames": float(len(records)),
+            "frame_ms": float(durations.mean()),
+            "frame_p95_ms": float(np.percentile(durations, 95)),
+            "sdl_ms": float(records["sdlSeconds"].mean() * 1000.0),
+            "present_ms": float(records["presentSeconds"].mean() * 1000.0),
+            "sleep_ms": float(records["sleepSeconds"].mean() * 1000.0),
+            "other_ms": float(records["otherSeconds"].mean() * 1000.0),
+            "color_changes": float(records["colorChanges"].mean()),
+            "texture_uploads": float(records["textureUploads"].mean()),
+            "text_rasters": float(records["textRasters"].mean()),
+        }
 
     def setup(self):
         # Override for initialization logic.
         pass
 
     def handle_events(self):
-        event = SDL_Event()
-        while self.sdl.poll_event(event):
-            if event.type == SDL_EventType.QUIT:
+        events = self.sdl.poll_events(self.EVENT_BATCH, 0)
+        for record in events:
+            if record["type"] == EVENT_QUIT:
                 self.quit()
-            elif event.type == SDL_EventType.KEYDOWN:
-                if event.key.keysym.scancode == SDL_Scancode.Escape:
+            elif record["type"] == EVENT_KEYDOWN:
+                if record["scancode"] == int(SDL_Scancode.Escape):
                     self.quit()
 
     def update(self):
@@ -531,6 +589,9 @@ class Mesh:
     ):
         self.vertices = np.array(vertices, dtype=float)
         self.indices = indices
+        # Contiguous copies in the layout SDLWrapper.draw_mesh consumes
+        self.vertex_buffer = np.ascontiguousarray(self.vertices, dtype=np.float32)
+        self.index_buffer = np.array(indices, dtype=np.int32).reshape(-1, 3)
 
 
 class MeshRenderer(Component):
@@ -540,18 +601,24 @@ class MeshRenderer(Component):
         color: Tuple[int, int, int] = (255, 255, 255),
         material: Optional["Material"] = None,
         rotation_offset: Tuple[float, float, float] = (0.0, 0.0, 0.0),
+        mode: MeshMode = MeshMode.WIREFRAME,
+        cull: CullMode = CullMode.NONE,
     ):
         """
         :param mesh: The mesh to render.
         :param color: The color to use for drawing (used if no material/shader is provided).
         :param material: Optional material information.
         :param rotation_offset: An extra (pitch, yaw, roll) rotation (in degrees) to be applied on top of the GameObject's Transform3D rotation.
+        :param mode: Draw triangle edges or filled triangles.
+        :param cull: Which faces to skip, by winding.
         """
         super().__init__()
         self.mesh = mesh
         self.color = color
         self.material = material
         self.rotation_offset = rotation_offset
+        self.mode = mode
+        self.cull = cull
 
     def render(self, sdl: SDLWrapper, camera: Optional[Union[Camera, Camera3D]] = None):
         if self.game_object is None:
@@ -635,24 +702,16 @@ class MeshRenderer(Component):
         S[2, 2] = transform3d.scale[2]
 
         model_matrix = T @ R @ S
-
-        for tri in self.mesh.indices:
-            pts = []
-            for idx in tri:
-                if idx >= len(self.mesh.vertices):
-                    continue
-                vertex = np.array([*self.mesh.vertices[idx], 1.0])
-                clip_space = proj_matrix @ view_matrix @ model_matrix @ vertex
-                if clip_space[3] == 0:
-                    continue
-                ndc = clip_space[:3] / clip_space[3]
-                x_screen = (ndc[0] + 1) / 2 * sdl.get_width()
-                y_screen = (1 - (ndc[1] + 1) / 2) * sdl.get_height()
-                pts.append((int(x_screen), int(y_screen)))
-            if len(pts) == 3:
-                sdl.draw_line(pts[0][0], pts[0][1], pts[1][0], pts[1][1], *self.color)
-                sdl.draw_line(pts[1][0], pts[1][1], pts[2][0], pts[2][1], *self.color)
-                sdl.draw_line(pts[2][0], pts[2][1], pts[0][0], pts[0][1], *self.color)
+        mvp = (proj_matrix @ view_matrix @ model_matrix).astype(np.float32)
+
+        sdl.draw_mesh(
+            self.mesh.vertex_buffer,
+            self.mesh.index_buffer,
+            mvp,
+            *self.color,
+            self.mode,
+            self.cull,
+        )
 
 
 # ---- Rigidbody (Simple Physics) ----
@@ -738,17 +797,80 @@ class Light(Component):
 
 
 # ---- ResourceManager ----
+class AssetRequest:
+    """A texture, sprite or font being loaded on the SDLWrapper loader thread.
+
+    The engine uploads finished loads at the start of each frame, so a request
+    becomes ready some frames after it is made; until then id is -1.
+    """
+
+    def __init__(self, sdl: SDLWrapper, handle: int):
+        self.sdl = sdl
+        self.handle = handle
+
+    @property
+    def state(self) -> AssetState:
+        return self.sdl.get_asset_state(self.handle)
+
+    @property
+    def ready(self) -> bool:
+        return self.state == AssetState.READY
+
+    @property
+    def failed(self) -> bool:
+        return self.state == AssetState.FAILED
+
+    @property
+    def id(self) -> int:
+        return self.sdl.get_asset_id(self.handle)
+
+
 class ResourceManager:
-    def __init__(self):
+    def __init__(self, sdl: Optional[SDLWrapper] = None):
+        self.sdl = sdl
         self.textures: Dict[str, Any] = {}
+        self.sprites: Dict[str, AssetRequest] = {}
+        self.fonts: Dict[str, AssetRequest] = {}
         self.models: Dict[str, Any] = {}
         self.sounds: Dict[str, Any] = {}
 
     def load_texture(self, name: str, filepath: str):
-        self.textures[name] = filepath
+        """Starts loading a texture in the background if there's a renderer."""
+        if self.sdl is None:
+            self.textures[name] = filepath
+        else:
+            self.textures[name] = AssetRequest(
+                self.sdl, self.sdl.load_texture_async(filepath)
+            )
 
     def get_texture(self, name: str):
-        return self.textures.get(name, None)
+        """The texture id once loaded, None while loading or if it failed."""
+        texture = self.textures.get(name, None)
+        if isinstance(texture, AssetRequest):
+            return texture.id if texture.ready else None
+        return texture
+
+    def load_sprite(self, name: str, filepath: str) -> AssetRequest:
+        assert self.sdl is not None, "Sprites need a ResourceManager with an SDLWrapper"
+        self.sprites[name] = AssetRequest(
+            self.sdl, self.sdl.load_sprite_async(filepath)
+        )
+        return self.sprites[name]
+
+    def get_sprite(self, name: str) -> Optional[int]:
+        sprite = self.sprites.get(name, None)
+        return sprite.id if sprite is not None and sprite.ready else None
+
+    def load_font(self, name: str, filepath: str, size: int) -> AssetRequest:
+        assert self.sdl is not None, "Fonts need a ResourceManager with an SDLWrapper"
+        self.fonts[name] = AssetRequest(
+            self.sdl, self.sdl.open_font_async(filepath, size)
+        )
+        return self.fonts[name]
+
+    def get_font(self, name: str) -> Optional[int]:
+        font = self.fonts.get(name, None)
+        return font.id if font is not None and font.ready else None
 
     def load_model(self, name: str, filepath: str):
         self.models[name] = filepath
@@ -801,31 +923,43 @@ class UIElement:
             anim.update(dt)
         self.animations = [anim for anim in self.animations if not anim.finished]
 
-    def render(self, sdl: SDLWrapper):
-        if self.visible:
+    def is_hovered(self, sdl: SDLWrapper) -> bool:
+        rect_x, rect_y, rect_w, rect_h = (
+            self.rect.x,
+            self.rect.y,
+            self.rect.w,
+            self.rect.h,
+        )
+        rect_vertices = [
+            (rect_x, rect_y),
+            (rect_x + rect_w, rect_y),
+            (rect_x + rect_w, rect_y + rect_h),
+            (rect_x, rect_y + rect_h),
+        ]
+        return intersects(sdl.getMousePosition(), rect_vertices)
 
-            mouse_pos = sdl.getMousePosition()
-            rect_x, rect_y, rect_w, rect_h = (
-                self.rect.x,
-                self.rect.y,
-                self.rect.w,
-                self.rect.h,
-            )
+    def current_color(self, sdl: SDLWrapper) -> Tuple[int, int, int]:
+        return self.on_hover if self.on_hover and self.is_hovered(sdl) else self.color
 
-            rect_vertices = [
-                (rect_x, rect_y),
-                (rect_x + rect_w, rect_y),
-                (rect_x + rect_w, rect_y + rect_h),
-                (rect_x, rect_y + rect_h),
-            ]
+    def bounds(self) -> Tuple[int, int, int, int]:
+        """Screen area the element draws into, as (x, y, w, h)."""
+        return int(self.rect.x), int(self.rect.y), int(self.rect.w), int(self.rect.h)
 
-            r, g, b = (
-                self.on_hover
-                if intersects(mouse_pos, rect_vertices) and self.on_hover
-                else self.color
-            )
+    def signature(self, sdl: SDLWrapper) -> Tuple[Any, ...]:
+        """Everything besides bounds() that changes how the element looks."""
+        return (self.current_color(sdl),)
+
+    def track(self, sdl: SDLWrapper) -> None:
+        """Tells a partial redraw what the element looks like this frame."""
+        if self.visible:
+            sdl.track(self, self.signature(sdl), *self.bounds())
 
-            sdl.draw_rect(int(rect_x), int(rect_y), rect_w, rect_h, r, g, b)
+    def render(self, sdl: SDLWrapper):
+        if self.visible:
+            r, g, b = self.current_color(sdl)
+            sdl.draw_rect(
+                int(self.rect.x), int(self.rect.y), self.rect.w, self.rect.h, r, g, b
+            )
 
     def add_animation(self, animation: "UIAnimation"):
         self.animations.append(animation)
@@ -900,38 +1034,45 @@ class UIButton(UIElement):
         self.text_color = text_color
         self.font_size = font_size
 
+    def current_color(self, sdl: SDLWrapper) -> Tuple[int, int, int]:
+        return self.on_hover if self.is_hovered(sdl) else self.color
+
+    def text_rect(self) -> Tuple[int, int, int, int]:
+        """Where the centred text goes, as (x, y, w, h)."""
+        text_width = self.text_renderer.get_text_width(self.text)
+        text_height = self.text_renderer.get_font_height(self.text)
+        text_x = self.rect.x + (self.rect.w - text_width) // 2
+        text_y = self.rect.y + (self.rect.h - text_height) // 2
+        return text_x, text_y, text_width, text_height
+
+    def bounds(self) -> Tuple[int, int, int, int]:
+        # Text wider than the button spills over its sides
+        x, y, w, h = super().bounds()
+        text_x, text_y, text_w, text_h = self.text_rect()
+        left, top = min(x, text_x), min(y, text_y)
+        right, bottom = max(x + w, text_x + text_w), max(y + h, text_y + text_h)
+        return int(left), int(top), int(right - left), int(bottom - top)
+
+    def signature(self, sdl: SDLWrapper) -> Tuple[Any, ...]:
+        return (
+            self.current_color(sdl),
+            self.text,
+            self.text_color,
+            self.text_renderer.font_id,
+        )
+
     def render(self, sdl: SDLWrapper):
         """Renders the button and its text."""
         if not self.visible:
             return
 
-        # Determine button color (hover effect)
-        mouse_pos = sdl.getMousePosition()
-        rect_x, rect_y, rect_w, rect_h = (
-            self.rect.x,
-            self.rect.y,
-            self.rect.w,
-            self.rect.h,
-        )
-        rect_vertices = [
-            (rect_x, rect_y),
-            (rect_x + rect_w, rect_y),
-            (rect_x + rect_w, rect_y + rect_h),
-            (rect_x, rect_y + rect_h),
-        ]
-        r, g, b = self.on_hover if intersects(mouse_pos, rect_vertices) else self.color
-
-        # Draw button rectangle
-        sdl.fill_rect(rect_x, rect_y, rect_w, rect_h, r, g, b)
+        # Draw button rectangle, in the hover colour under the mouse
+        r, g, b = self.current_color(sdl)
+        sdl.fill_rect(self.rect.x, self.rect.y, self.rect.w, self.rect.h, r, g, b)
 
         # Draw text centered in the button
-        text_width = self.text_renderer.get_text_width(self.text)
-        text_height = self.text_renderer.get_font_height(self.text)
-
-        text_x = rect_x + (rect_w - text_width) // 2
-        text_y = rect_y + (rect_h - text_height) // 2
-
-        self.text_renderer.draw_text(self.text, text_x, text_y, self.text_color)
+        text_x, text_y, _, _ = self.text_rect()
+        self.text_renderer.draw_label(self.text, text_x, text_y, self.text_color)
 
     def check_click(self, mouse_pos: Tuple[int, int]):
         """Checks if the button was clicked."""
@@ -954,9 +1095,15 @@ class UIManager:
         for element in self.ui_elements:
             element.update(dt, sdl)
 
+    def track(self, sdl: SDLWrapper):
+        for element in self.ui_elements:
+            element.track(sdl)
+
     def render(self, sdl: SDLWrapper):
         for element in self.ui_elements:
-            element.render(sdl)
+            # Outside a partial redraw's damage the last frame's pixels are still right
+            if sdl.is_dirty(*element.bounds()):
+                element.render(sdl)
 
     def handle_mouse_click(self, mouse_pos: Tuple[int, int]):
         """Handles mouse clicks and checks if any UI button was clicked."""
@@ -982,33 +1129,45 @@ class Engine(InternalEngine):
         window_title="Full Game Engine",
         width=1024,
         height=768,
+        target_fps=60,
+        vsync=False,
+        headless=False,
     ):
         super().__init__(
-            pipeline, event_pipeline, state_pipeline, window_title, width, height
+            pipeline,
+            event_pipeline,
+            state_pipeline,
+            window_title,
+            width,
+            height,
+            target_fps,
+            vsync,
+            headless,
         )
         self.scene_manager = SceneManager(self.sdl)
         self.input_manager = InputManager()
         self.ui_manager = UIManager()
         self.audio_manager = AudioManager()
-        self.resource_manager = ResourceManager()
+        self.resource_manager = ResourceManager(self.sdl)
         self.last_time = time.time()
         self.input_manager.register_key_down(SDL_Scancode.Escape, self.quit)
 
     def handle_events(self):
-        event = SDL_Event()
-        while self.sdl.poll_event(event):
-            if event.type == SDL_EventType.QUIT:
+        events = self.sdl.poll_events(self.EVENT_BATCH, 0)
+        if len(events) == 0:
+            return
+
+        focused = self.sdl.is_window_focused()
+        ui_manager = (
+            self.ui_manager
+            if self.scene_manager.current_scene is None
+            else self.scene_manager.current_scene.ui_manager
+        )
+        for record in events:
+            if record["type"] == EVENT_QUIT:
                 self.quit()
-            else:
-                if self.sdl.is_window_focused():
-                    self.input_manager.process_event(
-                        event,
-                        (
-                            self.ui_manager
-                            if self.scene_manager.current_scene is None
-                            else self.scene_manager.current_scene.ui_manager
-                        ),
-                    )
+            elif focused:
+                self.input_manager.process_record(record, ui_manager)
 
     def update(self):
         current_time = time.time()
@@ -1026,7 +1185,24 @@ class Engine(InternalEngine):
     def override_render(self) -> None:
         pass
 
+    def override_track(self) -> None:
+        """Tracks whatever override_render draws, for scenes with partial redraw."""
+        pass
+
     def render(self, override: bool = False):
+        # Switched here rather than in load_scene, which may run on another thread
+        scene = self.scene_manager.current_scene
+        partial = scene is not None and scene.partial_redraw
+        if partial != self.sdl.is_partial_redraw():
+            self.sdl.set_partial_redraw(partial)
+
+        if self.sdl.is_partial_redraw():
+            scene.track(self.sdl)
+            self.ui_manager.track(self.sdl)
+            self.override_track()
+            if not self.sdl.begin_frame():
+                return  # Nothing changed, so the last frame stays on screen
+
         if not override:
             self.sdl.clear_screen(0, 0, 0)
         if self.scene_manager.current_scene:
@@ -1043,11 +1219,17 @@ class Engine(InternalEngine):
 
 # ---- Scene Management ----
 class Scene:
-    def __init__(self, name: str):
+    def __init__(self, name: str, partial_redraw: bool = False):
+        """
+        :param partial_redraw: Only redraw what changed since the last frame. Meant
+            for mostly static scenes like menus: anything drawn outside the UI
+            elements has to be tracked (see Engine.override_track).
+        """
         self.name = name
         self.game_objects: List[GameObject] = []
         self.ui_manager: UIManager = UIManager()
         self.ambient_light = (50, 50, 50)
+        self.partial_redraw = partial_redraw
 
     def add_game_object(self, game_object: GameObject):
         self.game_objects.append(game_object)
@@ -1065,11 +1247,16 @@ class Scene:
         for ui in self.ui_manager.ui_elements:
             ui.update(1 / 60.0, sdl)
 
+    def track(self, sdl: bindings.SDLWrapper):
+        # Game objects draw whatever they like, so a scene with any is redrawn in full
+        if self.game_objects:
+            sdl.invalidate_all()
+        self.ui_manager.track(sdl)
+
     def render(self, sdl: bindings.SDLWrapper, camera: Union[Camera, Camera3D]):
         for obj in self.game_objects:
             obj.render(sdl, camera)
-        for ui in self.ui_manager.ui_elements:
-            ui.render(sdl)
+        self.ui_manager.render(sdl)
 
 
 class SceneManager:
@@ -1143,26 +1330,82 @@ class InputManager:
             if button in self.mouse_up_callbacks:
                 self.mouse_up_callbacks[button]()
 
+    def process_record(self, record: np.void, ui_manager: "UIManager"):
+        """Same as process_event, for one record of SDLWrapper.poll_events."""
+        event_type = int(record["type"])
+        if event_type == EVENT_KEYDOWN:
+            key = SDL_Scancode(int(record["scancode"]))
+            if key in self.key_down_callbacks:
+                self.key_down_callbacks[key]()
+
+        elif event_type == EVENT_KEYUP:
+            key = SDL_Scancode(int(record["scancode"]))
+            if key in self.key_up_callbacks:
+                self.key_up_callbacks[key]()
+
+        elif event_type == EVENT_MOUSEBUTTONDOWN:
+            button = int(record["button"])
+            mouse_pos = (int(record["x"]), int(record["y"]))
+            for btn, callback in self.mouse_down_callbacks:
+                if btn == button:
+                    callback(mouse_pos)
+
+            # Pass event to UI Manager for button clicks
+            ui_manager.handle_mouse_click(mouse_pos)
+
+        elif event_type == EVENT_MOUSEBUTTONUP:
+            button = int(record["button"])
+            if button in self.mouse_up_callbacks:
+                self.mouse_up_callbacks[button]()
+
+
+class Framebuffer:
+    """A streaming texture whose pixels are composed in NumPy and drawn with one copy."""
+
+    def __init__(self, sdl: SDLWrapper, width: int, height: int):
+        self.sdl = sdl
+        self.width = width
+        self.height = height
+        self.id = sdl.create_framebuffer(width, height)
+        if self.id < 0:
+            raise RuntimeError(f"Unable to create {width}x{height} framebuffer")
+
+    def lock(self) -> np.ndarray:
+        """Returns a writable (height, width, 4) RGBA view of the texture.
+
+        The previous contents are not preserved. Delete the view, and any slices of it, before
+        draw(), unlock(), free() or the next lock(): they raise BufferError while one is alive,
+        since SDL may move or free the pixels once the texture is unlocked."""
+        return self.sdl.lock_framebuffer(self.id)
+
+    def unlock(self) -> None:
+        self.sdl.unlock_framebuffer(self.id)
+
+    def draw(self, x: int = 0, y: int = 0) -> None:
+        self.sdl.draw_framebuffer(self.id, x, y)
+
+    def free(self) -> None:
+        self.sdl.free_framebuffer(self.id)
+        self.id = -1
+
 
 class TextRenderer:
     def __init__(self, sdl: SDLWrapper):
         self.sdl = sdl
-        self.font = None  # Store the loaded font
+        self.font_id = -1  # Id of the current font in the SDLWrapper font registry
         self.font_path = ""
 
     def load_font(self, path: str, size: int):
         """Loads a font. Returns True on success, False on failure."""
-        self.font = self.sdl.load_font(path, size)
+        self.font_id = self.sdl.open_font(path, size)
         self.font_path = path
-        return self.font
+        return self.font_id >= 0
 
     def set_font_size(self, size: int):
-        """Sets the font size.  Reloads the font if necessary."""
-        if self.font:
+        """Sets the font size. Fonts stay open, so switching back to a size is free."""
+        if self.font_id >= 0:
             if self.font_path != "":
-                if self.load_font(self.font_path, size):  # Reload with new size
-                    pass
-                else:
+                if not self.load_font(self.font_path, size):
                     print(f"Error changing font size to {size}")
             else:
                 print("Error: Could not retrieve font path to resize.")
@@ -1171,23 +1414,41 @@ class TextRenderer:
 
     def draw_text(self, text: str, x: int, y: int, color: Tuple[int, int, int]):
         """Draws text. Accepts RGB tuple."""
-        if not self.font:
+        if self.font_id < 0:
             print("Error: No font loaded. Call load_font() first.")
             return
 
         r, g, b = color  # No need for isinstance check as only RGB tuple is accepted.
-        self.sdl.draw_text(text, x, y, r, g, b)
+        self.sdl.draw_text(self.font_id, text, x, y, r, g, b)
+
+    def track_text(
+        self, key: Any, text: str, x: int, y: int, color: Tuple[int, int, int]
+    ):
+        """Tells a partial redraw about text drawn outside any UI element."""
+        if self.font_id < 0:
+            return
+        size = self.sdl.get_text_size(self.font_id, text)
+        self.sdl.track(key, (text, color, self.font_id), x, y, size.w, size.h)
+
+    def draw_label(self, text: str, x: int, y: int, color: Tuple[int, int, int]):
+        """Draws text that rarely changes from a cached texture. Accepts RGB tuple."""
+        if self.font_id < 0:
+            print("Error: No font loaded. Call load_font() first.")
+            return
+
+        r, g, b = color
+        self.sdl.draw_label(self.font_id, text, x, y, r, g, b)
 
     def get_text_width(self, text: str) -> int:
         """Returns the width of the given text in pixels."""
-        if not self.font:
+        if self.font_id < 0:
             print("Error: No font loaded. Call load_font() first.")
             return 0
-        return self.sdl.get_text_size(text).w
+        return self.sdl.get_text_size(self.font_id, text).w
 
     def get_font_height(self, text) -> int:
         """Returns the height of the current font in pixels."""
-        if not self.font:
+        if self.font_id < 0:
             print("Error: No font loaded. Call load_font() first.")
             return 0
-        return self.sdl.get_text_size(text).h
+        return self.sdl.get_text_size(self.font_id, text).h
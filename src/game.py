@@ -9,23 +9,32 @@ from socket import socket
 from threading import Lock
 from time import time
 from types import SimpleNamespace
-from typing import Callable, Deque, Dict, List, Optional, Tuple
+from typing import Any, Callable, Deque, Dict, List, Optional, Tuple
+from weakref import WeakKeyDictionary
 
+import numpy as np
 from numpy import average
 from copy import copy
 from arena import Arena
 from auth import DataRequest, LoginRequest, LoginResponse, ServerUserData, User, UserMap
 from deck import Deck
 from game_packet import MatchFound, MatchRequest, PacketType
-from matchmaking import Matchmaking, UnitDeployRequest
+from matchmaking import MatchEndData, Matchmaking, UnitDeployRequest
 from network import (
+    CODEC,
+    CODEC_ERRORS,
     Client,
     NetworkObject,
     Packet,
     Server,
     ServerStatus,
+    agree_binary,
+    binary_peer,
+    delta_decoder,
+    delta_encoder,
     deserialize_object,
     do_if,
+    register_packet,
     serialize_object,
 )
 from inspect import getsourcefile
@@ -67,6 +76,11 @@ from engine import Engine
 from unit import Owner
 from util import json_to_dataclass, logger
 
+try:
+    from bindings import TileLayer
+except ImportError:  # Tests and tools can run without the compiled extension
+    TileLayer = None
+
 
 @dataclass
 class BattleState:
@@ -120,6 +134,21 @@ class GameState:
     menu_state: Optional[MenuState]
 
 
+# Payloads built with Packet.from_struct go out in the binary format once both ends agree
+# to it at LOGIN, and as JSON until then or if either end lacks the extension
+for packet_type, root in (
+    (PacketType.LOGIN, LoginRequest),
+    (PacketType.LOGIN_SUCCESS, LoginResponse),
+    (PacketType.CLIENT_SERVER_SYNC, DataRequest),
+    (PacketType.SERVER_CLIENT_SYNC, GameState),
+    (PacketType.MATCH_REQUEST, MatchRequest),
+    (PacketType.MATCH_FOUND, MatchFound),
+    (PacketType.MATCH_END, MatchEndData),
+    (PacketType.DEPLOY_UNIT, UnitDeployRequest),
+):
+    register_packet(packet_type, root)
+
+
 class BattleClient:
     def __init__(self, send: Callable[[Packet], None]) -> None:
         self.battle_state: Optional[BattleState] = None
@@ -155,6 +184,8 @@ class GameNetworkClient(Client):
         self.auth_state: AuthState = AuthState(False, None, False, None)
         self.name = name
         self.side: Optional[str] = None
+        # Applies STATE_DELTA payloads; None keeps to full SERVER_CLIENT_SYNC states
+        self.deltas = delta_decoder(PacketType.SERVER_CLIENT_SYNC)
 
         self.on_finish = on_finish
 
@@ -172,14 +203,20 @@ class GameNetworkClient(Client):
             self.auth_state.requested = True
             self.send(
                 Packet.from_struct(
-                    PacketType.LOGIN, LoginRequest(str(self.name), str(self.name))
+                    PacketType.LOGIN,
+                    LoginRequest(str(self.name), str(self.name), CODEC is not None),
                 )
             )
 
         if self.auth_state.uuid:
             self.send(
                 Packet.from_struct(
-                    PacketType.CLIENT_SERVER_SYNC, DataRequest(self.auth_state.uuid)
+                    PacketType.CLIENT_SERVER_SYNC,
+                    DataRequest(
+                        self.auth_state.uuid,
+                        self.deltas.last_sequence if self.deltas else 0,
+                        self.deltas is not None,
+                    ),
                 )
             )
 
@@ -187,12 +224,10 @@ class GameNetworkClient(Client):
         # print(f"{self.name}: {self.state.battle_state.elixir}")
 
     #
-    def tick_state(self, data: bytes) -> None:
+    def tick_state(self, packet: Packet) -> None:
         with self.state_lock:
             try:
-                self.state = json.loads(
-                    data.decode(), object_hook=lambda d: SimpleNamespace(**d)
-                )
+                self.state = packet.to_struct()
             except Exception as e:
                 logger.error(f"Server Connection Error: {e}")
                 # print("e")
@@ -203,9 +238,22 @@ class GameNetworkClient(Client):
 
             self.battle_client.tick(self.state)
 
+    def tick_delta(self, packet: Packet) -> None:
+        if self.deltas is None:
+            return
+        with self.state_lock:
+            try:
+                self.state = self.deltas.apply(packet.data)
+            except CODEC_ERRORS as e:
+                # Acking 0 from now on gets a full state back
+                logger.warning(f"Dropped state delta: {e}")
+                self.deltas.reset()
+
+            self.battle_client.tick(self.state)
+
     def update_status(self, data: bytes) -> None:
         with self.status_lock:
-            self.status = ServerStatus(**json.loads(data.decode()))
+            self.status = ServerStatus(**json.loads(str(data, "utf-8")))
         with self.connection_status_lock:
             self.connection_status.last_connection = datetime.datetime.now()
 
@@ -217,7 +265,8 @@ class GameNetworkClient(Client):
                 self.connection_status = ConnectionStatus(None, False)
 
     def login_success(self, data: Packet):
-        decoded: LoginResponse = LoginResponse(**json.loads(data.data.decode()))
+        decoded: LoginResponse = LoginResponse(**vars(data.to_struct()))
+        self.binary = bool(decoded.binary) and CODEC is not None
         self.auth_state = AuthState(True, decoded.username, False, decoded.uuid)
 
     def login_fail(self, data: Packet):
@@ -236,13 +285,14 @@ class GameNetworkClient(Client):
         do_if(packet, PacketType.LOGIN_FAIL, lambda: self.login_fail(packet))
 
         do_if(
-            packet, PacketType.SERVER_CLIENT_SYNC, lambda: self.tick_state(packet.data)
+            packet, PacketType.SERVER_CLIENT_SYNC, lambda: self.tick_state(packet)
         )
+        do_if(packet, PacketType.STATE_DELTA, lambda: self.tick_delta(packet))
         do_if(packet, PacketType.MATCH_FOUND, lambda: self.found_match(packet))
         do_if(packet, PacketType.MATCH_END, lambda: self.on_finish() if self.on_finish is not None else None)
 
     def found_match(self, packet: Packet):
-        m: MatchFound = MatchFound(**json.loads(packet.data.decode()))
+        m: MatchFound = MatchFound(**vars(packet.to_struct()))
 
         self.side = m.p
 
@@ -327,16 +377,20 @@ class NetworkStateObject(NetworkObject):
         )
         self.shop = shop_default()
         self.matchmaking = Matchmaking()
+        # One DeltaEncoder per connection, dropped with its socket
+        self.deltas: "WeakKeyDictionary[socket, Any]" = WeakKeyDictionary()
 
     def handle_packet(self, packet: Packet, client_sock: socket) -> None:
         if packet.packet_type == PacketType.LOGIN:
-            data = LoginRequest(**json.loads(packet.data.decode()))
+            data = LoginRequest(**vars(packet.to_struct()))
             found = self.users.find(data.username, data.password_hash)
             if found is not None:
+                # Sent as JSON, since the client only learns the agreement from it
+                binary = agree_binary(client_sock, bool(data.binary))
                 client_sock.sendall(
                     Packet.from_struct(
                         PacketType.LOGIN_SUCCESS,
-                        LoginResponse(found.uuid, found.username),
+                        LoginResponse(found.uuid, found.username, binary),
                     ).serialize_with_length()
                 )
             else:
@@ -344,7 +398,7 @@ class NetworkStateObject(NetworkObject):
                     Packet(PacketType.LOGIN_FAIL).serialize_with_length()
                 )
         elif packet.packet_type == PacketType.CLIENT_SERVER_SYNC:
-            data = DataRequest(**json.loads(packet.data.decode()))
+            data = DataRequest(**vars(packet.to_struct()))
             found = self.users.find_uuid(data.uuid)
             if found is not None:
                 state = GameState(None, None)
@@ -373,25 +427,43 @@ class NetworkStateObject(NetworkObject):
                         )
 
                 client_sock.sendall(
-                    Packet.from_struct(
-                        PacketType.SERVER_CLIENT_SYNC, state
-                    ).serialize_with_length()
+                    self.sync_packet(
+                        client_sock, state, data.ack, data.deltas
+                    ).serialize_with_length(binary_peer(client_sock))
                 )
         elif packet.packet_type == PacketType.MATCH_REQUEST:
-            data = json.loads(
-                packet.data.decode(), object_hook=lambda d: SimpleNamespace(**d)
-            )
+            data = packet.to_struct()
 
             self.matchmaking.request(data, client_sock)
         elif packet.packet_type == PacketType.DEPLOY_UNIT:
-            data = json.loads(
-                packet.data.decode(), object_hook=lambda d: SimpleNamespace(**d)
-            )
+            data = packet.to_struct()
 
             self.matchmaking.deploy_unit(data, data.battle_id)
         elif packet.packet_type == PacketType.SHOP_PURCHASE:
             pass
 
+    def sync_packet(
+        self, client_sock: socket, state: GameState, ack: int, deltas: bool
+    ) -> Packet:
+        """The state as a delta against what the client last acked, or in full if it can't be.
+
+        Clients that don't say they can apply deltas always get the full state.
+        """
+        if not deltas:
+            return Packet.from_struct(PacketType.SERVER_CLIENT_SYNC, state)
+        encoder = self.deltas.get(client_sock)
+        if encoder is None:
+            encoder = delta_encoder(PacketType.SERVER_CLIENT_SYNC)
+            if encoder is None:
+                return Packet.from_struct(PacketType.SERVER_CLIENT_SYNC, state)
+            self.deltas[client_sock] = encoder
+
+        try:
+            return Packet(PacketType.STATE_DELTA, encoder.encode(state, ack))
+        except CODEC_ERRORS as e:
+            logger.warning(f"Sending full state: {e}")
+            return Packet.from_struct(PacketType.SERVER_CLIENT_SYNC, state)
+
     def tick(self):
         self.matchmaking.tick(
             lambda user_id, battle_id: self.users.update_battle(user_id, battle_id), self.users.update_trophies
@@ -410,6 +482,19 @@ class Game(Engine):
     HAND_INITIAL_COLOR = (99, 99, 99)
     HAND_SELECTED_COLOR = (255, 79, 79)
 
+    # Indexed by tile type; anything unknown falls through to black
+    TILE_COLORS = np.array(
+        [
+            (99, 99, 99),  # EMPTY
+            (0, 100, 255),  # RIVER
+            (139, 69, 20),  # BRIDGE
+            (255, 0, 0),  # CROWN_TOWER
+            (255, 215, 0),  # KING_TOWER
+            (0, 0, 0),  # UNKNOWN
+        ],
+        dtype=np.int32,
+    )
+
     def __init__(self, name: str, ip: Optional[str] = None):
         engine_pipe = FramePipeline[EngineFrameData]("engine_pipe")
         event_pipe = FramePipeline[Event]("event_pipe")
@@ -433,13 +518,17 @@ class Game(Engine):
         self.ui_buttons = []
 
         # Register scenes
-        self.main_menu_scene = Scene("main_menu")
+        # Menus are mostly static, so they only redraw what changed
+        self.main_menu_scene = Scene("main_menu", partial_redraw=True)
         self.battle_scene = Scene("battle")
 
         self.selected_card: Optional[Card] = None
 
         self.chest_buttons: List[UIButton] = []
 
+        # Retained arena grid, created on the first battle frame
+        self.arena_layer: Optional[Any] = None
+
     def stop_matchmaking(self) -> None:
         self.matchmaking_started = False
 
@@ -623,7 +712,7 @@ class Game(Engine):
 
     def setup_shop_scene(self):
         """Creates the improved Clash Royale styled shop UI scene."""
-        self.shop_scene = Scene("shop")
+        self.shop_scene = Scene("shop", partial_redraw=True)
 
         # Background
         self.shop_bg = UIElement(
@@ -680,7 +769,7 @@ class Game(Engine):
 
     def setup_deck_management_scene(self):
         """Creates the Clash Royale styled deck management UI scene."""
-        self.deck_management_scene = Scene("deck_management")
+        self.deck_management_scene = Scene("deck_management", partial_redraw=True)
 
         # Background
         self.deck_bg = UIElement(
@@ -807,17 +896,37 @@ class Game(Engine):
                 self.matchmaking_started = False
                 print(f"[Matchmaking, {self.name}] Unable to start matchmaking.")
 
+    def latency_text(self) -> str:
+        return f"Latency: {int(average(self.latency))}ms"
+
+    def trophies_text(self, menu_state) -> str:
+        return f"Trophies: {menu_state.trophies}"
+
+    def override_track(self):
+        """Tracks the text override_render draws outside UI elements in the menus."""
+        self.text_renderer.track_text(
+            "latency", self.latency_text(), 20, 20, self.get_latency_color()
+        )
+        if self.scene_manager.current_scene == self.main_menu_scene:
+            if self.client.state and self.client.state.menu_state:
+                self.text_renderer.track_text(
+                    "trophies",
+                    self.trophies_text(self.client.state.menu_state),
+                    60,
+                    190,
+                    (255, 255, 0),
+                )
+
     def override_render(self):
         """Handles UI text rendering, including latency, player stats, and battle info."""
         latency_color = self.get_latency_color()
-        latency_text = f"Latency: {int(average(self.latency))}ms"
-        self.text_renderer.draw_text(latency_text, 20, 20, latency_color)
+        self.text_renderer.draw_text(self.latency_text(), 20, 20, latency_color)
 
         # If in menu, show player info
         if self.scene_manager.current_scene == self.main_menu_scene:
             if self.client.state and self.client.state.menu_state:
-                trophies_text = f"Trophies: {self.client.state.menu_state.trophies}"
-                self.text_renderer.draw_text(trophies_text, 60, 190, (255, 255, 0))
+                trophies_text = self.trophies_text(self.client.state.menu_state)
+                self.text_renderer.draw_label(trophies_text, 60, 190, (255, 255, 0))
 
                 for i, button in enumerate(self.chest_buttons):
                     if len(self.client.state.menu_state.chests) > i:
@@ -830,8 +939,8 @@ class Game(Engine):
         elif self.scene_manager.current_scene == self.battle_scene:
             if self.client.state and self.client.state.battle_state:
                 elixir_text = f"Elixir: {self.client.state.battle_state.elixir}"
-                self.text_renderer.draw_text(elixir_text, 20, 80, (0, 255, 255))
-                self.text_renderer.draw_text(
+                self.text_renderer.draw_label(elixir_text, 20, 80, (0, 255, 255))
+                self.text_renderer.draw_label(
                     f"{self.client.side}", 20, 140, (255, 255, 255)
                 )
 
@@ -849,236 +958,149 @@ class Game(Engine):
 
                 # Draw arena grid
                 if self.client.state.battle_state.arena:  # PLAYER 2 IS FURTHEST
-                    arena = self.client.state.battle_state.arena
-                    cell_size = 20  # Adjust as needed
-                    offset_x = int(
-                        (self.sdl.get_width() / 2) - ((cell_size * Arena.WIDTH) / 2)
+                    self.render_arena(self.client.state.battle_state.arena)
+
+    def render_arena(self, arena) -> None:
+        """Draws the arena grid, towers and units through the batched draw API."""
+        cell_size = 20  # Adjust as needed
+        offset_x = int((self.sdl.get_width() / 2) - ((cell_size * Arena.WIDTH) / 2))
+        offset_y = int(380 - ((cell_size * Arena.HEIGHT) / 2))
+
+        tiles = np.array(arena.tiles, dtype=np.int32)
+
+        # Dead towers are drawn as empty ground
+        for tower in arena.towers:
+            if tower.current_hp <= 0:
+                tiles[
+                    tower.center_y - 1 : tower.center_y + 2,
+                    tower.center_x - 1 : tower.center_x + 2,
+                ] = 0
+
+        # Darken every row that isn't on the player's side of the river
+        dim = np.ones(Arena.HEIGHT, dtype=bool)
+        if self.client.side == "Player 1":
+            dim[: Arena.HEIGHT // 2 - 1] = False
+        elif self.client.side == "Player 2":
+            dim[Arena.HEIGHT // 2 + 1 :] = False
+
+        if TileLayer is not None:
+            # Only cells whose tile or shade changed since the last frame are redrawn
+            if self.arena_layer is None:
+                self.arena_layer = TileLayer(
+                    self.sdl, Arena.WIDTH, Arena.HEIGHT, cell_size
+                )
+                self.arena_layer.set_palette(self.TILE_COLORS)
+            self.arena_layer.set_tiles(tiles)
+            self.arena_layer.set_row_shades(np.where(dim, 20, 0).astype(np.int32))
+            self.arena_layer.draw(offset_x, offset_y)
+            self.sdl.begin_batch()
+        else:
+            colors = self.TILE_COLORS[np.clip(tiles, 0, len(self.TILE_COLORS) - 1)]
+            colors[dim] = np.maximum(colors[dim] - 20, 0)
+
+            ys, xs = np.mgrid[0 : Arena.HEIGHT, 0 : Arena.WIDTH]
+            tile_rows = np.empty((Arena.HEIGHT * Arena.WIDTH, 7), dtype=np.int32)
+            tile_rows[:, 0] = (offset_x + xs * cell_size).ravel()
+            tile_rows[:, 1] = (offset_y + ys * cell_size).ravel()
+            tile_rows[:, 2:4] = cell_size
+            tile_rows[:, 4:7] = colors.reshape(-1, 3)
+
+            outline_rows = tile_rows.copy()
+            outline_rows[:, 4:7] = 255
+
+            self.sdl.begin_batch()
+            self.sdl.submit_rects(tile_rows, True)
+            self.sdl.submit_outlines(outline_rows)
+
+        # Tower HP bars, background first so the fill stays on top
+        hp_rows: List[Tuple[int, int, int, int, int, int, int]] = []
+        for tower in arena.towers:
+            if tower.current_hp <= 0:
+                continue
+            hp_bar_width = cell_size * 0.8
+            hp_bar_height = cell_size / 5
+            hp_bar_x = int(
+                offset_x + tower.center_x * cell_size + (cell_size - hp_bar_width) / 2
+            )
+            hp_bar_y = int(offset_y + tower.center_y * cell_size + hp_bar_height - 2)
+
+            hp_percentage = tower.current_hp / tower.max_hp if tower.max_hp > 0 else 0
+            hp_color = (
+                (0, 255, 0)
+                if hp_percentage > 0.5
+                else ((255, 255, 0) if hp_percentage > 0.2 else (255, 0, 0))
+            )
+
+            hp_rows.append(
+                (hp_bar_x, hp_bar_y, int(hp_bar_width), int(hp_bar_height), 0, 0, 0)
+            )
+            hp_rows.append(
+                (
+                    hp_bar_x,
+                    hp_bar_y,
+                    int(hp_bar_width * hp_percentage),
+                    int(hp_bar_height),
+                    *hp_color,
+                )
+            )
+        if hp_rows:
+            self.sdl.submit_rects(hp_rows)
+
+        # Draw units, one submission per layer so the whole army usually costs four calls. Units
+        # only overlap when they share a cell, so each further unit on a cell goes in another pass
+        # of four, which keeps the per-unit order of body, outline and then health bar
+        if arena.units and self.client.side:
+            passes: List[List[List[Tuple[int, int, int, int, int, int, int]]]] = []
+            drawn_on: Dict[Tuple[int, int], int] = {}
+            for unit in arena.units:
+                cell = (unit.inner.unit_data.x, unit.inner.unit_data.y)
+                depth = drawn_on.get(cell, 0)
+                drawn_on[cell] = depth + 1
+                if depth == len(passes):
+                    passes.append([[], [], [], []])
+                unit_rows, unit_outlines, unit_hp_rows, unit_hp_outlines = passes[depth]
+
+                unit_x = offset_x + unit.inner.unit_data.x * cell_size
+                unit_y = offset_y + unit.inner.unit_data.y * cell_size
+                friendly = (
+                    unit.inner.owner == Owner.P1.value
+                    and self.client.side == "Player 1"
+                ) or (
+                    unit.inner.owner == Owner.P2.value
+                    and self.client.side == "Player 2"
+                )
+
+                # Green for our units, red for the opponent's
+                unit_color = (0, 100, 0) if friendly else (100, 0, 0)
+                unit_rows.append((unit_x, unit_y, cell_size, cell_size, *unit_color))
+                unit_outlines.append((unit_x, unit_y, cell_size, cell_size, 0, 0, 0))
+
+                if unit.inner.unit_data.hitpoints and unit.inner.underlying.hitpoints:
+                    inset_x = int(unit_x + (cell_size / 5))
+                    inset_y = int(unit_y + (cell_size / 5))
+                    inner_size = int(cell_size - ((cell_size / 5) * 2))
+                    hp_width = int(
+                        (
+                            unit.inner.unit_data.hitpoints
+                            / unit.inner.underlying.hitpoints
+                        )
+                        * ((cell_size / 5) * 3)
                     )
-                    offset_y = int(380 - ((cell_size * Arena.HEIGHT) / 2))
-
-                    tile_colors = {
-                        0: (99, 99, 99),  # EMPTY
-                        1: (0, 100, 255),  # RIVER
-                        2: (139, 69, 20),  # BRIDGE
-                        3: (255, 0, 0),  # CROWN_TOWER
-                        4: (255, 215, 0),  # KING_TOWER
-                    }
-
-                    for y in range(Arena.HEIGHT):
-                        for x in range(Arena.WIDTH):
-                            tile_type = arena.tiles[y][x]
-                            color: Tuple[int, int, int] = tile_colors.get(
-                                tile_type, (0, 0, 0)
-                            )
-                            rect = (
-                                offset_x + x * cell_size,
-                                offset_y + y * cell_size,
-                                cell_size,
-                                cell_size,
-                            )
-                            if (
-                                (
-                                    Arena.get_tile_owner((x, y)) == Owner.P1
-                                    and self.client.side != "Player 1"
-                                )
-                                or (
-                                    Arena.get_tile_owner((x, y)) == Owner.P2
-                                    and self.client.side != "Player 2"
-                                )
-                                or Arena.get_tile_owner((x, y)) == None
-                            ):
-                                color = (color[0] - 20, color[1] - 20, color[2] - 20)
-                                if color[2] < 0:
-                                    color = (color[0], color[1], 0)
-                                if color[1] < 0:
-                                    color = (color[0], 0, color[2])
-                                if color[0] < 0:
-                                    color = (0, color[1], color[2])
-
-                            if tile_type not in (3, 4):
-                                self.sdl.fill_rect(
-                                    rect[0],
-                                    rect[1],
-                                    rect[2],
-                                    rect[3],
-                                    color[0],
-                                    color[1],
-                                    color[2],
-                                )
-                            else:
-                                if not Arena.is_tower_dead(arena, x, y):
-                                    self.sdl.fill_rect(
-                                        rect[0],
-                                        rect[1],
-                                        rect[2],
-                                        rect[3],
-                                        color[0],
-                                        color[1],
-                                        color[2],
-                                    )
-                                else:
-                                    color = tile_colors[0]
-                                    if (
-                                        (
-                                            Arena.get_tile_owner((x, y)) == Owner.P1
-                                            and self.client.side != "Player 1"
-                                        )
-                                        or (
-                                            Arena.get_tile_owner((x, y)) == Owner.P2
-                                            and self.client.side != "Player 2"
-                                        )
-                                        or Arena.get_tile_owner((x, y)) == None
-                                    ):
-                                        color = (
-                                            color[0] - 20,
-                                            color[1] - 20,
-                                            color[2] - 20,
-                                        )
-                                        if color[2] < 0:
-                                            color = (color[0], color[1], 0)
-                                        if color[1] < 0:
-                                            color = (color[0], 0, color[2])
-                                        if color[0] < 0:
-                                            color = (0, color[1], color[2])
-
-                                    self.sdl.fill_rect(
-                                        rect[0],
-                                        rect[1],
-                                        rect[2],
-                                        rect[3],
-                                        color[0],
-                                        color[1],
-                                        color[2],
-                                    )
-
-                            self.sdl.draw_rect(
-                                rect[0], rect[1], rect[2], rect[3], 255, 255, 255
-                            )  # Add outline
-
-                            if tile_type in (3, 4) and not Arena.is_tower_dead(
-                                arena, x, y
-                            ):  # Crown or King Tower
-                                for tower in arena.towers:
-                                    if tower.center_x == x and tower.center_y == y:
-                                        hp_bar_width = cell_size * 0.8
-                                        hp_bar_height = cell_size / 5
-                                        hp_bar_x = (
-                                            rect[0] + (cell_size - hp_bar_width) / 2
-                                        )
-                                        hp_bar_y = rect[1] + hp_bar_height - 2
-
-                                        # Calculate HP percentage
-                                        hp_percentage = (
-                                            tower.current_hp / tower.max_hp
-                                            if tower.max_hp > 0
-                                            else 0
-                                        )
-                                        filled_width = int(hp_bar_width * hp_percentage)
-
-                                        self.sdl.fill_rect(
-                                            int(hp_bar_x),
-                                            int(hp_bar_y),
-                                            int(hp_bar_width),
-                                            int(hp_bar_height),
-                                            0,
-                                            0,
-                                            0,
-                                        )
-
-                                        hp_color = (
-                                            (0, 255, 0)
-                                            if hp_percentage > 0.5
-                                            else (
-                                                (255, 255, 0)
-                                                if hp_percentage > 0.2
-                                                else (255, 0, 0)
-                                            )
-                                        )
-
-                                        self.sdl.fill_rect(
-                                            int(hp_bar_x),
-                                            int(hp_bar_y),
-                                            filled_width,
-                                            int(hp_bar_height),
-                                            hp_color[0],
-                                            hp_color[1],
-                                            hp_color[2],
-                                        )
-
-                    # Draw units
-                    if arena.units and self.client.side:
-                        for unit in arena.units:
-                            unit_x = offset_x + unit.inner.unit_data.x * cell_size
-                            unit_y = offset_y + unit.inner.unit_data.y * cell_size
-                            unit_rect = (unit_x, unit_y, cell_size, cell_size)
-                            if (
-                                unit.inner.owner == Owner.P1.value
-                                and self.client.side == "Player 1"
-                            ) or (
-                                unit.inner.owner == Owner.P2.value
-                                and self.client.side == "Player 2"
-                            ):
-                                self.sdl.fill_rect(
-                                    unit_rect[0],
-                                    unit_rect[1],
-                                    unit_rect[2],
-                                    unit_rect[3],
-                                    0,
-                                    100,
-                                    0,
-                                )  # Draw units in green
-                            else:
-                                self.sdl.fill_rect(
-                                    unit_rect[0],
-                                    unit_rect[1],
-                                    unit_rect[2],
-                                    unit_rect[3],
-                                    100,
-                                    0,
-                                    0,
-                                )  # Draw units in red
-                            self.sdl.draw_rect(
-                                unit_rect[0],
-                                unit_rect[1],
-                                unit_rect[2],
-                                unit_rect[3],
-                                0,
-                                0,
-                                0,
-                            )  # Add outline
-
-                            if (
-                                unit.inner.unit_data.hitpoints
-                                and unit.inner.underlying.hitpoints
-                            ):
-                                self.sdl.fill_rect(
-                                    int(unit_x + (cell_size / 5)),
-                                    int(unit_y + (cell_size / 5)),
-                                    int(
-                                        # cell_size
-                                        # - ((cell_size / 5) * 2)
-                                        (
-                                            (
-                                                unit.inner.unit_data.hitpoints
-                                                / unit.inner.underlying.hitpoints
-                                            )
-                                            * ((cell_size / 5) * 3)
-                                        )
-                                    ),
-                                    int(cell_size - ((cell_size / 5) * 2)),
-                                    0,
-                                    255,
-                                    0,
-                                )
-                                self.sdl.draw_rect(
-                                    int(unit_x + (cell_size / 5)),
-                                    int(unit_y + (cell_size / 5)),
-                                    int(cell_size - ((cell_size / 5) * 2)),
-                                    int(cell_size - ((cell_size / 5) * 2)),
-                                    0,
-                                    0,
-                                    0,
-                                )
+                    unit_hp_rows.append(
+                        (inset_x, inset_y, hp_width, inner_size, 0, 255, 0)
+                    )
+                    unit_hp_outlines.append(
+                        (inset_x, inset_y, inner_size, inner_size, 0, 0, 0)
+                    )
+
+            for unit_rows, unit_outlines, unit_hp_rows, unit_hp_outlines in passes:
+                self.sdl.submit_rects(unit_rows)
+                self.sdl.submit_outlines(unit_outlines)
+                if unit_hp_rows:
+                    self.sdl.submit_rects(unit_hp_rows)
+                    self.sdl.submit_outlines(unit_hp_outlines)
+
+        self.sdl.flush()
 
     def card_pressed(self, card: Card, button: UIButton, other_buttons: List[UIButton]):
         self.selected_card = card
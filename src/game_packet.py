@@ -440,3 +440,11 @@ class PacketType(enum.Enum):
     Purpose: Sends the result of a card donation.
     Payload: Success/failure status, updated player inventories.
     """
+
+    STATE_DELTA = 59
+    """
+    Server to client game state as a delta.
+    Purpose: Replaces SERVER_CLIENT_SYNC when both ends have the native codec, sending only what changed.
+    Payload: Sequence number, the acked sequence it is based on (0 for a full state),
+             then the full state or the changed fields, with units added/removed/changed by id.
+    """
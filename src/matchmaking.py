@@ -1,19 +1,21 @@
 import collections
-from dataclasses import dataclass
+from dataclasses import dataclass, field
 from datetime import datetime
 from enum import Enum
 from logging import Logger
 import logging
+import os
 from os import pardir
 from socket import socket
 import threading
 import time
 from typing import Callable, Dict, List, Optional, Self, Tuple
 from arena import Arena
+from battle import MatchScheduler, NativeBattle
 from card import Card, CardType, from_namespace
 from card_tick import card_tick
 from game_packet import MatchFound, MatchRequest, PacketType
-from network import Packet
+from network import Packet, binary_peer
 from uuid import uuid4
 import random
 from unit import (
@@ -31,39 +33,76 @@ from unit import (
 from util import DATE_FORMAT, Mutex, Pair
 from util import logger
 
+try:
+    from bindings import MatchmakingIndex
+except ImportError:  # Falls back to scanning the queue pairwise
+    MatchmakingIndex = None
+
 @dataclass 
 class MatchEndData:
     won: bool
 
 MAX_TROPHY_DIFF = 100
+# The allowed difference grows the longer a player waits
+TROPHY_DIFF_WIDEN_PER_SECOND = 10
+MAX_WIDENED_TROPHY_DIFF = 500
+
+
+def trophy_band(waited: float) -> int:
+    """The trophy difference a player who has waited this many seconds accepts, as MatchmakingIndex.band."""
+    widened = MAX_TROPHY_DIFF + int(TROPHY_DIFF_WIDEN_PER_SECOND * max(waited, 0.0))
+    return min(widened, MAX_WIDENED_TROPHY_DIFF)
 
 
 @dataclass
 class MatchRequestSocket:
     inner: MatchRequest
     sock: socket
+    since: float = field(default_factory=time.monotonic)  # When they started waiting
 
 
 class MatchThread:
     MAX_ELIXIR = 10
     ELIXIR_TICK_TIME = 1
+    TICK_RATE = 20  # Fixed simulation steps per second
+    REPLAY_DIR: Optional[str] = None  # Native matches are recorded here as <battle uuid>.replay
 
-    def __init__(self, initial_state: Battle) -> None:
+    def __init__(
+        self, initial_state: Battle, scheduler: Optional["MatchScheduler"] = None
+    ) -> None:
         self.thread = threading.Thread(target=self.loop, daemon=True)
         self.fixed_thread = threading.Thread(target=self.fixed_tick, daemon=True)
         self.state = Mutex(initial_state)
         self.finished = Mutex(False)
         self.arena = Arena()
+        record_path = (
+            os.path.join(self.REPLAY_DIR, f"{initial_state.uuid}.replay")
+            if self.REPLAY_DIR
+            else None
+        )
+        self.native = (
+            NativeBattle(self.arena, self.TICK_RATE, record_path)
+            if NativeBattle.available()
+            else None
+        )
+        # Deploys arrive on the network thread; the fixed thread hands them to the simulation
+        self.pending_units: collections.deque[IDUnit] = collections.deque()
         self.stop_threads = threading.Event()
+        # With a scheduler the match is stepped alongside every other one instead of on its own thread
+        self.scheduler = scheduler if self.native else None
         self.thread.start()
-        self.fixed_thread.start()
+        if self.scheduler:
+            self.scheduler.add(self.native.sim)
+        else:
+            self.fixed_thread.start()
         self.winner: Optional[str] = None
         self.loser: Optional[str] = None
 
     def end(self) -> None:
         # self.stop_threads.set()
         self.thread.join()
-        self.fixed_thread.join()
+        if self.fixed_thread.ident is not None:
+            self.fixed_thread.join()
 
     def start(self) -> None:
         self.thread.start()
@@ -93,52 +132,117 @@ class MatchThread:
         self.state.set_data(state)
 
     def fixed_tick(self) -> None:
+        interval = 1 / self.TICK_RATE
+        next_tick = time.monotonic()
         while not self.stop_threads.is_set():
+            next_tick += interval
+            delay = next_tick - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            else:
+                next_tick = time.monotonic()  # Fell behind; don't try to catch up
+
             state = self.state.get_data()
 
             if not state:
                 continue
 
-            state.units = self.arena.tick(state.units)
-
-            self.arena.units = state.units
-
-            for i, unit in enumerate(state.units):
-                res = card_tick(unit, self.arena)
-                if res:
-                    state.units[i] = res
-                if unit.inner.underlying.hitpoints is not None:
-                    if unit.inner.unit_data.hitpoints <= 0:
-                        state.units.remove(unit)
-                        print("================== DEAD ==================")
-
-            if self.arena.has_won(Owner.P1):
-                self.winner = state.p1.uuid
-                self.loser = state.p2.uuid
-
-                try:
-                    state.p1.sock.sendall(Packet.from_struct(PacketType.MATCH_END, MatchEndData(True)).serialize_with_length())
-                    state.p2.sock.sendall(Packet.from_struct(PacketType.MATCH_END, MatchEndData(False)).serialize_with_length())
-                except:
-                    pass
+            if self.native:
+                self.native_step(state)
+            else:
+                self.python_step(state)
 
-                self.finished.set_data(True)
-            elif self.arena.has_won(Owner.P2):
-                self.winner = state.p2.uuid
-                self.loser = state.p1.uuid
+            self.check_winner(state)
 
-                try:
-                    state.p1.sock.sendall(Packet.from_struct(PacketType.MATCH_END, MatchEndData(False)).serialize_with_length())
-                    state.p2.sock.sendall(Packet.from_struct(PacketType.MATCH_END, MatchEndData(True)).serialize_with_length())
-                except:
-                    pass
+    def native_step(self, state: Battle) -> None:
+        self.before_step()
+        self.native.step()
+        self.after_native_step(state)
 
-                self.finished.set_data(True)
+    def before_step(self) -> None:
+        """Hands queued deploys to the simulation and the state on the thread that steps the match.
 
-            if self.arena.has_won(Owner.P1) or self.arena.has_won(Owner.P2):
-                self.stop_threads.set()
+        sync rebuilds state.units on this thread, so appending from the network thread could lose units.
+        """
+        state = self.state.get_data()
+        while self.pending_units:
+            unit = self.pending_units.popleft()
+            self.native.spawn(unit)
+            if state:
+                state.units.append(unit)
+
+    def after_native_step(self, state: Battle) -> None:
+        self.native.sync(state.units)
+        self.native.checkpoint()
+        self.arena.units = state.units
+
+    def after_scheduled_step(self) -> None:
+        """Syncs a step taken by the scheduler, and unschedules the match once it has ended."""
+        state = self.state.get_data()
+        if state:
+            self.after_native_step(state)
+            self.check_winner(state)
+        if self.stop_threads.is_set() and self.scheduler:
+            self.scheduler.remove(self.native.sim)
+            self.scheduler = None
+
+    def abort(self) -> None:
+        """Ends a match that failed mid-step, with no result, so only it stops being stepped."""
+        self.stop_threads.set()
+        if self.scheduler:
+            self.scheduler.remove(self.native.sim)
+            self.scheduler = None
+        if self.native:
+            self.native.close()
+        self.finished.set_data(True)
+
+    def python_step(self, state: Battle) -> None:
+        state.units = self.arena.tick(state.units)
+
+        self.arena.units = state.units
+
+        # Rebuilt in place once every unit has ticked: removing the dead while enumerating
+        # skipped the unit after each one
+        living: List[IDUnit] = []
+        for unit in state.units:
+            res = card_tick(unit, self.arena)
+            if unit.inner.underlying.hitpoints is not None:
+                if unit.inner.unit_data.hitpoints <= 0:
+                    print("================== DEAD ==================")
+                    continue
+            living.append(res or unit)
+        state.units[:] = living
+
+    def check_winner(self, state: Battle) -> None:
+        if self.arena.has_won(Owner.P1):
+            self.winner = state.p1.uuid
+            self.loser = state.p2.uuid
+
+            try:
+                state.p1.sock.sendall(Packet.from_struct(PacketType.MATCH_END, MatchEndData(True)).serialize_with_length(binary_peer(state.p1.sock)))
+                state.p2.sock.sendall(Packet.from_struct(PacketType.MATCH_END, MatchEndData(False)).serialize_with_length(binary_peer(state.p2.sock)))
+            except:
+                pass
+
+            self.finished.set_data(True)
+        elif self.arena.has_won(Owner.P2):
+            self.winner = state.p2.uuid
+            self.loser = state.p1.uuid
+
+            try:
+                state.p1.sock.sendall(Packet.from_struct(PacketType.MATCH_END, MatchEndData(False)).serialize_with_length(binary_peer(state.p1.sock)))
+                state.p2.sock.sendall(Packet.from_struct(PacketType.MATCH_END, MatchEndData(True)).serialize_with_length(binary_peer(state.p2.sock)))
+            except:
+                pass
+
+            self.finished.set_data(True)
+
+        if self.arena.has_won(Owner.P1) or self.arena.has_won(Owner.P2):
+            self.stop_threads.set()
+            if self.native:
+                self.native.close()
 
-            self.state.set_data(state)
+        self.state.set_data(state)
 
     def is_finished(self) -> bool:
         return self.finished.get_data() or False
@@ -156,8 +260,12 @@ class MatchThread:
             return
 
         u = IDUnit.from_unit(unit)
-        state.units.append(u)
-        self.arena.add_unit(u)
+        if self.native:
+            # before_step adds it to state.units too
+            self.pending_units.append(u)
+        else:
+            state.units.append(u)
+            self.arena.add_unit(u)
 
         if unit.owner == Owner.P1:
             state.p1.elixir = state.p1.elixir - unit.underlying.elixir_cost
@@ -233,13 +341,46 @@ class MatchThread:
 
 class Matchmaking:
     def __init__(self) -> None:
-        self.waiting: List[MatchRequestSocket] = []
+        self.waiting: Dict[str, MatchRequestSocket] = {}  # By player uuid, oldest first
+        self.index = (
+            MatchmakingIndex(
+                MAX_TROPHY_DIFF, TROPHY_DIFF_WIDEN_PER_SECOND, MAX_WIDENED_TROPHY_DIFF
+            )
+            if MatchmakingIndex
+            else None
+        )
+        self.index_ids: Dict[int, str] = {}  # Index id to player uuid
+        # Taken around queueing and pairing, so a paired id is always in index_ids
+        self.queue_lock = threading.Lock()
         self.matches: Dict[str, MatchThread] = {}
+        self.scheduler = MatchScheduler(MatchThread.TICK_RATE) if MatchScheduler else None
+        if self.scheduler:
+            threading.Thread(target=self.drive_matches, daemon=True).start()
+
+    def drive_matches(self) -> None:
+        """Steps every scheduled match in parallel, then syncs their states back in one pass."""
+        while True:
+            scheduled = [(i, m) for i, m in list(self.matches.items()) if m.scheduler]
+            for match_id, m in scheduled:
+                self.drive_match(match_id, m, m.before_step)
+
+            self.scheduler.wait_and_step()
+
+            for match_id, m in scheduled:
+                if m.scheduler:
+                    self.drive_match(match_id, m, m.after_scheduled_step)
+
+    def drive_match(self, match_id: str, match: MatchThread, step: Callable[[], None]) -> None:
+        """Runs one match's part of a scheduled step; a match that raises is ended on its own."""
+        try:
+            step()
+        except Exception:
+            logger.exception(f"Match {match_id} failed, ending it")
+            match.abort()
 
     def request(self, d: MatchRequest, s: socket) -> None:
-        for c in self.waiting:
-            if c.inner.uuid == d.uuid:
-                return
+        if d.uuid in self.waiting:
+            return
 
         for m in self.matches.values():
             if m.get_state().p1.uuid == d.uuid or m.get_state().p2.uuid == d.uuid:
@@ -247,15 +388,22 @@ class Matchmaking:
                 return
 
         # print(d)
-        self.waiting.append(MatchRequestSocket(d, s))
+        with self.queue_lock:
+            if d.uuid in self.waiting:
+                return
+            self.waiting[d.uuid] = MatchRequestSocket(d, s)
+            if self.index:
+                self.index_ids[self.index.add(d.trophies, self.waiting[d.uuid].since)] = d.uuid
 
     def tick(self, update_battle: Callable[[str, Optional[str]], None], update_trophies: Callable[[str, int], None]) -> None:
         new_matches = self.matches.copy()
         for match in self.matches.keys():
             m = self.matches[match]
-            if self.matches[match] and self.matches[match].is_finished() and m.winner and m.loser:
-                update_trophies(m.winner, random.randint(25, 35))
-                update_trophies(m.loser, -random.randint(25, 35))
+            if m and m.is_finished():
+                # An aborted match has no result and changes no trophies
+                if m.winner and m.loser:
+                    update_trophies(m.winner, random.randint(25, 35))
+                    update_trophies(m.loser, -random.randint(25, 35))
                 new_matches.pop(match)
 
         self.matches = new_matches.copy()
@@ -263,25 +411,44 @@ class Matchmaking:
         if len(self.waiting) < 2:
             return
 
-        matched_pairs: List[Tuple[MatchRequestSocket, MatchRequestSocket]] = []
-        i = 0
-        while i < len(self.waiting):
-            j = i + 1
-            while j < len(self.waiting):
-                if self.are_compatible(self.waiting[i].inner, self.waiting[j].inner):
-                    matched_pairs.append((self.waiting[i], self.waiting[j]))
-                    break
-                j += 1
-            i += 1
-
-        for pair in matched_pairs:
+        for pair in self.pair_waiting():
             # print(pair[0], pair[1])
             i = self.handle_match(pair[0], pair[1])
             update_battle(pair[0].inner.uuid, i)
             update_battle(pair[1].inner.uuid, i)
-            self.waiting.remove(pair[0])
-            self.waiting.remove(pair[1])
 
+    def pair_waiting(self) -> List[Tuple[MatchRequestSocket, MatchRequestSocket]]:
+        """Takes every compatible pair out of the queue, longest waiting first."""
+        with self.queue_lock:
+            now = time.monotonic()
+            pairs: List[Tuple[str, str]] = []
+            if self.index:
+                for first, second in self.index.pair(now):
+                    pairs.append(
+                        (self.index_ids.pop(int(first)), self.index_ids.pop(int(second)))
+                    )
+            else:
+                # Same rule as the index: the closest opponent within the older player's band
+                queue = list(self.waiting.values())
+                taken = set()
+                for i, req1 in enumerate(queue):
+                    if req1.inner.uuid in taken:
+                        continue
+                    candidates = [
+                        req2
+                        for req2 in queue[i + 1 :]
+                        if req2.inner.uuid not in taken
+                        and self.are_compatible(req1.inner, req2.inner, now - req1.since)
+                    ]
+                    if candidates:
+                        req2 = min(
+                            candidates,
+                            key=lambda r: abs(r.inner.trophies - req1.inner.trophies),
+                        )
+                        pairs.append((req1.inner.uuid, req2.inner.uuid))
+                        taken.update(pairs[-1])
+
+            return [(self.waiting.pop(a), self.waiting.pop(b)) for a, b in pairs]
 
     def get_match(
         self, uuid: str, player_uuid: str
@@ -308,9 +475,12 @@ class Matchmaking:
             (None, None, None),
         )
 
-    def are_compatible(self, req1: MatchRequest, req2: MatchRequest) -> bool:
+    def are_compatible(
+        self, req1: MatchRequest, req2: MatchRequest, waited: float = 0.0
+    ) -> bool:
+        """Whether req2 is within the band of req1, who has waited longer."""
         trophy_difference = abs(req1.trophies - req2.trophies)
-        return trophy_difference <= MAX_TROPHY_DIFF
+        return trophy_difference <= trophy_band(waited)
 
     def handle_match(self, req1: MatchRequestSocket, req2: MatchRequestSocket) -> str:
         id = str(uuid4())
@@ -352,7 +522,8 @@ class Matchmaking:
                         ),
                         id,
                         [],
-                    )
+                    ),
+                    self.scheduler,
                 ),
             }
         )
@@ -362,12 +533,12 @@ class Matchmaking:
         req1.sock.sendall(
             Packet.from_struct(
                 PacketType.MATCH_FOUND, MatchFound(id, req2.inner.uuid, "Player 1")
-            ).serialize_with_length()
+            ).serialize_with_length(binary_peer(req1.sock))
         )
         req2.sock.sendall(
             Packet.from_struct(
                 PacketType.MATCH_FOUND, MatchFound(id, req1.inner.uuid, "Player 2")
-            ).serialize_with_length()
+            ).serialize_with_length(binary_peer(req2.sock))
         )
 
         logging.info("Match Found")
@@ -404,3 +575,78 @@ class Matchmaking:
             #         )
             #     )
             #
+
+
+import pytest
+from types import SimpleNamespace
+
+native_index = pytest.mark.skipif(
+    MatchmakingIndex is None, reason="needs MatchmakingIndex from the bindings extension"
+)
+
+
+def _pairs(index, now: float) -> List[Tuple[int, int]]:
+    return [(int(first), int(second)) for first, second in index.pair(now)]
+
+
+@native_index
+def test_index_pairs_oldest_first():
+    index = MatchmakingIndex(100, 10.0, 500)
+    a = index.add(1000, 0.0)
+    b = index.add(1050, 1.0)
+    c = index.add(1040, 2.0)
+    d = index.add(1100, 3.0)
+    # a goes first and takes the closest, c; b is then next oldest and takes d
+    assert _pairs(index, 3.0) == [(a, c), (b, d)]
+    assert len(index) == 0
+
+
+@native_index
+def test_index_tie_goes_to_longer_waiting():
+    index = MatchmakingIndex(100, 10.0, 500)
+    a = index.add(1000, 0.0)
+    b = index.add(1050, 1.0)
+    c = index.add(950, 2.0)
+    assert _pairs(index, 2.0) == [(a, b)]
+    assert c in index and a not in index
+
+
+@native_index
+def test_index_band_widens_with_wait():
+    index = MatchmakingIndex(100, 10.0, 500)
+    a = index.add(1000, 0.0)
+    b = index.add(1300, 0.0)
+    assert _pairs(index, 19.0) == []
+    assert _pairs(index, 20.0) == [(a, b)]
+
+    low = index.add(0, 0.0)
+    index.add(600, 0.0)
+    # The band stops growing at max_difference
+    assert index.band(1000.0) == 500
+    assert _pairs(index, 1000.0) == []
+    assert low in index
+
+
+def _queue(matchmaking: "Matchmaking", now: float, *players: Tuple[str, int, float]) -> None:
+    for uuid, trophies, waited in players:
+        matchmaking.waiting[uuid] = MatchRequestSocket(
+            SimpleNamespace(uuid=uuid, trophies=trophies), None, now - waited
+        )
+
+
+def test_fallback_band_matches_index():
+    matchmaking = Matchmaking()
+    matchmaking.index = None
+    now = time.monotonic()
+
+    _queue(matchmaking, now, ("a", 1000, 5.0), ("b", 1250, 0.0))
+    assert matchmaking.pair_waiting() == []
+
+    matchmaking.waiting["a"].since = now - 20.0
+    assert [(p.inner.uuid, q.inner.uuid) for p, q in matchmaking.pair_waiting()] == [("a", "b")]
+
+    _queue(matchmaking, now, ("c", 0, 1000.0), ("d", 600, 1000.0), ("e", 450, 0.0))
+    # Capped at MAX_WIDENED_TROPHY_DIFF, and the closest opponent wins
+    assert trophy_band(1000.0) == MAX_WIDENED_TROPHY_DIFF
+    assert [(p.inner.uuid, q.inner.uuid) for p, q in matchmaking.pair_waiting()] == [("c", "e")]
+    assert list(matchmaking.waiting) == ["d"]
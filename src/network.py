@@ -1,6 +1,6 @@
 from abc import ABCMeta, abstractmethod
 from collections import abc
-from dataclasses import dataclass, fields
+from dataclasses import dataclass, fields, is_dataclass
 import enum
 from random import randint, random
 import socket
@@ -8,13 +8,72 @@ import struct
 import threading
 import json
 from time import sleep, time
-from typing import Callable, List, Optional, Dict, Any, Self, Type, get_type_hints
+from types import SimpleNamespace
+from typing import (
+    Callable,
+    ClassVar,
+    List,
+    Optional,
+    Dict,
+    Any,
+    Iterator,
+    Self,
+    Type,
+    Union,
+    get_args,
+    get_origin,
+    get_type_hints,
+)
 from game_packet import PacketType
 from util import logger
 import select
 from uuid import uuid4
+import weakref
 from enum import Enum
 
+try:
+    from bindings import (
+        PACKET_MARKER,
+        DeltaDecoder,
+        DeltaEncoder,
+        FrameReader,
+        PacketCodec,
+    )
+except ImportError:  # Tests and tools can run without the compiled extension
+    PacketCodec = None
+    FrameReader = None
+
+try:
+    from bindings import EventLoop
+except ImportError:  # Not built on Windows either; Server falls back to threads
+    EventLoop = None
+
+CODEC = PacketCodec() if PacketCodec else None
+BINARY_MARKER = bytes([PACKET_MARKER]) if PacketCodec else b""
+# What the codec and the delta encoder and decoder raise for values or payloads they can't handle
+CODEC_ERRORS = (AttributeError, TypeError, ValueError, OverflowError, RuntimeError)
+
+# Server side connections whose client agreed to the binary format at LOGIN
+_binary_peers: "weakref.WeakSet[Any]" = weakref.WeakSet()
+
+
+def agree_binary(sock: Any, peer_binary: bool) -> bool:
+    """Records whether sock's peer and this side can both use the binary format.
+
+    Called with the client's claim from its LOGIN; returns the agreement to send back.
+    """
+    agreed = peer_binary and CODEC is not None
+    if agreed:
+        _binary_peers.add(sock)
+    else:
+        _binary_peers.discard(sock)
+    return agreed
+
+
+def binary_peer(sock: Any) -> bool:
+    """Whether packets to sock may use the binary format; JSON otherwise."""
+    return sock in _binary_peers
+
 
 @dataclass
 class ServerStatus:
@@ -172,6 +231,80 @@ def serialize_object(obj: Any):
         raise TypeError(f"Type {type(obj)} ({obj}) is not JSON serializable")
 
 
+def _schema_name(cls: type) -> str:
+    return f"{cls.__module__}.{cls.__qualname__}"
+
+
+def _schema_fields(cls: type) -> List[tuple]:
+    """The (name, hint) pairs serialize_object would write for instances of cls."""
+    hints = get_type_hints(cls)
+    if is_dataclass(cls):
+        names = [field.name for field in fields(cls)]
+    else:
+        names = [name for name, hint in hints.items() if get_origin(hint) is not ClassVar]
+    return [(name, hints[name]) for name in names if not name.startswith("_")]
+
+
+def _type_spec(codec: Any, hint: Any) -> str:
+    """Codec type spec for a type hint, defining the structs and enums it refers to on first use."""
+    if hint is bool:
+        return "b"
+    if hint is int:
+        return "i"
+    if hint is float:
+        return "f"
+    if hint is str:
+        return "s"
+
+    origin, args = get_origin(hint), get_args(hint)
+    if origin is Union and len(args) == 2 and type(None) in args:
+        return "?" + _type_spec(codec, next(a for a in args if a is not type(None)))
+    if origin is list:
+        return f"[{_type_spec(codec, args[0])}]"
+    if origin is tuple and args and Ellipsis not in args:
+        return "(" + "".join(_type_spec(codec, a) for a in args) + ")"
+
+    if isinstance(hint, type):
+        name = _schema_name(hint)
+        if not codec.is_defined(name):
+            if issubclass(hint, Enum):
+                codec.define_enum(name, list(hint))
+            else:
+                codec.define_struct(
+                    name, [(f, _type_spec(codec, h)) for f, h in _schema_fields(hint)]
+                )
+        return f"<{name}>"
+
+    raise TypeError(f"No binary encoding for {hint}")
+
+
+def register_packet(packet_type: PacketType, root: type) -> None:
+    """Sends packet_type in the binary format, with root's type hints as the schema.
+
+    Fields follow serialize_object: a dataclass's fields, or the non-ClassVar annotations
+    of any other class, skipping private names. Without the extension this does nothing
+    and the packet stays JSON.
+    """
+    if CODEC is None:
+        return
+    _type_spec(CODEC, root)
+    CODEC.bind(packet_type.value, _schema_name(root))
+
+
+def delta_encoder(packet_type: PacketType) -> Optional[Any]:
+    """A DeltaEncoder for one client's packet_type states, None if they can't be sent as deltas."""
+    if CODEC is None or not CODEC.supports(packet_type.value):
+        return None
+    return DeltaEncoder(CODEC, packet_type.value)
+
+
+def delta_decoder(packet_type: PacketType) -> Optional[Any]:
+    """The client's DeltaDecoder for packet_type states, None without the extension."""
+    if CODEC is None or not CODEC.supports(packet_type.value):
+        return None
+    return DeltaDecoder(CODEC, packet_type.value)
+
+
 def recv_all(
     sock: socket.socket,
     length: int,
@@ -179,28 +312,52 @@ def recv_all(
     id: Optional[str] = None,
 ) -> Optional[bytes]:
     """Receives exactly 'length' bytes from the socket with an optional timeout."""
-    data = b""
-    remaining = length
+    data = bytearray(length)
+    view = memoryview(data)
+    received = 0
 
-    while remaining > 0:
+    while received < length:
         if timeout is not None:
             readable, _, _ = select.select([sock], [], [], timeout)
             if not readable:
                 return None
 
         try:
-            chunk = sock.recv(remaining)
+            count = sock.recv_into(view[received:])
         except socket.timeout:
             return None
 
-        if not chunk:
+        if not count:
             # raise ConnectionError(f"[{id}] Socket closed during recv_all")
             return b""
 
-        data += chunk
-        remaining -= len(chunk)
+        received += count
+
+    return bytes(data)
 
-    return data
+
+def packet_stream(sock: socket.socket) -> Iterator["Packet"]:
+    """Yields packets from sock until it closes or sends an unknown packet type.
+
+    With the extension, a FrameReader reads everything that has arrived in one go and parses
+    the frames in place. Its views are only valid until the next fill, and handlers keep
+    packets around, so each payload is copied out as the packet is made.
+    """
+    if FrameReader is None:
+        while True:
+            packet = Packet.from_socket(sock)
+            if packet is None:
+                return
+            yield packet
+
+    reader = FrameReader(sock.fileno())
+    while reader.fill(-1) >= 0:
+        for packet_type_val, data in reader.drain():
+            try:
+                packet_type = PacketType(packet_type_val)
+            except ValueError:
+                return
+            yield Packet(packet_type, bytes(data))
 
 
 class Packet:
@@ -211,17 +368,50 @@ class Packet:
 
     def __init__(self, packet_type: PacketType, data: Optional[bytes] = None):
         self.packet_type = packet_type
-        self.data = data if data else b""
+        self._data = data if data else b""
+        self.struct: Any = None  # What from_struct was given, encoded on serializing
+
+    @property
+    def data(self) -> bytes:
+        if self._data is None:
+            self._data = self._encode(False)
+        return self._data
 
     @classmethod
     def from_struct(cls, packet_type: PacketType, s: object):
-        return cls(packet_type, json.dumps(serialize_object(s)).encode())
-
-    def serialize_with_length(self) -> bytes:
-        """Serializes the packet into bytes with length headers."""
-        data_length = len(self.data)
-        header = struct.pack(self.HEADER_FORMAT, self.packet_type.value, data_length)
-        return header + self.data
+        """A packet for s, encoded when serialized: JSON unless the peer agreed to binary."""
+        packet = cls(packet_type)
+        packet._data = None
+        packet.struct = s
+        return packet
+
+    def _encode(self, binary: bool) -> bytes:
+        if binary and CODEC is not None and CODEC.supports(self.packet_type.value):
+            try:
+                return CODEC.encode(self.packet_type.value, self.struct)
+            except CODEC_ERRORS as e:
+                logger.warning(f"Sending {self.packet_type} as JSON: {e}")
+        return json.dumps(serialize_object(self.struct)).encode()
+
+    def to_struct(self) -> Any:
+        """Decodes a from_struct payload into SimpleNamespaces, whichever format it was sent in.
+
+        Enums come back as their values in both formats.
+        """
+        if CODEC is not None and self.data[:1] == BINARY_MARKER:
+            return CODEC.decode(self.packet_type.value, self.data)
+        return json.loads(
+            str(self.data, "utf-8"), object_hook=lambda d: SimpleNamespace(**d)
+        )
+
+    def serialize_with_length(self, binary: bool = False) -> bytes:
+        """Serializes the packet into bytes with length headers.
+
+        binary sends a from_struct packet in the binary format, for a peer that agreed to it.
+        """
+        data = self._encode(True) if binary and self.struct is not None else self.data
+        header = struct.pack(self.HEADER_FORMAT, self.packet_type.value, len(data))
+        return header + data
 
     @staticmethod
     def from_socket(
@@ -277,29 +467,124 @@ class NetworkObject:
         pass
 
 
+class LoopClient:
+    """Stands in for a client's socket under the event loop Server; handlers only sendall."""
+
+    def __init__(self, loop: Any, client: int) -> None:
+        self.loop = loop
+        self.client = client
+
+    def sendall(self, data: bytes) -> None:
+        """Queues data, written with everything else sent to this client since the last flush."""
+        if not self.loop.send(self.client, data):
+            raise ConnectionError(f"Client {self.client} has disconnected")
+
+    def close(self) -> None:
+        self.loop.close(self.client)
+
+    def __repr__(self) -> str:
+        return f"<LoopClient {self.client}>"
+
+
 class Server:
-    """Multiplayer game server that manages clients and game state."""
+    """Multiplayer game server that manages clients and game state.
+
+    With the extension every client is serviced by one EventLoop thread, which hands
+    the handlers each iteration's packets in one batch. Without it each client gets a
+    reader thread and a status thread.
+    """
+
+    STATUS_INTERVAL = 0.1
 
     def __init__(self, port: int, handlers: List[NetworkObject]) -> None:
         self.port = port
-        self.server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-        self.server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
-        self.server_socket.bind(("0.0.0.0", port))
-        self.server_socket.listen()
-        self.clients: List[socket.socket] = []
+        self.clients: List[Any] = []
         self.lock = threading.Lock()
+        self.handlers: List[NetworkObject] = handlers
 
-        self.server_thread = threading.Thread(target=self._run, daemon=True)
+        if EventLoop is not None:
+            self.loop = EventLoop(port)
+            self.loop_clients: Dict[int, LoopClient] = {}
+            self.server_thread = threading.Thread(target=self._run_loop, daemon=True)
+        else:
+            self.loop = None
+            self.server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+            self.server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+            self.server_socket.bind(("0.0.0.0", port))
+            self.server_socket.listen()
+            self.server_thread = threading.Thread(target=self._run, daemon=True)
         self.server_thread.start()
 
-        self.handlers: List[NetworkObject] = handlers
-
         hostname = socket.gethostname()
         ip_address = socket.gethostbyname(hostname)
         logger.info(f"Server listening on {ip_address}:{port}")
 
         threading.Thread(target=self._broadcast_loop, daemon=True).start()
 
+    def _status_packet(self) -> bytes:
+        return Packet(
+            PacketType.STATUS, json.dumps(ServerStatus().__dict__).encode()
+        ).serialize_with_length()
+
+    def _run_loop(self):
+        """Runs the event loop, sending every client its status between batches."""
+        last_status = 0.0
+        while True:
+            self.loop.run_once(int(self.STATUS_INTERVAL * 1000), self._handle_batch)
+            now = time()
+            if now - last_status >= self.STATUS_INTERVAL:
+                last_status = now
+                status = self._status_packet()
+                for client in list(self.loop_clients.values()):
+                    self.loop.send(client.client, status)
+
+    def _handle_batch(
+        self, opened: List[int], frames: List[tuple], closed: List[int]
+    ) -> None:
+        """One event loop iteration: new clients, then their packets, then departures.
+
+        Frame payloads are memoryviews into the loop's buffers, valid until the next
+        batch, so they're copied into the packets handed to handlers. This runs on the
+        only server thread, so whatever one client's handling raises closes just that
+        client.
+        """
+        for client_id in opened:
+            client = LoopClient(self.loop, client_id)
+            self.loop_clients[client_id] = client
+            with self.lock:
+                self.clients.append(client)
+            logger.info(f"Client connected: {client}")
+            try:
+                for handler in self.handlers:
+                    handler.on_connection()
+                client.sendall(Packet(PacketType.CONNECTION).serialize_with_length())
+            except Exception as e:
+                logger.exception(f"Error accepting {client}, closing it: {e}")
+                self.loop.close(client_id)
+
+        for client_id, packet_type_val, data in frames:
+            client = self.loop_clients.get(client_id)
+            if client is None:
+                continue
+            try:
+                packet_type = PacketType(packet_type_val)
+            except ValueError:
+                # Same as the threaded reader: the stream can't be trusted past this
+                self.loop.close(client_id)
+                continue
+            try:
+                self.process_packet(Packet(packet_type, bytes(data)), client)
+            except Exception as e:
+                logger.exception(f"Error handling {packet_type} from {client}, closing it: {e}")
+                self.loop.close(client_id)
+
+        for client_id in closed:
+            client = self.loop_clients.pop(client_id, None)
+            logger.info(f"Client disconnected: {client}")
+            with self.lock:
+                if client in self.clients:
+                    self.clients.remove(client)
+
     def _run(self):
         """Runs the server loop, accepting connections and handling clients."""
         while True:
@@ -320,9 +605,10 @@ class Server:
         for handler in self.handlers:
             handler.on_connection()
 
+        packets = packet_stream(client_sock)
         while True:
             try:
-                packet = Packet.from_socket(client_sock, timeout=False)
+                packet = next(packets, None)
                 if packet is None:
                     break
 
@@ -336,11 +622,8 @@ class Server:
 
         while True:
             try:
-                status_packet = Packet(
-                    PacketType.STATUS, json.dumps(ServerStatus().__dict__).encode()
-                )
-                client_sock.sendall(status_packet.serialize_with_length())
-                sleep(0.1)
+                client_sock.sendall(self._status_packet())
+                sleep(self.STATUS_INTERVAL)
             except (ConnectionError, Exception) as e:
                 logger.warning(f"Client connection handler disconnected: {e}")
                 with self.lock:
@@ -360,8 +643,11 @@ class Server:
             logger.warning(f"Packet not handled: {packet}")
 
     def broadcast_packet(self, packet: Packet):
-        for client in self.clients:
-            client.sendall(packet.serialize_with_length())
+        data = packet.serialize_with_length()
+        with self.lock:
+            clients = list(self.clients)
+        for client in clients:
+            client.sendall(data)
 
     @abstractmethod
     def tick(self) -> None:
@@ -386,12 +672,14 @@ class Client(metaclass=ABCMeta):
         self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
         self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
         self.sock.connect(self.server_address)
+        # Set once the server agrees to the binary format at LOGIN
+        self.binary = False
 
         self.listen_thread = threading.Thread(target=self.listen, daemon=True)
         self.listen_thread.start()
 
     def send(self, pack: Packet) -> None:
-        self.sock.sendall(pack.serialize_with_length())
+        self.sock.sendall(pack.serialize_with_length(self.binary))
 
     @abstractmethod
     def packet_callback(self, packet: Packet):
@@ -399,9 +687,10 @@ class Client(metaclass=ABCMeta):
 
     def listen(self):
         """Listens for game state updates from the server and updates the client's local state."""
+        packets = packet_stream(self.sock)
         while True:
             try:
-                packet = Packet.from_socket(self.sock)
+                packet = next(packets, None)
                 if packet is None:
                     logger.warning(f"Received empty packet, disconnecting...")
                     break
@@ -432,3 +721,225 @@ class Client(metaclass=ABCMeta):
 def do_if(pack: Packet, t: PacketType, callback: Callable[[], None]) -> None:
     if pack.packet_type == t:
         callback()
+
+
+import pytest
+
+codec_required = pytest.mark.skipif(
+    PacketCodec is None, reason="needs PacketCodec from the bindings extension"
+)
+
+
+class _Suit(Enum):
+    ROCK = "rock"
+    PAPER = 2
+
+
+@dataclass
+class _Card:
+    suit: _Suit
+    level: int
+
+
+@dataclass
+class _Hand:
+    owner: str
+    ready: bool
+    elixir: float
+    delta: int
+    cards: List[_Card]
+    next: Optional[_Card]
+    note: Optional[str]
+    history: List[int]
+
+
+def _test_codec() -> Any:
+    codec = PacketCodec()
+    _type_spec(codec, _Hand)
+    codec.bind(1, _schema_name(_Hand))
+    return codec
+
+
+def _plain(value: Any) -> Any:
+    if isinstance(value, SimpleNamespace):
+        return {key: _plain(item) for key, item in vars(value).items()}
+    if isinstance(value, list):
+        return [_plain(item) for item in value]
+    return value
+
+
+def _hand(**changes: Any) -> _Hand:
+    hand = _Hand(
+        owner="alice",
+        ready=True,
+        elixir=4.5,
+        delta=-3,
+        cards=[_Card(_Suit.ROCK, 1), _Card(_Suit.PAPER, 13)],
+        next=_Card(_Suit.PAPER, 7),
+        note="gg",
+        history=[0, -1, 1, -64, 64, -(2**40), 2**62],
+    )
+    for key, value in changes.items():
+        setattr(hand, key, value)
+    return hand
+
+
+@codec_required
+def test_codec_round_trip_matches_json():
+    codec = _test_codec()
+    hand = _hand()
+    decoded = codec.decode(1, codec.encode(1, hand))
+    # Nested structs come back as namespaces and enums as their values, like the JSON path
+    assert _plain(decoded) == serialize_object(hand)
+    assert decoded.cards[1].suit == 2 and decoded.next.suit == 2
+    assert decoded.history == hand.history
+
+
+@codec_required
+def test_codec_optional_and_empty_fields():
+    codec = _test_codec()
+    hand = _hand(next=None, note=None, cards=[], history=[], owner="")
+    decoded = codec.decode(1, codec.encode(1, hand))
+    assert decoded.next is None and decoded.note is None
+    assert decoded.cards == [] and decoded.history == [] and decoded.owner == ""
+
+
+@codec_required
+def test_codec_negative_ints_stay_small():
+    codec = _test_codec()
+    small = len(codec.encode(1, _hand(delta=-1)))
+    # Zigzag keeps small negative numbers as short as small positive ones
+    assert small == len(codec.encode(1, _hand(delta=1)))
+    assert small < len(codec.encode(1, _hand(delta=-(2**40))))
+    assert codec.decode(1, codec.encode(1, _hand(delta=-(2**63)))).delta == -(2**63)
+
+
+@codec_required
+def test_codec_truncated_packet_raises():
+    codec = _test_codec()
+    data = codec.encode(1, _hand())
+    for end in range(len(data)):
+        with pytest.raises(ValueError):
+            codec.decode(1, data[:end])
+    with pytest.raises(ValueError):
+        codec.decode(1, data + b"\x00")
+
+
+@codec_required
+def test_codec_bool_is_zero_or_one():
+    codec = _test_codec()
+    assert codec.decode(1, codec.encode(1, _hand(ready=1))).ready is True
+    with pytest.raises(ValueError):
+        codec.encode(1, _hand(ready=2))
+
+
+def test_struct_packets_default_to_json():
+    packet = Packet.from_struct(PacketType.LOGIN, _hand())
+    # Only a peer that agreed at LOGIN gets the binary format
+    payload = packet.serialize_with_length()[Packet.HEADER_SIZE :]
+    assert json.loads(payload) == serialize_object(_hand())
+
+
+event_loop_required = pytest.mark.skipif(
+    EventLoop is None, reason="needs EventLoop from the bindings extension"
+)
+
+
+def _ignore_batch(opened: List[int], frames: List[tuple], closed: List[int]) -> None:
+    pass
+
+
+def _loop_client(loop: Any) -> tuple:
+    """A connected client socket and its id, with a receive buffer small enough to back up writes."""
+    client = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    client.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4096)
+    client.connect(("127.0.0.1", loop.port))
+    client.setblocking(False)
+    opened: List[int] = []
+    deadline = time() + 5
+    while not opened and time() < deadline:
+        loop.run_once(50, lambda o, f, c: opened.extend(o))
+    assert opened
+    return client, opened[0]
+
+
+def _large_payload() -> bytes:
+    return b"".join(
+        Packet(PacketType.STATUS, bytes([i]) * (32 << 10)).serialize_with_length()
+        for i in range(128)
+    )
+
+
+def _recv_available(client: socket.socket, into: bytearray) -> bool:
+    """Reads what the client has without blocking; False once the loop has closed it."""
+    while True:
+        try:
+            chunk = client.recv(1 << 16)
+        except BlockingIOError:
+            return True
+        if not chunk:
+            return False
+        into += chunk
+
+
+@event_loop_required
+def test_event_loop_partial_writes():
+    loop = EventLoop(0)
+    client, client_id = _loop_client(loop)
+    payload = _large_payload()
+    assert loop.send(client_id, payload)
+
+    received = bytearray()
+    loop.run_once(0, _ignore_batch)
+    _recv_available(client, received)
+    # The socket took some of it; the rest waits for it to be writable again
+    assert 0 < len(received) < len(payload)
+
+    deadline = time() + 10
+    while len(received) < len(payload) and time() < deadline:
+        loop.run_once(10, _ignore_batch)
+        _recv_available(client, received)
+    assert bytes(received) == payload
+    client.close()
+
+
+@event_loop_required
+def test_event_loop_close_after_write():
+    loop = EventLoop(0)
+    client, client_id = _loop_client(loop)
+    payload = _large_payload()
+    assert loop.send(client_id, payload)
+    loop.close(client_id)
+
+    closed: List[int] = []
+    received = bytearray()
+    loop.run_once(0, lambda o, f, c: closed.extend(c))
+    # Still writing what was queued before the close, but nothing more can be sent
+    assert closed == []
+    assert not loop.send(client_id, b"late")
+
+    open_ = True
+    deadline = time() + 10
+    while open_ and time() < deadline:
+        loop.run_once(10, lambda o, f, c: closed.extend(c))
+        open_ = _recv_available(client, received)
+    assert not open_ and bytes(received) == payload
+    while not closed and time() < deadline:
+        loop.run_once(10, lambda o, f, c: closed.extend(c))
+    assert closed == [client_id]
+    client.close()
+
+
+def test_packet_stream_data_outlives_next_packet():
+    server, client = socket.socketpair()
+    packets = packet_stream(server)
+    client.sendall(Packet(PacketType.STATUS, b"first").serialize_with_length())
+    first = next(packets)
+    # A separate read, which the FrameReader makes into the same buffer
+    client.sendall(Packet(PacketType.STATUS, b"second").serialize_with_length())
+    second = next(packets)
+    assert bytes(first.data) == b"first" and bytes(second.data) == b"second"
+
+    client.close()
+    assert next(packets, None) is None
+    server.close()
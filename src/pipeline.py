@@ -21,6 +21,11 @@ from functools import total_ordering
 from util import logger
 import datetime
 
+try:
+    from bindings import FrameQueue
+except ImportError:  # Tests and tools can run without the compiled extension
+    FrameQueue = None
+
 
 @dataclass
 class StateData:
@@ -101,6 +106,10 @@ class Frame(Generic[T]):
 class FramePipeline(Generic[T]):
     """ """
 
+    # Per consumer frame limit for the native queues when neither the consumer nor the
+    # pipeline sets one
+    NATIVE_QUEUE_CAPACITY = 1 << 16
+
     def __init__(
         self,
         name: str = "FramePipeline",
@@ -699,10 +708,7 @@ class FramePipeline(Generic[T]):
                     elif overflow == "block":
                         remaining = timeout
                         self.condition.wait(timeout=remaining)
-                if self.sorted_queues:
-                    self._insort_consumer_queue(consumer_queue, frame_obj)
-                else:
-                    consumer_queue.append(frame_obj)
+                self._push_consumer_queue(consumer_id, consumer_queue, frame_obj)
             for callback in self.sent_callbacks:
                 try:
                     callback(frame_obj)
@@ -721,6 +727,8 @@ class FramePipeline(Generic[T]):
         self.send(*args, **kwargs)
 
     def _consumer_queue_pop(self, consumer_id: str) -> Optional[Frame[T]]:
+        if FrameQueue is not None:
+            return self.consumers[consumer_id].receive()
         if self.sorted_queues:
             qlist: List[Frame[T]] = self.consumers[consumer_id]
             if qlist:
@@ -734,6 +742,33 @@ class FramePipeline(Generic[T]):
                 return dq.popleft()
             return None
 
+    def _return_consumer_queue(
+        self, consumer_queue: Any, frames: List[Frame[T]]
+    ) -> None:
+        """Puts frames just taken off consumer_queue back at its head, in order."""
+        if FrameQueue is not None:
+            for frame_obj in reversed(frames):
+                consumer_queue.send_front(
+                    frame_obj, frame_obj.available_at, frame_obj.priority, frame_obj.id
+                )
+        elif self.sorted_queues:
+            for frame_obj in frames:
+                self._insort_consumer_queue(consumer_queue, frame_obj)
+        else:
+            consumer_queue.extendleft(reversed(frames))
+
+    def _next_due_in(self, consumer_queue: Any) -> Optional[float]:
+        """Seconds until a sorted queue's head comes due, None if none is queued."""
+        if FrameQueue is not None:
+            next_at = consumer_queue.next_available
+            if next_at == float("inf"):
+                return None
+        elif self.sorted_queues and consumer_queue:
+            next_at = consumer_queue[0].available_at
+        else:
+            return None
+        return max(0.0, next_at - time.time())
+
     def _run_receive_interceptors(self, frame_obj: Frame[T]) -> Frame[T]:
         """
         Runs each interceptor function registered in self.receive_interceptors on the frame.
@@ -747,6 +782,34 @@ class FramePipeline(Generic[T]):
                 logger.error(f"Error in receive interceptor: {e}")
         return frame_obj
 
+    def _new_consumer_queue(self, max_queue_size: Optional[int]) -> Any:
+        if FrameQueue is not None:
+            # The native plain lane is a fixed ring, so it's sized for the most this consumer can hold
+            capacity = max_queue_size or self.maxsize or self.NATIVE_QUEUE_CAPACITY
+            return FrameQueue(self.sorted_queues, capacity)
+        return [] if self.sorted_queues else deque()
+
+    def _push_consumer_queue(
+        self, consumer_id: str, consumer_queue: Any, frame_obj: Frame[T]
+    ) -> None:
+        """Queues frame_obj for consumer_id in (available_at, priority, id) order if sorted."""
+        if FrameQueue is not None:
+            if not consumer_queue.send(
+                frame_obj,
+                frame_obj.available_at,
+                frame_obj.priority,
+                frame_obj.id,
+            ):
+                self.metrics["frames_dropped"] += 1
+                self.consumer_metrics[consumer_id]["frames_dropped"] += 1
+                logger.warning(
+                    f"Frame dropped for consumer '{consumer_id}' due to full queue."
+                )
+        elif self.sorted_queues:
+            self._insort_consumer_queue(consumer_queue, frame_obj)
+        else:
+            consumer_queue.append(frame_obj)
+
     def _insort_consumer_queue(
         self, queue_list: List[Frame[T]], frame_obj: Frame[T]
     ) -> None:
@@ -771,6 +834,60 @@ class FramePipeline(Generic[T]):
                 lo = mid + 1
         queue_list.insert(lo, frame_obj)
 
+    def _deliver(self, consumer_id: str, frame_obj: Frame[T]) -> Optional[Frame[T]]:
+        """
+        Runs a frame taken off consumer_id's queue through the filter, metrics, hooks and
+        interceptors, and acknowledges it. Returns None if the filter drops it.
+        Must be called with the condition held.
+        """
+        filter_fn = self.consumer_filters.get(consumer_id)
+        if filter_fn is not None:
+            try:
+                if not filter_fn(frame_obj):
+                    logger.debug(
+                        f"Frame {frame_obj.id} filtered out for consumer '{consumer_id}'."
+                    )
+                    return None
+            except Exception as e:
+                logger.error(f"Error applying filter for consumer '{consumer_id}': {e}")
+                return None
+
+        self.metrics["frames_received"] += 1
+        self.consumer_metrics[consumer_id]["frames_received"] += 1
+        delay_time = max(0.0, time.time() - frame_obj.available_at)
+        self.consumer_metrics[consumer_id]["total_frame_delay"] += delay_time
+        self.consumer_metrics[consumer_id]["frame_delay_count"] += 1
+        self.consumer_last_receive[consumer_id] = time.time()
+
+        for hook in self.pre_delivery_callbacks:
+            try:
+                hook(frame_obj, consumer_id)
+            except Exception as e:
+                logger.error(f"Pre-delivery hook error: {e}")
+
+        frame_obj = self._run_receive_interceptors(frame_obj)
+
+        if self.decrypt_func is not None:
+            try:
+                frame_obj.data = self.decrypt_func(frame_obj.data)
+            except Exception as e:
+                logger.error(f"Decryption error: {e}")
+
+        if frame_obj.is_response:
+            self.process_response(frame_obj)
+
+        for callback in self.received_callbacks:
+            try:
+                callback(frame_obj)
+            except Exception as e:
+                logger.error(f"Received callback error: {e}")
+
+        logger.debug(f"Frame received by {consumer_id}: {frame_obj}")
+
+        # Acknowledge the frame
+        self.acknowledge(consumer_id, frame_obj.id)
+        return frame_obj
+
     def receive(
         self, consumer_id: str, block: bool = True, timeout: Optional[float] = None
     ) -> Optional[Frame[T]]:
@@ -814,67 +931,22 @@ class FramePipeline(Generic[T]):
 
                     if frame_obj.available_at and frame_obj.available_at > time.time():
                         wait_time = frame_obj.available_at - time.time()
+                        self._return_consumer_queue(consumer_queue, [frame_obj])
                         if not block:
-                            if self.sorted_queues:
-                                self._insort_consumer_queue(consumer_queue, frame_obj)
-                            else:
-                                consumer_queue.appendleft(frame_obj)
                             return None
-                        else:
-                            self.condition.wait(timeout=wait_time)
-                            continue
-
-                    filter_fn = self.consumer_filters.get(consumer_id)
-                    if filter_fn is not None:
-                        try:
-                            if not filter_fn(frame_obj):
-                                logger.debug(
-                                    f"Frame {frame_obj.id} filtered out for consumer '{consumer_id}'."
-                                )
-                                continue
-                        except Exception as e:
-                            logger.error(
-                                f"Error applying filter for consumer '{consumer_id}': {e}"
+                        if timeout is not None:
+                            wait_time = min(
+                                wait_time, timeout - (time.monotonic() - start_time)
                             )
-                            continue
-
-                    self.metrics["frames_received"] += 1
-                    self.consumer_metrics[consumer_id]["frames_received"] += 1
-                    delay_time = max(0.0, time.time() - frame_obj.available_at)
-                    self.consumer_metrics[consumer_id][
-                        "total_frame_delay"
-                    ] += delay_time
-                    self.consumer_metrics[consumer_id]["frame_delay_count"] += 1
-                    self.consumer_last_receive[consumer_id] = time.time()
-
-                    for hook in self.pre_delivery_callbacks:
-                        try:
-                            hook(frame_obj, consumer_id)
-                        except Exception as e:
-                            logger.error(f"Pre-delivery hook error: {e}")
-
-                    frame_obj = self._run_receive_interceptors(frame_obj)
-
-                    if self.decrypt_func is not None:
-                        try:
-                            frame_obj.data = self.decrypt_func(frame_obj.data)
-                        except Exception as e:
-                            logger.error(f"Decryption error: {e}")
-
-                    if frame_obj.is_response:
-                        self.process_response(frame_obj)
-
-                    for callback in self.received_callbacks:
-                        try:
-                            callback(frame_obj)
-                        except Exception as e:
-                            logger.error(f"Received callback error: {e}")
-
-                    logger.debug(f"Frame received by {consumer_id}: {frame_obj}")
+                            if wait_time <= 0:
+                                return None
+                        self.condition.wait(timeout=wait_time)
+                        continue
 
-                    # Acknowledge the frame
-                    self.acknowledge(consumer_id, frame_obj.id)
-                    return frame_obj
+                    delivered = self._deliver(consumer_id, frame_obj)
+                    if delivered is None:
+                        continue
+                    return delivered
 
                 if not block:
                     return None
@@ -887,18 +959,62 @@ class FramePipeline(Generic[T]):
                 if timeout is not None and remaining is not None and remaining <= 0:
                     return None
 
+                # A delayed frame is queued but not yet due: wake when it is, not on the next send
+                due_in = self._next_due_in(consumer_queue)
+                if due_in is not None:
+                    remaining = due_in if remaining is None else min(remaining, due_in)
+
                 self.condition.wait(timeout=remaining)
                 if self.closed and not consumer_queue:
                     return None
 
-    def batch_receive(self, consumer_id: str, max_frames: int) -> List[Frame[T]]:
-        frames = []
-        for _ in range(max_frames):
-            f = self.receive(consumer_id, block=False)
-            if f is None:
-                break
-            frames.append(f)
-        return frames
+    def batch_receive(
+        self, consumer_id: str, max_frames: int, timeout: Optional[float] = None
+    ) -> List[Frame[T]]:
+        """
+        Receives up to max_frames frames for consumer_id, waiting up to timeout seconds for
+        the first one if given.
+
+        With the extension the batch comes off the consumer's FrameQueue in one call, and the
+        wait happens natively with neither the GIL nor the pipeline lock held. Rate limited
+        consumers still receive one frame at a time.
+        """
+        if max_frames <= 0:
+            return []
+        consumer_queue = self.consumers.get(consumer_id)
+        rate_limit = self.consumer_rate_limits.get(consumer_id, float("inf"))
+        if FrameQueue is None or consumer_queue is None or rate_limit != float("inf"):
+            frames = []
+            for i in range(max_frames):
+                f = self.receive(
+                    consumer_id,
+                    block=timeout is not None and i == 0,
+                    timeout=timeout,
+                )
+                if f is None:
+                    break
+                frames.append(f)
+            return frames
+
+        if self.consumer_status.get(consumer_id, False):
+            return []
+        due = consumer_queue.batch_receive(max_frames, timeout or 0.0)
+        with self.condition:
+            if self.consumer_status.get(consumer_id, False):
+                # Paused while waiting
+                self._return_consumer_queue(consumer_queue, due)
+                return []
+            frames = []
+            now = time.time()
+            for frame_obj in due:
+                if frame_obj.expire_at is not None and now > frame_obj.expire_at:
+                    self.metrics["frames_expired"] += 1
+                    self.consumer_metrics[consumer_id]["frames_expired"] += 1
+                    continue
+                delivered = self._deliver(consumer_id, frame_obj)
+                if delivered is not None:
+                    frames.append(delivered)
+            return frames
 
     def iterate_frames(
         self, consumer_id: str, timeout: Optional[float] = None
@@ -913,7 +1029,16 @@ class FramePipeline(Generic[T]):
         now = time.time()
         with self.condition:
             for cid, q in self.consumers.items():
-                if self.sorted_queues:
+                if FrameQueue is not None:
+                    queued = q.take_all()
+                    for f in queued:
+                        if f.expire_at is None or now <= f.expire_at:
+                            self._push_consumer_queue(cid, q, f)
+                    dropped = len(queued) - len(q)
+                    if dropped > 0:
+                        self.metrics["frames_expired"] += dropped
+                        self.consumer_metrics[cid]["frames_expired"] += dropped
+                elif self.sorted_queues:
                     new_q = [f for f in q if f.expire_at is None or now <= f.expire_at]
                     dropped = len(q) - len(new_q)
                     if dropped > 0:
@@ -1079,10 +1204,7 @@ class FramePipeline(Generic[T]):
         with self.lock:
             if consumer_id in self.consumers:
                 raise ValueError(f"Consumer '{consumer_id}' is already registered.")
-            if self.sorted_queues:
-                self.consumers[consumer_id] = []
-            else:
-                self.consumers[consumer_id] = deque()
+            self.consumers[consumer_id] = self._new_consumer_queue(max_queue_size)
             self.consumer_filters[consumer_id] = filter_fn
             self.consumer_status[consumer_id] = False
             self.consumer_maxsize[consumer_id] = max_queue_size
@@ -1268,6 +1390,9 @@ class FramePipeline(Generic[T]):
     def close(self) -> None:
         with self.condition:
             self.closed = True
+            if FrameQueue is not None:
+                for q in self.consumers.values():
+                    q.close()
             self.condition.notify_all()
         self.clear()
         logger.info("Pipeline closed.")
@@ -1535,6 +1660,61 @@ def test_pre_send_and_pre_delivery_hooks():
     pipeline.close()
 
 
+native_queue = pytest.mark.skipif(
+    FrameQueue is None, reason="needs FrameQueue from the bindings extension"
+)
+
+
+@native_queue
+def test_native_delayed_frame():
+    pipeline = FramePipeline[int](enable_delayed_delivery=True)
+    pipeline.register_consumer("consumer1")
+    pipeline.send(1, delay=0.3)
+    assert pipeline.receive("consumer1", block=False) is None
+    start = time.monotonic()
+    # Nothing else is sent, so only the frame's own due time can wake this
+    frame = pipeline.receive("consumer1", block=True, timeout=2)
+    elapsed = time.monotonic() - start
+    assert frame is not None and frame.data == 1
+    assert 0.2 < elapsed < 1.0
+    pipeline.close()
+
+
+@native_queue
+def test_native_priority_order():
+    pipeline = FramePipeline[int](enable_delayed_delivery=True)
+    pipeline.register_consumer("consumer1")
+    for i, delay in enumerate([0.3, 0.1, 0.2, 0.0]):
+        pipeline.send(i, delay=delay)
+    time.sleep(0.4)
+    frames = pipeline.batch_receive("consumer1", 4)
+    assert [f.data for f in frames] == [3, 1, 2, 0]
+    pipeline.close()
+
+
+@native_queue
+def test_native_repush_keeps_order():
+    pipeline = FramePipeline[int]()
+    pipeline.register_consumer("consumer1")
+    for i in range(3):
+        pipeline.send(i)
+    received: List[Frame[int]] = []
+    with pipeline.condition:
+        t = threading.Thread(
+            target=lambda: received.extend(pipeline.batch_receive("consumer1", 2))
+        )
+        t.start()
+        # It takes frames 0 and 1 off the queue, then waits here for the lock
+        time.sleep(0.2)
+        pipeline.pause_consumer("consumer1")
+    t.join()
+    assert received == []
+    pipeline.resume_consumer("consumer1")
+    frames = pipeline.batch_receive("consumer1", 3)
+    assert [f.data for f in frames] == [0, 1, 2]
+    pipeline.close()
+
+
 class FrameListener:
     def __init__(
         self,
@@ -0,0 +1,98 @@
+#include "asset_loader.h"
+#include <chrono>
+
+AssetLoader::AssetLoader() : worker(&AssetLoader::_work, this) {}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    worker.join();
+    // Destroying the closures frees whatever they decoded, so do it on the thread that owns SDL
+    decoded.clear();
+}
+
+int AssetLoader::request(Decode decode) {
+    int handle;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        handle = static_cast<int>(statuses.size());
+        statuses.push_back(Status());
+        jobs.push_back({ handle, std::move(decode) });
+        inFlight++;
+    }
+    wake.notify_one();
+    return handle;
+}
+
+int AssetLoader::resolved(int id) {
+    std::lock_guard<std::mutex> guard(lock);
+    statuses.push_back({ id >= 0 ? AssetState::Ready : AssetState::Failed, id });
+    return static_cast<int>(statuses.size() - 1);
+}
+
+void AssetLoader::_work() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [this] { return stopping || !jobs.empty(); });
+        if (stopping) return;
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+
+        guard.unlock();
+        Upload upload = job.decode();
+        job.decode = nullptr; // Whatever it captured goes now rather than with the next job
+        guard.lock();
+
+        inFlight--;
+        if (upload) {
+            decoded.push_back({ job.handle, std::move(upload) });
+        } else {
+            statuses[job.handle].state = AssetState::Failed;
+        }
+    }
+}
+
+void AssetLoader::_finish(int handle, int id) {
+    std::lock_guard<std::mutex> guard(lock);
+    statuses[handle] = { id >= 0 ? AssetState::Ready : AssetState::Failed, id };
+}
+
+size_t AssetLoader::upload(double budgetSeconds) {
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    size_t uploaded = 0;
+    while (true) {
+        Decoded next;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (decoded.empty()) break;
+            next = std::move(decoded.front());
+            decoded.pop_front();
+        }
+        _finish(next.handle, next.upload());
+        uploaded++;
+        if (std::chrono::duration<double>(Clock::now() - start).count() >= budgetSeconds) break;
+    }
+    return uploaded;
+}
+
+AssetState AssetLoader::state(int handle) const {
+    std::lock_guard<std::mutex> guard(lock);
+    if (handle < 0 || handle >= static_cast<int>(statuses.size())) return AssetState::Failed;
+    return statuses[handle].state;
+}
+
+int AssetLoader::id(int handle) const {
+    std::lock_guard<std::mutex> guard(lock);
+    if (handle < 0 || handle >= static_cast<int>(statuses.size())) return -1;
+    return statuses[handle].id;
+}
+
+size_t AssetLoader::pending() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return inFlight + decoded.size();
+}
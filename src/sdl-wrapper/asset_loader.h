@@ -0,0 +1,77 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <SDL.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class AssetState : Uint8 {
+    Pending, // Queued or decoding
+    Ready,   // Uploaded; the request's id is valid
+    Failed
+};
+
+// Decodes assets on one background thread and hands them back to the render thread for upload. A
+// request is a decode step run on the worker, which returns the upload step to run on the render
+// thread; uploads only happen inside upload(), so nothing touches the renderer off its thread.
+// Handles count up from 0 and are never reused.
+class AssetLoader {
+public:
+    // Runs on the render thread and returns the asset's id, or -1 on failure
+    using Upload = std::function<int()>;
+    // Runs on the worker; an empty Upload means the decode failed
+    using Decode = std::function<Upload()>;
+
+    AssetLoader();
+    // Drops whatever hasn't been uploaded yet and joins the worker
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    int request(Decode decode);
+    // A request that's already done, e.g. for an asset that was loaded before
+    int resolved(int id);
+
+    // Runs finished uploads oldest first until budgetSeconds has been spent, always at least one so a
+    // single large asset can't stall forever. Returns how many ran.
+    size_t upload(double budgetSeconds);
+
+    AssetState state(int handle) const;
+    // The id the upload produced, -1 until the request is Ready
+    int id(int handle) const;
+    // Requests still decoding or waiting for upload
+    size_t pending() const;
+
+private:
+    struct Status {
+        AssetState state = AssetState::Pending;
+        int id = -1;
+    };
+    struct Job {
+        int handle;
+        Decode decode;
+    };
+    struct Decoded {
+        int handle;
+        Upload upload;
+    };
+
+    mutable std::mutex lock;
+    std::condition_variable wake;
+    std::deque<Job> jobs;
+    std::deque<Decoded> decoded;
+    std::vector<Status> statuses; // Indexed by handle
+    size_t inFlight = 0;          // Jobs plus the one being decoded
+    bool stopping = false;
+    std::thread worker;
+
+    void _work();
+    void _finish(int handle, int id);
+};
+
+#endif
@@ -0,0 +1,274 @@
+#include "battle.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+    // Tiles around an enemy troop that get_target considers standing on, in its order
+    constexpr int AdjacentX[4] = { 0, 0, 1, -1 };
+    constexpr int AdjacentY[4] = { -1, 1, 0, 0 };
+}
+
+BattleSim::BattleSim(int width, int height, int tickRate)
+    : rate(std::max(tickRate, 1)), pathfinder(width, height), spatial(width, height) {}
+
+bool BattleSim::setTiles(const Uint8* tiles, size_t count) {
+    return pathfinder.grid().setTiles(tiles, count);
+}
+
+int BattleSim::addTower(int x, int y, int side, TowerKind kind, int hitpoints) {
+    towerX.push_back(x);
+    towerY.push_back(y);
+    towerHp.push_back(hitpoints);
+    towerOwner.push_back(static_cast<Uint8>(side));
+    towerKind.push_back(kind);
+    // Units stop two tiles in front of the tower, on the side facing the river
+    towerField.push_back(pathfinder.flowField(x, y + (side == 1 ? -2 : 2)));
+    return static_cast<int>(towerHp.size() - 1);
+}
+
+Uint32 BattleSim::_cooldownTicks(float seconds) const {
+    // A missing attack speed means the unit never attacks
+    if (seconds <= 0.0f) return UINT32_MAX;
+    return static_cast<Uint32>(std::floor(seconds * static_cast<float>(rate)));
+}
+
+int BattleSim::spawn(const BattleUnitSpec& spec) {
+    int slot;
+    if (!freeSlots.empty()) {
+        // Lowest first keeps slot numbers compact for the snapshot
+        auto lowest = std::min_element(freeSlots.begin(), freeSlots.end());
+        slot = *lowest;
+        freeSlots.erase(lowest);
+    } else {
+        slot = static_cast<int>(hp.size());
+        for (auto* column : { &posX, &posY, &hp, &damage, &targetIndex, &targetSteps, &nextX, &nextY }) {
+            column->push_back(0);
+        }
+        range.push_back(0.0f);
+        attackCooldown.push_back(0);
+        moveCooldown.push_back(0);
+        lastAttack.push_back(0);
+        lastMove.push_back(0);
+        owner.push_back(0);
+        mobile.push_back(0);
+        alive.push_back(0);
+        layer.push_back(0);
+        targets.push_back(0);
+        targetKind.push_back(0);
+    }
+
+    posX[slot] = spec.x;
+    posY[slot] = spec.y;
+    hp[slot] = spec.hitpoints;
+    damage[slot] = spec.damage;
+    range[slot] = spec.range;
+    attackCooldown[slot] = _cooldownTicks(spec.attackSeconds);
+    // MovementSpeed.NONE is 9999 seconds, which this also covers
+    moveCooldown[slot] = _cooldownTicks(spec.moveSeconds);
+    lastAttack[slot] = currentTick;
+    lastMove[slot] = currentTick;
+    owner[slot] = static_cast<Uint8>(spec.owner);
+    mobile[slot] = spec.mobile ? 1 : 0;
+    alive[slot] = 1;
+    layer[slot] = spec.layer;
+    targets[slot] = spec.targets;
+    targetKind[slot] = static_cast<Uint8>(TargetKind::None);
+    targetIndex[slot] = -1;
+    targetSteps[slot] = -1;
+    nextX[slot] = -1;
+    nextY[slot] = -1;
+    order.push_back(slot);
+    return slot;
+}
+
+void BattleSim::_attack(int slot) {
+    const TargetKind kind = static_cast<TargetKind>(targetKind[slot]);
+    if (kind == TargetKind::None || range[slot] <= 0.0f) return;
+    // An empty path counts as -1 steps, which is always in range
+    if (!(static_cast<float>(targetSteps[slot]) < range[slot])) return;
+    if (damage[slot] == 0 || attackCooldown[slot] == UINT32_MAX) return;
+
+    const int target = targetIndex[slot];
+    if (target < 0) return;
+    int* victim = kind == TargetKind::Troop ? &hp[target] : &towerHp[target];
+    if (kind == TargetKind::Troop && !alive[target]) return;
+    if (*victim <= 0 || !_elapsed(lastAttack[slot], attackCooldown[slot])) return;
+
+    lastAttack[slot] = currentTick;
+    *victim -= damage[slot];
+}
+
+void BattleSim::_acquire(int slot) {
+    const int x = posX[slot], y = posY[slot];
+    const TileGrid& grid = pathfinder.grid();
+    targetKind[slot] = static_cast<Uint8>(TargetKind::None);
+    targetIndex[slot] = -1;
+    targetSteps[slot] = -1;
+    nextX[slot] = nextY[slot] = -1;
+
+    const int found = spatial.nearest(x, y, owner[slot], targets[slot], -1);
+    if (found != -1) {
+        const int enemy = order[found];
+        int bestX = 0, bestY = 0, bestDistance = INT_MAX;
+        for (int d = 0; d < 4; d++) {
+            const int ax = posX[enemy] + AdjacentX[d], ay = posY[enemy] + AdjacentY[d];
+            if (!grid.inBounds(ax, ay) || grid.at(ax, ay) != TileEmpty) continue;
+            const int distance = std::abs(x - ax) + std::abs(y - ay);
+            if (distance < bestDistance) {
+                bestX = ax;
+                bestY = ay;
+                bestDistance = distance;
+            }
+        }
+        if (bestDistance == INT_MAX) return;
+
+        pathfinder.findPath(x, y, bestX, bestY, path);
+        targetKind[slot] = static_cast<Uint8>(TargetKind::Troop);
+        targetIndex[slot] = enemy;
+        targetSteps[slot] = static_cast<int>(path.size() / 2) - 1;
+        if (path.size() >= 4) {
+            nextX[slot] = path[2];
+            nextY[slot] = path[3];
+        }
+        return;
+    }
+
+    // Otherwise a tower of the unit's owner, as get_target picks them: the King only once at most one
+    // Princess Tower is left standing
+    int princesses = 0;
+    for (size_t t = 0; t < towerHp.size(); t++) {
+        if (towerOwner[t] == owner[slot] && towerHp[t] > 0 && towerKind[t] == TowerKind::Princess) {
+            princesses++;
+        }
+    }
+    int best = -1, bestDistance = INT_MAX;
+    for (size_t t = 0; t < towerHp.size(); t++) {
+        if (towerOwner[t] != owner[slot] || towerHp[t] <= 0) continue;
+        if (towerKind[t] == TowerKind::King && princesses > 1) continue;
+        const int distance = std::abs(x - towerX[t]) + std::abs(y - towerY[t]);
+        if (distance < bestDistance) {
+            best = static_cast<int>(t);
+            bestDistance = distance;
+        }
+    }
+    if (best == -1) return;
+
+    const FlowField* field = pathfinder.flow(towerField[best]);
+    if (!field || grid.at(field->goalX(), field->goalY()) != TileEmpty) return;
+
+    targetKind[slot] = static_cast<Uint8>(TargetKind::Tower);
+    targetIndex[slot] = best;
+    if (!grid.inBounds(x, y)) return;
+    const int cell = y * grid.width() + x;
+    targetSteps[slot] = field->steps(cell);
+    const int next = field->next(cell);
+    if (next != -1) {
+        nextX[slot] = next % grid.width();
+        nextY[slot] = next / grid.width();
+    }
+}
+
+void BattleSim::_move(int slot) {
+    if (targetKind[slot] == static_cast<Uint8>(TargetKind::None) || targetSteps[slot] < 1 || !mobile[slot]) return;
+    if (range[slot] <= 0.0f || static_cast<float>(targetSteps[slot]) < range[slot]) return;
+    if (!_elapsed(lastMove[slot], moveCooldown[slot])) return;
+
+    posX[slot] = nextX[slot];
+    posY[slot] = nextY[slot];
+    lastMove[slot] = currentTick;
+}
+
+void BattleSim::_reap() {
+    size_t kept = 0;
+    for (size_t k = 0; k < order.size(); k++) {
+        const int slot = order[k];
+        if (hp[slot] > 0) {
+            order[kept++] = slot;
+            continue;
+        }
+        alive[slot] = 0;
+        freeSlots.push_back(slot);
+    }
+    order.resize(kept);
+
+    // Anything still aimed at a removed troop loses it, like a uuid lookup that no longer matches
+    for (int slot : order) {
+        const int target = targetIndex[slot];
+        if (targetKind[slot] == static_cast<Uint8>(TargetKind::Troop) && target >= 0 && !alive[target]) {
+            targetIndex[slot] = -1;
+        }
+    }
+}
+
+void BattleSim::step() {
+    currentTick++;
+
+    for (int slot : order) {
+        _attack(slot);
+    }
+
+    // Indexed by position in order so nearest's lowest-id tie break follows deploy order
+    spatial.clear();
+    for (size_t k = 0; k < order.size(); k++) {
+        const int slot = order[k];
+        if (hp[slot] > 0) {
+            spatial.insert(static_cast<int>(k), posX[slot], posY[slot], owner[slot], layer[slot]);
+        }
+    }
+
+    for (int slot : order) {
+        _acquire(slot);
+        _move(slot);
+    }
+
+    _reap();
+}
+
+int BattleSim::winner() const {
+    for (int side = 0; side < 2; side++) {
+        for (size_t t = 0; t < towerHp.size(); t++) {
+            if (towerOwner[t] != side && towerKind[t] == TowerKind::King && towerHp[t] <= 0) {
+                return side;
+            }
+        }
+    }
+    return -1;
+}
+
+void BattleSim::snapshot(std::vector<BattleUnitRecord>& out) const {
+    out.resize(hp.size());
+    for (size_t i = 0; i < hp.size(); i++) {
+        BattleUnitRecord& r = out[i];
+        r.x = posX[i];
+        r.y = posY[i];
+        r.hitpoints = hp[i];
+        r.target = targetIndex[i];
+        r.steps = targetSteps[i];
+        r.nextX = nextX[i];
+        r.nextY = nextY[i];
+        r.alive = alive[i];
+        r.targetKind = targetKind[i];
+    }
+}
+
+Uint32 BattleSim::checksum() const {
+    Uint32 hash = 2166136261u;
+    auto mix = [&hash](Uint64 value) {
+        for (int i = 0; i < 8; i++) {
+            hash = (hash ^ static_cast<Uint8>(value >> (8 * i))) * 16777619u;
+        }
+    };
+    mix(currentTick);
+    for (int slot : order) {
+        mix(static_cast<Uint64>(slot));
+        mix(static_cast<Uint32>(posX[slot]) | (static_cast<Uint64>(static_cast<Uint32>(posY[slot])) << 32));
+        mix(static_cast<Uint32>(hp[slot]) | (static_cast<Uint64>(static_cast<Uint32>(targetIndex[slot])) << 32));
+        mix(lastAttack[slot] ^ (lastMove[slot] << 32));
+    }
+    for (int towerHitpoints : towerHp) {
+        mix(static_cast<Uint32>(towerHitpoints));
+    }
+    return hash;
+}
@@ -0,0 +1,117 @@
+#ifndef BATTLE_H
+#define BATTLE_H
+
+#include "pathfinding.h"
+#include "spatial.h"
+#include <SDL.h>
+#include <vector>
+
+enum class TowerKind : Uint8 {
+    King,
+    Princess
+};
+
+enum class TargetKind : Uint8 {
+    None,
+    Troop,
+    Tower
+};
+
+// A tower as added with addTower, with its current hitpoints
+struct BattleTower {
+    int x, y;
+    int owner;
+    TowerKind kind;
+    int hitpoints;
+};
+
+// What a deployed card needs for simulation, with the Optional card fields as 0
+struct BattleUnitSpec {
+    int x = 0, y = 0;
+    int owner = 0;
+    int hitpoints = 0;
+    int damage = 0;
+    float range = 0.0f;
+    float attackSeconds = 0.0f; // Card.attack_speed
+    float moveSeconds = 0.0f;   // MovementSpeed.to_num
+    Uint32 layer = 0;           // Bit for the unit's own layer
+    Uint32 targets = 0;         // Bits for the layers it attacks
+    bool mobile = false;        // Troops move, buildings don't
+};
+
+// One slot of BattleSim state, laid out for a NumPy structured array
+struct BattleUnitRecord {
+    Sint32 x, y;
+    Sint32 hitpoints;
+    Sint32 target; // Unit slot or tower index, -1 if none or it has since died
+    Sint32 steps;  // Moves to the target's attack tile (len(path) - 1), -1 without a route
+    Sint32 nextX, nextY;
+    Uint8 alive;
+    Uint8 targetKind;
+};
+
+// The match simulation from Arena.tick and card_tick, stepped at a fixed rate over flat per-unit arrays.
+// Cooldowns are counted in ticks rather than wall-clock timestamps; like is_time_elapsed a cooldown has
+// passed once strictly more than its duration has elapsed. Units live in slots that are reused after
+// death, and are processed in deploy order so ties resolve the way the Python list did.
+class BattleSim {
+public:
+    BattleSim(int width, int height, int tickRate);
+
+    bool setTiles(const Uint8* tiles, size_t count);
+    int addTower(int x, int y, int owner, TowerKind kind, int hitpoints);
+    // Returns the slot, taking the lowest freed one first
+    int spawn(const BattleUnitSpec& spec);
+
+    // Attacks with last step's targets, then retargets and moves every unit, then removes the dead
+    void step();
+
+    const TileGrid& grid() const { return pathfinder.grid(); }
+    Uint64 tick() const { return currentTick; }
+    int tickRate() const { return rate; }
+    size_t slotCount() const { return hp.size(); }
+    size_t aliveCount() const { return order.size(); }
+    int towerHitpoints(int tower) const { return towerHp[tower]; }
+    size_t towerCount() const { return towerHp.size(); }
+    BattleTower tower(int t) const { return { towerX[t], towerY[t], towerOwner[t], towerKind[t], towerHp[t] }; }
+    // The owner whose opponent has lost their King Tower, -1 while the match is undecided
+    int winner() const;
+
+    void snapshot(std::vector<BattleUnitRecord>& out) const;
+    // FNV-1a over the tick, every living unit and the towers, for spotting where two runs diverge
+    Uint32 checksum() const;
+
+private:
+    int rate;
+    Uint64 currentTick = 0;
+    GridPathfinder pathfinder;
+    SpatialGrid spatial;
+    std::vector<int> path;
+
+    // Per-unit state, indexed by slot
+    std::vector<int> posX, posY, hp, damage;
+    std::vector<float> range;
+    std::vector<Uint32> attackCooldown, moveCooldown; // Ticks, with UINT32_MAX for never
+    std::vector<Uint64> lastAttack, lastMove;
+    std::vector<Uint8> owner, mobile, alive;
+    std::vector<Uint32> layer, targets;
+    std::vector<Uint8> targetKind;
+    std::vector<int> targetIndex, targetSteps, nextX, nextY;
+    std::vector<int> order;    // Living slots in deploy order
+    std::vector<int> freeSlots;
+
+    // Per-tower state
+    std::vector<int> towerX, towerY, towerHp;
+    std::vector<Uint8> towerOwner;
+    std::vector<TowerKind> towerKind;
+    std::vector<int> towerField; // Flow field toward each tower's attack tile, -1 if it has none
+
+    Uint32 _cooldownTicks(float seconds) const;
+    bool _elapsed(Uint64 since, Uint32 cooldown) const { return currentTick - since > cooldown; }
+    void _attack(int slot);
+    void _acquire(int slot);
+    void _move(int slot);
+    void _reap();
+};
+
+#endif
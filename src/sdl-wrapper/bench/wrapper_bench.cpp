@@ -0,0 +1,209 @@
+// Micro-benchmarks for the SDLWrapper primitives, run on the headless software renderer. Prints one JSON document to stdout so runs can be diffed across commits:
+//
+//     make bench > bench.json
+//
+// Each case draws `ops` primitives per frame for a few frames and reports the median ns per
+// primitive, present included, and how many wrapper draw calls reached SDL per primitive (from
+// the frame profiler). Usage: wrapper_bench [font path] [frames]
+#include "../wrapper.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr int Width = 1024;
+constexpr int Height = 768;
+
+struct Result {
+    std::string name;
+    int param;          // Size, radius, vertex count, text length or batch count, depending on the case
+    int ops;            // Primitives drawn per frame
+    double nsPerOp;
+    double drawCallsPerOp;
+};
+
+Uint32 drawCalls(const FrameRecord& r) {
+    return r.fillRects + r.drawRects + r.lines + r.points + r.circles + r.polygons + r.geometry + r.meshes
+        + r.textures + r.texts + r.labels + r.batchCommands + r.spriteDrawCalls;
+}
+
+class Bench {
+public:
+    Bench(SDLWrapper& sdl, int frames) : sdl(sdl), frames(frames) {}
+
+    // frame draws all `ops` primitives of one frame
+    void run(const std::string& name, int param, int ops, const std::function<void()>& frame) {
+        const double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+        sdl.clearScreen(0, 0, 0);
+        frame(); // Warm up caches, atlases and scratch buffers
+        sdl.updateScreen();
+
+        std::vector<double> seconds;
+        Uint32 calls = 0;
+        for (int i = 0; i < frames; i++) {
+            sdl.clearScreen(0, 0, 0);
+            sdl.updateScreen();
+            const Uint64 start = SDL_GetPerformanceCounter();
+            frame();
+            sdl.updateScreen(); // SDL queues render commands, so the work may only happen here
+            seconds.push_back(static_cast<double>(SDL_GetPerformanceCounter() - start) / frequency);
+            calls = drawCalls(sdl.getProfiler().frames().back());
+        }
+        std::nth_element(seconds.begin(), seconds.begin() + seconds.size() / 2, seconds.end());
+        const double median = seconds[seconds.size() / 2];
+        results.push_back({ name, param, ops, median * 1e9 / ops, static_cast<double>(calls) / ops });
+    }
+
+    void print(const char* renderer) const {
+        std::printf("{\n  \"renderer\": \"%s\",\n  \"width\": %d,\n  \"height\": %d,\n  \"frames\": %d,\n  \"results\": [",
+                    renderer, Width, Height, frames);
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            std::printf("%s\n    {\"name\": \"%s\", \"param\": %d, \"ops\": %d, \"ns_per_op\": %.1f, \"draw_calls_per_op\": %.4f}",
+                        i ? "," : "", r.name.c_str(), r.param, r.ops, r.nsPerOp, r.drawCallsPerOp);
+        }
+        std::printf("\n  ]\n}\n");
+    }
+
+private:
+    SDLWrapper& sdl;
+    int frames;
+    std::vector<Result> results;
+};
+
+// Scattered positions so the cases aren't all drawing over one pixel
+int px(int i, int size) { return (i * 7919) % std::max(1, Width - size); }
+int py(int i, int size) { return (i * 104729) % std::max(1, Height - size); }
+
+std::vector<std::pair<int, int>> regularPolygon(int vertices, int radius) {
+    std::vector<std::pair<int, int>> points;
+    for (int i = 0; i < vertices; i++) {
+        const double angle = 2.0 * 3.14159265358979323846 * i / vertices;
+        points.push_back({ static_cast<int>(radius * std::cos(angle)), static_cast<int>(radius * std::sin(angle)) });
+    }
+    return points;
+}
+
+// count size x size rects cycling through `colors` colours in submission order
+std::vector<int> rectRows(int count, int size, int colors) {
+    std::vector<int> rows;
+    rows.reserve(count * 7);
+    for (int i = 0; i < count; i++) {
+        const int c = i % colors;
+        rows.insert(rows.end(), { px(i, size), py(i, size), size, size, (c * 37) & 0xFF, (c * 91) & 0xFF, (c * 53) & 0xFF });
+    }
+    return rows;
+}
+}
+
+int main(int argc, char** argv) {
+    const std::string fontPath = argc > 1 ? argv[1] : "../SourceSansPro-Regular.otf";
+    const int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 7;
+
+    SDLWrapper sdl(Width, Height, "wrapper_bench");
+    if (!sdl.initialize(true) || !sdl.createHeadlessRenderer()) return 1;
+    SDL_Renderer* renderer = sdl.getRenderer();
+    SDL_RendererInfo info;
+    SDL_GetRendererInfo(renderer, &info);
+    sdl.setProfiling(true);
+
+    Bench bench(sdl, frames);
+    const int ops = 1000;
+
+    for (int size : { 4, 32, 256 }) {
+        bench.run("fillRect", size, ops, [&] {
+            for (int i = 0; i < ops; i++) sdl.fillRect(px(i, size), py(i, size), size, size, 200, i & 0xFF, 40);
+        });
+    }
+    // Both fillCircle rasterisers side by side, from unit-sized to screen-sized. Fewer of the largest:
+    // drawn per pixel, each is ~200k points
+    for (int radius : { 4, 16, 64, 256 }) {
+        const int circles = radius > 64 ? ops / 10 : ops;
+        for (CircleFillMode mode : { CircleFillMode::PerPixel, CircleFillMode::Scanline }) {
+            bench.run(mode == CircleFillMode::PerPixel ? "fillCircle/perPixel" : "fillCircle/scanline", radius, circles, [&] {
+                for (int i = 0; i < circles; i++) {
+                    sdl.fillCircle(px(i, 2 * radius) + radius, py(i, 2 * radius) + radius, radius, 40, 200, i & 0xFF, mode);
+                }
+            });
+        }
+        bench.run("drawCircle", radius, ops, [&] {
+            for (int i = 0; i < ops; i++) sdl.drawCircle(px(i, 2 * radius) + radius, py(i, 2 * radius) + radius, radius, 40, 200, i & 0xFF);
+        });
+    }
+    for (int vertices : { 3, 16, 128 }) {
+        const std::vector<std::pair<int, int>> shape = regularPolygon(vertices, 48);
+        std::vector<std::pair<int, int>> points(shape.size());
+        bench.run("drawPolygon", vertices, ops, [&] {
+            for (int i = 0; i < ops; i++) {
+                const int x = px(i, 96) + 48, y = py(i, 96) + 48;
+                for (size_t v = 0; v < shape.size(); v++) points[v] = { x + shape[v].first, y + shape[v].second };
+                sdl.drawPolygon(points, 255, 255, 255);
+            }
+        });
+    }
+
+    const int font = sdl.openFont(fontPath, 18);
+    if (font >= 0) {
+        for (int length : { 8, 64 }) {
+            const std::string text(length, 'x');
+            bench.run("drawText", length, ops, [&] {
+                for (int i = 0; i < ops; i++) sdl.drawText(font, text, px(i, 0), py(i, 24), 255, 255, 255);
+            });
+        }
+    } else {
+        std::fprintf(stderr, "wrapper_bench: no font at %s, skipping drawText\n", fontPath.c_str());
+    }
+
+    // The same rects one call each and through the batch, with few and many colours
+    for (int count : { 100, 1000, 10000 }) {
+        for (int colors : { 4, 256 }) {
+            const std::vector<int> rows = rectRows(count, 16, colors);
+            bench.run(colors == 4 ? "fillRect/4colors" : "fillRect/256colors", count, count, [&] {
+                for (int i = 0; i < count; i++) {
+                    const int* row = &rows[i * 7];
+                    sdl.fillRect(row[0], row[1], row[2], row[3], row[4], row[5], row[6]);
+                }
+            });
+            bench.run(colors == 4 ? "submitRects/4colors" : "submitRects/256colors", count, count, [&] {
+                sdl.beginBatch();
+                sdl.submitRects(rows.data(), count);
+                sdl.flush();
+            });
+            bench.run(colors == 4 ? "submitRects/4colors/sorted" : "submitRects/256colors/sorted", count, count, [&] {
+                sdl.beginBatch();
+                sdl.submitRects(rows.data(), count, true);
+                sdl.flush();
+            });
+        }
+        const std::vector<int> lines = rectRows(count, 16, 4);
+        bench.run("submitLines", count, count, [&] {
+            sdl.beginBatch();
+            sdl.submitLines(lines.data(), count);
+            sdl.flush();
+        });
+    }
+
+    std::vector<Uint8> pixels(16 * 16 * 4, 255);
+    const int sprite = sdl.createSprite(pixels.data(), 16, 16);
+    if (sprite >= 0) {
+        for (int count : { 100, 1000, 10000 }) {
+            std::vector<int> rows;
+            rows.reserve(count * SpriteBatch::RowWidth);
+            for (int i = 0; i < count; i++) {
+                rows.insert(rows.end(), { sprite, px(i, 16), py(i, 16), -1, -1, 255, 255, 255, 255, i % 2 });
+            }
+            bench.run("submitSprites", count, count, [&] {
+                sdl.beginBatch();
+                sdl.submitSprites(rows.data(), count);
+                sdl.flush();
+            });
+        }
+    }
+
+    bench.print(info.name);
+    return 0;
+}
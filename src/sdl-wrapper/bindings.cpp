@@ -0,0 +1,1233 @@
+#include "SDL_mouse.h"
+#include "wrapper.h" // Your SDLWrapper header file
+#include "pathfinding.h"
+#include "spatial.h"
+#include "battle.h"
+#include "match_record.h"
+#include "matchmaking_index.h"
+#include "scheduler.h"
+#include "packet_codec.h"
+#include "delta_sync.h"
+#include "frame_reader.h"
+#include "event_loop.h"
+#include "frame_queue.h"
+#include "tile_layer.h"
+#include <pybind11/pybind11.h>
+#include <SDL_render.h> // You might need this for other functions
+#include <SDL_surface.h> // Likely this one for SDL_Texture definition
+#include "SDL_stdinc.h"
+#include <cmath> // For circle drawing
+#include <SDL.h>
+#include <SDL_ttf.h> // For text rendering
+#include <SDL_image.h> // For image loading (if you use it)
+#include <string>
+#include <vector>
+#include <cstring> // For copying frames out
+#include <utility> // For std::pair
+#include <pybind11/stl.h> // Include for STL container support
+#include <pybind11/numpy.h> // For contiguous batch buffers
+#include <optional>
+#include <cstdint> // For std::uintptr_t
+
+namespace py = pybind11;
+
+using RowArray = py::array_t<int, py::array::c_style | py::array::forcecast>;
+using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+// Validates (N, 3) vertices, (M, 3) indices and a 4x4 matrix before handing them to SDLWrapper::drawMesh
+static void drawMeshArrays(SDLWrapper& self, const FloatArray& vertices, const RowArray& indices, const FloatArray& mvp,
+                           Uint8 r, Uint8 g, Uint8 b, MeshMode mode, CullMode cull, float lineWidth) {
+    if (vertices.ndim() != 2 || vertices.shape(1) != 3) {
+        throw py::value_error("Expected an (N, 3) array of vertex positions");
+    }
+    if (indices.size() != 0 && (indices.ndim() != 2 || indices.shape(1) != 3)) {
+        throw py::value_error("Expected an (M, 3) array of triangle indices");
+    }
+    if (mvp.ndim() != 2 || mvp.shape(0) != 4 || mvp.shape(1) != 4) {
+        throw py::value_error("Expected a 4x4 model-view-projection matrix");
+    }
+    if (indices.size() == 0) return;
+    self.drawMesh(vertices.data(), static_cast<size_t>(vertices.shape(0)),
+                  indices.data(), static_cast<size_t>(indices.shape(0)),
+                  mvp.data(), r, g, b, mode, cull, lineWidth);
+}
+
+using ColorArray = py::array_t<Uint8, py::array::c_style | py::array::forcecast>;
+
+// BattleSim.spawn and MatchRecorder.deploy take the same keyword arguments
+static BattleUnitSpec battleSpec(int x, int y, int owner, int hitpoints, int damage, float range,
+                                 float attackSeconds, float moveSeconds, Uint32 layer, Uint32 targets, bool mobile) {
+    BattleUnitSpec spec;
+    spec.x = x;
+    spec.y = y;
+    spec.owner = owner;
+    spec.hitpoints = hitpoints;
+    spec.damage = damage;
+    spec.range = range;
+    spec.attackSeconds = attackSeconds;
+    spec.moveSeconds = moveSeconds;
+    spec.layer = layer;
+    spec.targets = targets;
+    spec.mobile = mobile;
+    return spec;
+}
+
+// MatchReplay has no simulation to step or read until a load succeeds
+static void requireLoaded(const MatchReplay& replay) {
+    if (!replay.isLoaded()) {
+        throw py::value_error("No replay is loaded; call load first");
+    }
+}
+
+// Validates (N, 2) positions, optional (N, 4) colours and optional flat or (M, 3) indices for SDLWrapper::drawGeometry
+static void drawGeometryArrays(SDLWrapper& self, const FloatArray& vertices, std::optional<ColorArray> colors, std::optional<RowArray> indices) {
+    if (vertices.size() == 0) return;
+    if (vertices.ndim() != 2 || vertices.shape(1) != 2) {
+        throw py::value_error("Expected an (N, 2) array of vertex positions");
+    }
+    const size_t count = static_cast<size_t>(vertices.shape(0));
+    if (colors && (colors->ndim() != 2 || colors->shape(0) != vertices.shape(0) || colors->shape(1) != 4)) {
+        throw py::value_error("Expected an (N, 4) array of RGBA colours, one per vertex");
+    }
+    if (indices && indices->size() % 3 != 0) {
+        throw py::value_error("Index count must be a multiple of 3");
+    }
+    if (!indices && count % 3 != 0) {
+        throw py::value_error("Without indices the vertex count must be a multiple of 3");
+    }
+    if (indices) {
+        const int* data = indices->data();
+        for (ssize_t i = 0; i < indices->size(); i++) {
+            if (data[i] < 0 || static_cast<size_t>(data[i]) >= count) {
+                throw py::value_error("Index " + std::to_string(data[i]) + " is out of range");
+            }
+        }
+    }
+    self.drawGeometry(vertices.data(), count, colors ? colors->data() : nullptr,
+                      indices ? indices->data() : nullptr, indices ? static_cast<size_t>(indices->size()) : 0);
+}
+
+// The locked pixels of a framebuffer, exported through the buffer protocol. The array lock_framebuffer returns
+// and every slice or view of it holds a buffer export, and so a reference, on this object; while any is alive
+// the framebuffer can't be unlocked. Revoked (pixels == nullptr) once it is.
+struct FramebufferPixels {
+    Uint8* pixels;
+    int w, h, pitch;
+    py::object wrapper; // The SDLWrapper, kept alive since its destructor frees the framebuffer
+};
+
+// A framebuffer's key in the dict of locked FramebufferPixels
+static py::tuple framebufferKey(const SDLWrapper& self, int id) {
+    return py::make_tuple(reinterpret_cast<std::uintptr_t>(&self), id);
+}
+
+// Revokes the pixels handed out for a framebuffer before it's unlocked, drawn, freed or locked again, all of
+// which leave SDL free to move or release them. Throws BufferError while an array over them is still alive.
+static void releaseFramebufferPixels(const py::dict& locked, const SDLWrapper& self, int id) {
+    const py::tuple key = framebufferKey(self, id);
+    PyObject* owner = PyDict_GetItem(locked.ptr(), key.ptr()); // Borrowed
+    if (owner == nullptr) return;
+    // Nothing but the dict holds it once every array has gone
+    if (Py_REFCNT(owner) > 1) {
+        throw py::buffer_error("Framebuffer " + std::to_string(id) + " still has arrays over its pixels; "
+                               "delete them, and any slices of them, before unlocking, drawing, freeing or relocking it");
+    }
+    py::handle(owner).cast<FramebufferPixels&>().pixels = nullptr;
+    PyDict_DelItem(locked.ptr(), key.ptr());
+}
+
+// Maps a framebuffer as an (h, w, 4) uint8 RGBA array over the locked texture memory, without copying
+static py::object lockFramebufferArray(const py::dict& locked, SDLWrapper& self, int id) {
+    int w = 0, h = 0, pitch = 0;
+    void* pixels = nullptr;
+    if (!self.getFramebufferSize(id, &w, &h)) {
+        throw py::value_error("No framebuffer with id " + std::to_string(id));
+    }
+    releaseFramebufferPixels(locked, self, id);
+    if (!self.lockFramebuffer(id, &pixels, &pitch)) {
+        throw std::runtime_error("Unable to lock framebuffer " + std::to_string(id));
+    }
+    py::object owner = py::cast(FramebufferPixels{ static_cast<Uint8*>(pixels), w, h, pitch, py::cast(&self) });
+    locked[framebufferKey(self, id)] = owner;
+    // Through the buffer protocol rather than a base object, so the array holds an export on owner
+    return py::module_::import("numpy").attr("asarray")(owner);
+}
+
+// Validates an (N, 7) row buffer and hands it to one of the SDLWrapper batch submitters
+static void submitRows(SDLWrapper& self, void (SDLWrapper::*submit)(const int*, size_t, bool), const RowArray& rows, bool sortByColor) {
+    if (rows.size() == 0) {
+        return;
+    }
+    if (rows.ndim() != 2 || rows.shape(1) != 7) {
+        throw py::value_error("Expected an (N, 7) array of (x, y, w, h, r, g, b) rows");
+    }
+    (self.*submit)(rows.data(), static_cast<size_t>(rows.shape(0)), sortByColor);
+}
+
+// Checks a row-major (height, width) uint8 tile buffer (bytes, bytearray or array) fits grid
+static py::buffer_info requestTiles(const py::buffer& tiles, const TileGrid& grid) {
+    py::buffer_info info = tiles.request();
+    const ssize_t expected = static_cast<ssize_t>(grid.width()) * grid.height();
+    if (info.itemsize != 1 || info.size != expected) {
+        throw py::value_error("Expected " + std::to_string(expected) + " uint8 tiles");
+    }
+    for (ssize_t i = info.ndim - 1, step = 1; i >= 0; i--) {
+        if (info.strides[i] != step) {
+            throw py::value_error("Tile buffer must be C-contiguous");
+        }
+        step *= info.shape[i];
+    }
+    return info;
+}
+
+static bool setTilesBuffer(GridPathfinder& self, const py::buffer& tiles) {
+    const py::buffer_info info = requestTiles(tiles, self.grid());
+    return self.grid().setTiles(static_cast<const Uint8*>(info.ptr), static_cast<size_t>(info.size));
+}
+
+static py::array_t<int> toPathArray(const std::vector<int>& steps) {
+    py::array_t<int> path({ static_cast<ssize_t>(steps.size() / 2), static_cast<ssize_t>(2) });
+    std::copy(steps.begin(), steps.end(), path.mutable_data());
+    return path;
+}
+
+// Runs the search without the GIL and returns the path as an (N, 2) int32 array of (x, y), empty if unreachable
+static py::array_t<int> findPathArray(GridPathfinder& self, int startX, int startY, int goalX, int goalY) {
+    std::vector<int> steps;
+    {
+        py::gil_scoped_release release;
+        self.findPath(startX, startY, goalX, goalY, steps);
+    }
+    return toPathArray(steps);
+}
+
+// Looks up a flow field and the cell for (x, y), rebuilding the field first if the tiles changed
+static std::pair<const FlowField*, int> flowCell(GridPathfinder& self, int field, int x, int y) {
+    const FlowField* flow = self.flow(field);
+    if (!flow) {
+        throw py::value_error("No flow field with id " + std::to_string(field));
+    }
+    if (!self.grid().inBounds(x, y)) {
+        throw py::value_error("Tile (" + std::to_string(x) + ", " + std::to_string(y) + ") is outside the grid");
+    }
+    return { flow, y * self.grid().width() + x };
+}
+
+// Contiguous bytes-like payload (bytes, bytearray, memoryview) for the packet codec
+static py::buffer_info requestPayload(const py::buffer& data) {
+    py::buffer_info info = data.request();
+    if (info.itemsize != 1 || (info.ndim == 1 && info.strides[0] != 1) || info.ndim > 1) {
+        throw py::value_error("Expected a contiguous bytes-like payload");
+    }
+    return info;
+}
+
+PYBIND11_MODULE(bindings, m) {
+    m.doc() = "Python wrapper for SDL2";
+
+    PYBIND11_NUMPY_DTYPE(EventRecord, type, timestamp, scancode, keycode, mod, repeat, button, x, y, xrel, yrel, window);
+    PYBIND11_NUMPY_DTYPE(FrameRecord, frame, start, duration, sdlSeconds, presentSeconds, sleepSeconds, otherSeconds,
+                         clears, fillRects, drawRects, lines, points, circles, polygons, geometry, meshes, textures,
+                         texts, labels, batchFlushes, batchCommands, spriteInstances, spriteDrawCalls,
+                         colorChanges, textureUploads, textRasters, assetUploads);
+    PYBIND11_NUMPY_DTYPE(BattleUnitRecord, x, y, hitpoints, target, steps, nextX, nextY, alive, targetKind);
+    PYBIND11_NUMPY_DTYPE(ReplayDeploy, tick, card, x, y, owner, hitpoints, damage, range, attackSeconds, moveSeconds,
+                         layer, targets, mobile);
+
+    // Registered before SDLWrapper so they can be used as default arguments
+    py::enum_<CircleFillMode>(m, "CircleFillMode")
+        .value("SCANLINE", CircleFillMode::Scanline)
+        .value("PER_PIXEL", CircleFillMode::PerPixel)
+        .export_values();
+
+    py::enum_<RendererMode>(m, "RendererMode")
+        .value("SOFTWARE", RendererMode::Software)
+        .value("ACCELERATED", RendererMode::Accelerated)
+        .export_values();
+
+    py::enum_<MeshMode>(m, "MeshMode")
+        .value("WIREFRAME", MeshMode::Wireframe)
+        .value("FILLED", MeshMode::Filled)
+        .export_values();
+
+    // Not exported: NONE would shadow BlendMode's exported NONE at module level
+    py::enum_<CullMode>(m, "CullMode")
+        .value("NONE", CullMode::None)
+        .value("BACK", CullMode::Back)
+        .value("FRONT", CullMode::Front);
+
+    py::enum_<AssetState>(m, "AssetState")
+        .value("PENDING", AssetState::Pending)
+        .value("READY", AssetState::Ready)
+        .value("FAILED", AssetState::Failed);
+
+    py::class_<FramebufferPixels>(m, "FramebufferPixels", py::buffer_protocol())
+        .def_buffer([](FramebufferPixels& fb) {
+            if (fb.pixels == nullptr) {
+                throw py::buffer_error("The framebuffer has been unlocked since these pixels were mapped");
+            }
+            return py::buffer_info(fb.pixels, sizeof(Uint8), py::format_descriptor<Uint8>::format(), 3,
+                                   { fb.h, fb.w, 4 }, { fb.pitch, 4, 1 });
+        });
+
+    // Keyed by framebufferKey, shared by the framebuffer methods below
+    py::dict lockedFramebuffers;
+
+    // SDLWrapper isn't thread-safe: drive it from the thread that made the window. Only the calls that block (present,
+    // pacing, delay, waiting on the PNG encoder and polling with a timeout) release the GIL, so other Python threads
+    // can run meanwhile as long as they leave the wrapper alone
+    py::class_<SDLWrapper>(m, "SDLWrapper")
+        .def(py::init<int, int, const std::string&>(), "Constructor for SDLWrapper")
+        .def("initialize", &SDLWrapper::initialize, "Initializes SDL; headless skips video so no display server is needed",
+             py::arg("headless") = false)
+        .def("create_window", &SDLWrapper::createWindow, "Creates the SDL window")
+        .def("create_renderer", &SDLWrapper::createRenderer, "Creates the SDL renderer",
+             py::arg("mode") = RendererMode::Accelerated, py::arg("vsync") = false, py::arg("target_texture") = true)
+        .def("create_headless_renderer", &SDLWrapper::createHeadlessRenderer,
+             "Creates a software renderer drawing into an offscreen surface instead of a window")
+        .def("is_headless", &SDLWrapper::isHeadless, "Checks if rendering goes to an offscreen surface")
+        .def("is_accelerated", &SDLWrapper::isAccelerated, "Checks if the renderer is hardware accelerated")
+        .def("is_vsync_enabled", &SDLWrapper::isVsyncEnabled, "Checks if presents are synced to the display refresh")
+        .def("clear_screen", &SDLWrapper::clearScreen, "Clears the screen")
+        .def("update_screen", &SDLWrapper::updateScreen, "Updates the screen", py::call_guard<py::gil_scoped_release>())
+        .def("draw_rect", &SDLWrapper::drawRect, "Draws a rectangle",
+             py::arg("x"), py::arg("y"), py::arg("w"), py::arg("h"),
+             py::arg("r"), py::arg("g"), py::arg("b"))  // Named arguments
+
+        .def("draw_line", &SDLWrapper::drawLine, "Draws a line",
+             py::arg("x1"), py::arg("y1"), py::arg("x2"), py::arg("y2"),
+             py::arg("r"), py::arg("g"), py::arg("b"))
+
+        .def("draw_point", &SDLWrapper::drawPoint, "Draws a point",
+             py::arg("x"), py::arg("y"), py::arg("r"), py::arg("g"), py::arg("b"))
+
+        .def("draw_circle", &SDLWrapper::drawCircle, "Draws a circle",
+             py::arg("centerX"), py::arg("centerY"), py::arg("radius"),
+             py::arg("r"), py::arg("g"), py::arg("b"))
+        .def("draw_circle_aa", &SDLWrapper::drawCircleAA, "Draws an anti-aliased circle outline",
+             py::arg("centerX"), py::arg("centerY"), py::arg("radius"),
+             py::arg("r"), py::arg("g"), py::arg("b"))
+
+        .def("fill_circle", &SDLWrapper::fillCircle, "Fills a circle",
+             py::arg("centerX"), py::arg("centerY"), py::arg("radius"),
+             py::arg("r"), py::arg("g"), py::arg("b"), py::arg("mode") = CircleFillMode::Scanline)
+
+        .def("draw_polygon", &SDLWrapper::drawPolygon, "Draws a polygon",
+             py::arg("points"), py::arg("r"), py::arg("g"), py::arg("b"))
+
+        .def("fill_polygon", &SDLWrapper::fillPolygon, "Fills a convex or concave polygon",
+             py::arg("points"), py::arg("r"), py::arg("g"), py::arg("b"), py::arg("a") = 255)
+
+        .def("draw_geometry", &drawGeometryArrays, "Draws coloured triangles in one call",
+             py::arg("vertices"), py::arg("colors") = py::none(), py::arg("indices") = py::none())
+
+        .def("fill_rect", &SDLWrapper::fillRect, "Fills a rectangle",
+             py::arg("x"), py::arg("y"), py::arg("w"), py::arg("h"),
+             py::arg("r"), py::arg("g"), py::arg("b"))
+
+        .def("draw_mesh", &drawMeshArrays, "Transforms, clips, culls and draws a triangle mesh in one call",
+             py::arg("vertices"), py::arg("indices"), py::arg("mvp"), py::arg("r"), py::arg("g"), py::arg("b"),
+             py::arg("mode") = MeshMode::Wireframe, py::arg("cull") = CullMode::None, py::arg("line_width") = 1.0f)
+
+        .def("begin_batch", &SDLWrapper::beginBatch, "Starts a new batch, discarding any queued commands")
+        .def("submit_rects", [](SDLWrapper& self, const RowArray& rows, bool sortByColor) {
+                 submitRows(self, &SDLWrapper::submitRects, rows, sortByColor);
+             }, "Queues filled rectangles from an (N, 7) array of (x, y, w, h, r, g, b)",
+             py::arg("rows"), py::arg("sort_by_color") = false)
+        .def("submit_outlines", [](SDLWrapper& self, const RowArray& rows, bool sortByColor) {
+                 submitRows(self, &SDLWrapper::submitOutlines, rows, sortByColor);
+             }, "Queues rectangle outlines from an (N, 7) array of (x, y, w, h, r, g, b)",
+             py::arg("rows"), py::arg("sort_by_color") = false)
+        .def("submit_lines", [](SDLWrapper& self, const RowArray& rows, bool sortByColor) {
+                 submitRows(self, &SDLWrapper::submitLines, rows, sortByColor);
+             }, "Queues lines from an (N, 7) array of (x1, y1, x2, y2, r, g, b)",
+             py::arg("rows"), py::arg("sort_by_color") = false)
+        .def("flush", &SDLWrapper::flush, "Draws all queued batch commands")
+
+        .def("load_texture", &SDLWrapper::openTexture, "Loads an image into its own texture and returns its id (-1 on failure)",
+             py::arg("path"))
+        .def("draw_texture", py::overload_cast<int, int, int, int, int>(&SDLWrapper::drawTexture), "Draws a texture, at its own size unless w and h are given",
+             py::arg("texture_id"), py::arg("x"), py::arg("y"), py::arg("w") = -1, py::arg("h") = -1)
+        .def("draw_texture_region", [](SDLWrapper& self, int id, int srcX, int srcY, int srcW, int srcH, int x, int y, int w, int h) {
+                 self.drawTextureRegion(id, SDL_Rect{ srcX, srcY, srcW, srcH }, SDL_Rect{ x, y, w, h });
+             }, "Draws part of a texture into a destination rectangle",
+             py::arg("texture_id"), py::arg("src_x"), py::arg("src_y"), py::arg("src_w"), py::arg("src_h"),
+             py::arg("x"), py::arg("y"), py::arg("w"), py::arg("h"))
+        .def("free_texture", &SDLWrapper::closeTexture, "Destroys a texture", py::arg("texture_id"))
+        .def("get_texture_size", [](SDLWrapper& self, int id) {
+                 int w = 0, h = 0;
+                 if (!self.getTextureSize(id, &w, &h)) {
+                     throw py::value_error("No texture with id " + std::to_string(id));
+                 }
+                 return std::make_tuple(w, h);
+             }, "Gets a texture's (w, h)", py::arg("texture_id"))
+        .def("set_texture_blend_mode", py::overload_cast<int, SDL_BlendMode>(&SDLWrapper::setTextureBlendMode), "Sets texture blend mode",
+             py::arg("texture_id"), py::arg("blend_mode"))
+        .def("set_texture_alpha_mod", py::overload_cast<int, Uint8>(&SDLWrapper::setTextureAlphaMod), "Sets texture alpha modulation",
+             py::arg("texture_id"), py::arg("alpha"))
+        .def("set_texture_color_mod", py::overload_cast<int, Uint8, Uint8, Uint8>(&SDLWrapper::setTextureColorMod), "Sets texture color modulation",
+             py::arg("texture_id"), py::arg("r"), py::arg("g"), py::arg("b"))
+
+        .def("load_sprite", &SDLWrapper::loadSprite, "Loads an image into a sprite atlas page and returns its sprite id (-1 on failure)",
+             py::arg("path"))
+        .def("create_sprite", [](SDLWrapper& self, const ColorArray& pixels) {
+                 if (pixels.ndim() != 3 || pixels.shape(2) != 4) {
+                     throw py::value_error("Expected an (h, w, 4) array of RGBA pixels");
+                 }
+                 return self.createSprite(pixels.data(), static_cast<int>(pixels.shape(1)), static_cast<int>(pixels.shape(0)));
+             }, "Copies an (h, w, 4) RGBA array into a sprite atlas page and returns its sprite id (-1 on failure)", py::arg("pixels"))
+        .def("free_sprite", &SDLWrapper::freeSprite, "Frees a sprite; its atlas page is released once empty", py::arg("sprite_id"))
+        .def("get_sprite_size", [](const SDLWrapper& self, int id) {
+                 int w = 0, h = 0;
+                 if (!self.getSpriteSize(id, &w, &h)) {
+                     throw py::value_error("No sprite with id " + std::to_string(id));
+                 }
+                 return std::make_tuple(w, h);
+             }, "Gets a sprite's (w, h)", py::arg("sprite_id"))
+        .def("get_sprite_page_count", &SDLWrapper::getSpritePageCount, "Gets how many atlas pages are in use")
+        .def("submit_sprites", [](SDLWrapper& self, const RowArray& rows) {
+                 if (rows.size() == 0) return;
+                 if (rows.ndim() != 2 || rows.shape(1) != static_cast<ssize_t>(SpriteBatch::RowWidth)) {
+                     throw py::value_error("Expected an (N, 10) array of (sprite, x, y, w, h, r, g, b, a, layer) rows");
+                 }
+                 self.submitSprites(rows.data(), static_cast<size_t>(rows.shape(0)));
+             }, "Queues sprites with the batch, drawn after its primitives by flush, one call per layer and atlas page",
+             py::arg("rows"))
+        .def("get_sprite_stats", &SDLWrapper::getSpriteStats, "Gets instance and draw call counts for the last flush")
+
+        .def("create_framebuffer", &SDLWrapper::createFramebuffer, "Creates a streaming RGBA framebuffer and returns its id (-1 on failure)",
+             py::arg("w"), py::arg("h"))
+        .def("lock_framebuffer", [lockedFramebuffers](SDLWrapper& self, int id) {
+                 return lockFramebufferArray(lockedFramebuffers, self, id);
+             }, "Maps a framebuffer as a writable (h, w, 4) uint8 array. Write every pixel you need: the previous "
+                "contents are not preserved. The array and its slices must be deleted before the framebuffer is "
+                "unlocked, drawn, freed or locked again, which raise BufferError otherwise",
+             py::arg("framebuffer_id"))
+        .def("unlock_framebuffer", [lockedFramebuffers](SDLWrapper& self, int id) {
+                 releaseFramebufferPixels(lockedFramebuffers, self, id);
+                 self.unlockFramebuffer(id);
+             }, "Uploads the pixels written since lock_framebuffer", py::arg("framebuffer_id"))
+        .def("draw_framebuffer", [lockedFramebuffers](SDLWrapper& self, int id, int x, int y, int w, int h) {
+                 releaseFramebufferPixels(lockedFramebuffers, self, id);
+                 self.drawFramebuffer(id, x, y, w, h);
+             }, "Unlocks a framebuffer if needed and copies it to the screen",
+             py::arg("framebuffer_id"), py::arg("x"), py::arg("y"), py::arg("w") = -1, py::arg("h") = -1)
+        .def("free_framebuffer", [lockedFramebuffers](SDLWrapper& self, int id) {
+                 releaseFramebufferPixels(lockedFramebuffers, self, id);
+                 self.freeFramebuffer(id);
+             }, "Destroys a framebuffer", py::arg("framebuffer_id"))
+
+        .def("open_font", &SDLWrapper::openFont, "Opens a font, or returns the id it is already open under (-1 on failure)", py::arg("path"), py::arg("size"))
+        .def("close_font", &SDLWrapper::closeFont, "Closes a font and frees its atlas", py::arg("font_id"))
+        .def("set_font", &SDLWrapper::setFont, "Makes a font the default for calls without a font id", py::arg("font_id"))
+        .def("get_font", &SDLWrapper::getFont, "Gets the default font id")
+        .def("load_font", &SDLWrapper::loadFont, "Loads a font", py::arg("path"), py::arg("size"))
+        .def("draw_text", py::overload_cast<const std::string&, int, int, SDL_Color>(&SDLWrapper::drawText), "Draws text with SDL_Color", py::arg("text"), py::arg("x"), py::arg("y"), py::arg("color"))
+        .def("draw_text", py::overload_cast<const std::string&, int, int, Uint8, Uint8, Uint8>(&SDLWrapper::drawText), "Draws text with RGB", py::arg("text"), py::arg("x"), py::arg("y"), py::arg("r"), py::arg("g"), py::arg("b"))
+        .def("draw_text", py::overload_cast<int, const std::string&, int, int, SDL_Color>(&SDLWrapper::drawText), "Draws text in a given font with SDL_Color", py::arg("font_id"), py::arg("text"), py::arg("x"), py::arg("y"), py::arg("color"))
+        .def("draw_text", py::overload_cast<int, const std::string&, int, int, Uint8, Uint8, Uint8>(&SDLWrapper::drawText), "Draws text in a given font with RGB", py::arg("font_id"), py::arg("text"), py::arg("x"), py::arg("y"), py::arg("r"), py::arg("g"), py::arg("b"))
+          .def("get_text_size", py::overload_cast<const std::string&>(&SDLWrapper::getTextSize), "Gets text size", py::arg("text")) // Corrected name
+        .def("get_text_size", py::overload_cast<int, const std::string&>(&SDLWrapper::getTextSize), "Gets text size in a given font", py::arg("font_id"), py::arg("text"))
+        .def("draw_label", py::overload_cast<const std::string&, int, int, Uint8, Uint8, Uint8>(&SDLWrapper::drawLabel), "Draws text through the label texture cache",
+             py::arg("text"), py::arg("x"), py::arg("y"), py::arg("r"), py::arg("g"), py::arg("b"))
+        .def("draw_label", py::overload_cast<int, const std::string&, int, int, Uint8, Uint8, Uint8>(&SDLWrapper::drawLabel), "Draws text in a given font through the label texture cache",
+             py::arg("font_id"), py::arg("text"), py::arg("x"), py::arg("y"), py::arg("r"), py::arg("g"), py::arg("b"))
+        .def("set_label_cache_budget", &SDLWrapper::setLabelCacheBudget, "Sets the label cache size in bytes", py::arg("bytes"))
+        .def("clear_label_cache", &SDLWrapper::clearLabelCache, "Frees every cached label texture")
+        .def("get_label_cache_stats", &SDLWrapper::getLabelCacheStats, "Gets label cache hit/miss/eviction counters")
+
+        .def("load_texture_async", &SDLWrapper::loadTextureAsync, "Queues an image for a texture on the loader thread and returns a request handle",
+             py::arg("path"))
+        .def("load_sprite_async", &SDLWrapper::loadSpriteAsync, "Queues an image for the sprite atlas on the loader thread and returns a request handle",
+             py::arg("path"))
+        .def("open_font_async", &SDLWrapper::openFontAsync, "Queues a font to open on the loader thread and returns a request handle",
+             py::arg("path"), py::arg("size"))
+        .def("upload_assets", &SDLWrapper::uploadAssets, "Uploads finished loads until budget_ms is spent (at least one) and returns how many",
+             py::arg("budget_ms") = 2.0)
+        .def("get_asset_state", &SDLWrapper::getAssetState, "Gets whether a load request is pending, ready or failed", py::arg("request"))
+        .def("get_asset_id", &SDLWrapper::getAssetId, "Gets the texture, sprite or font id of a ready load request, -1 otherwise", py::arg("request"))
+        .def("get_pending_assets", &SDLWrapper::getPendingAssets, "Gets how many load requests are still decoding or waiting for upload")
+
+        .def("set_partial_redraw", &SDLWrapper::setPartialRedraw, "Keeps frames in a retained texture and only redraws what changed; "
+             "returns False without render target support", py::arg("enabled"))
+        .def("is_partial_redraw", &SDLWrapper::isPartialRedraw, "Checks if partial redraw is on")
+        .def("track", [](SDLWrapper& self, const py::object& key, const py::object& signature, int x, int y, int w, int h) {
+                 return self.track(static_cast<Uint64>(py::hash(key)), static_cast<Uint64>(py::hash(signature)), x, y, w, h);
+             }, "Records that whatever key names looks like signature within (x, y, w, h) this frame; returns True if that damaged the frame",
+             py::arg("key"), py::arg("signature"), py::arg("x"), py::arg("y"), py::arg("w"), py::arg("h"))
+        .def("invalidate_rect", &SDLWrapper::invalidateRect, "Redraws a rect next frame", py::arg("x"), py::arg("y"), py::arg("w"), py::arg("h"))
+        .def("invalidate_all", &SDLWrapper::invalidateAll, "Redraws everything next frame")
+        .def("begin_frame", &SDLWrapper::beginFrame, "Clips drawing to what changed; returns False if nothing needs drawing this frame")
+        .def("is_dirty", &SDLWrapper::isDirty, "Checks if anything in a rect is redrawn this frame",
+             py::arg("x"), py::arg("y"), py::arg("w"), py::arg("h"))
+        .def("get_frame_damage", &SDLWrapper::getFrameDamage, "Gets the rect being redrawn this frame")
+
+        .def("set_profiling", &SDLWrapper::setProfiling, "Counts and times draw calls per frame; trace also keeps every call "
+             "for get_chrome_trace. Enabling clears what was recorded", py::arg("enabled"), py::arg("trace") = false)
+        .def("is_profiling", [](SDLWrapper& self) { return self.getProfiler().isEnabled(); }, "Checks if profiling is on")
+        .def("get_frame_records", [](SDLWrapper& self) {
+                 const std::vector<FrameRecord> records = self.getProfiler().frames();
+                 return py::array_t<FrameRecord>(static_cast<ssize_t>(records.size()), records.data());
+             }, "The last profiled frames, oldest first, as a structured array")
+        .def("get_chrome_trace", [](SDLWrapper& self) { return self.getProfiler().chromeTrace(); },
+             "The profiled frames as Trace Event Format JSON, for chrome://tracing or Perfetto")
+        .def("write_chrome_trace", [](SDLWrapper& self, const std::string& path) { return self.getProfiler().writeChromeTrace(path); },
+             "Writes get_chrome_trace to a file; returns False if it couldn't be written", py::arg("path"))
+        .def("clear_profile", [](SDLWrapper& self) { self.getProfiler().clear(); }, "Drops the recorded frames and spans")
+
+        .def("read_frame", [](SDLWrapper& self) {
+                 SDL_Surface* frame = self.captureFrame();
+                 if (frame == nullptr) {
+                     throw std::runtime_error("Unable to read back the frame");
+                 }
+                 py::array_t<Uint8> out({ frame->h, frame->w, 4 });
+                 Uint8* data = out.mutable_data();
+                 for (int y = 0; y < frame->h; y++) {
+                     std::memcpy(data + static_cast<size_t>(y) * frame->w * 4,
+                                 static_cast<const Uint8*>(frame->pixels) + static_cast<size_t>(y) * frame->pitch,
+                                 static_cast<size_t>(frame->w) * 4);
+                 }
+                 SDL_FreeSurface(frame);
+                 return out;
+             }, "Reads the last presented frame back as an (h, w, 4) RGBA array")
+        .def("save_frame_png", &SDLWrapper::saveFramePng, "Captures the frame and writes it as a PNG on a background thread",
+             py::arg("path"))
+        .def("wait_for_encodes", &SDLWrapper::waitForEncodes, "Blocks until every queued PNG is written",
+             py::call_guard<py::gil_scoped_release>())
+        .def("get_pending_encodes", &SDLWrapper::getPendingEncodes, "Gets how many PNGs are still waiting to be written")
+        .def("get_failed_encodes", &SDLWrapper::getFailedEncodes, "Gets how many PNGs couldn't be written")
+
+        .def("poll_event", &SDLWrapper::pollEvent, "Polls for events", py::arg("event"))  // Important:  See explanation below
+        .def("poll_events", [](SDLWrapper& self, size_t max, int timeoutMs) {
+                 std::vector<EventRecord> records(max);
+                 size_t count;
+                 {
+                     py::gil_scoped_release release;
+                     count = self.pollEvents(records.data(), max, timeoutMs);
+                 }
+                 return py::array_t<EventRecord>(static_cast<ssize_t>(count), records.data());
+             }, "Drains up to max events into a structured array, waiting up to timeout_ms for the first",
+             py::arg("max") = 64, py::arg("timeout_ms") = 0)
+
+        .def("get_ticks", &SDLWrapper::getTicks, "Gets SDL ticks")
+        .def("delay", &SDLWrapper::delay, "Delays execution", py::call_guard<py::gil_scoped_release>())
+        .def("set_target_fps", &SDLWrapper::setTargetFps, "Sets the frame rate paced by pace_frame, 0 for uncapped", py::arg("fps"))
+        .def("pace_frame", &SDLWrapper::paceFrame, "Sleeps for the rest of the frame budget and returns the frame time in seconds",
+             py::call_guard<py::gil_scoped_release>())
+        .def("is_key_pressed", &SDLWrapper::isKeyPressed, "Checks if a key is pressed", py::arg("key"))
+
+        .def("get_width", &SDLWrapper::getWidth, "Gets window width")
+        .def("get_height", &SDLWrapper::getHeight, "Gets window height")
+        .def("getMousePosition", &SDLWrapper::getMousePosition, "Get mouse position (relative to center)")
+        .def("is_mouse_button_down", &SDLWrapper::isMouseButtonDown, "Checks if a mouse button is pressed", py::arg("button"))
+    .def("is_window_focused", &SDLWrapper::isWindowFocused, "Checks if the SDL window is focused");
+
+    // Example of how to bind an enum
+    py::enum_<SDL_BlendMode>(m, "BlendMode")
+        .value("BLEND", SDL_BLENDMODE_BLEND)
+        .value("ADD", SDL_BLENDMODE_ADD)
+        .value("MOD", SDL_BLENDMODE_MOD)
+        .value("NONE", SDL_BLENDMODE_NONE)
+        .export_values();
+
+    py::class_<TileLayer>(m, "TileLayer")
+        .def(py::init<SDLWrapper&, int, int, int>(), "A columns x rows grid of cell_size pixel tiles kept in a render target",
+             py::arg("sdl"), py::arg("columns"), py::arg("rows"), py::arg("cell_size"), py::keep_alive<1, 2>())
+        .def("set_palette", [](TileLayer& self, const RowArray& colors) {
+                 if (colors.ndim() != 2 || colors.shape(1) != 3) {
+                     throw py::value_error("Expected an (N, 3) array of (r, g, b)");
+                 }
+                 std::vector<Uint8> rgb(static_cast<size_t>(colors.size()));
+                 const int* data = colors.data();
+                 for (size_t i = 0; i < rgb.size(); i++) {
+                     rgb[i] = static_cast<Uint8>(std::clamp(data[i], 0, 255));
+                 }
+                 self.setPalette(rgb.data(), rgb.size() / 3);
+             }, "Sets the colour of each tile value from an (N, 3) array, redrawing every cell", py::arg("colors"))
+        .def("set_outline", &TileLayer::setOutline, "Sets the border drawn inside every cell",
+             py::arg("enabled"), py::arg("r") = 255, py::arg("g") = 255, py::arg("b") = 255)
+        .def("set_tiles", [](TileLayer& self, const RowArray& tiles) {
+                 if (static_cast<size_t>(tiles.size()) != static_cast<size_t>(self.getColumns()) * self.getRows()) {
+                     throw py::value_error("Expected " + std::to_string(self.getRows()) + " x " + std::to_string(self.getColumns()) + " tiles");
+                 }
+                 return self.setTiles(tiles.data(), static_cast<size_t>(tiles.size()));
+             }, "Updates every tile from a (rows, columns) array and returns how many changed", py::arg("tiles"))
+        .def("set_tile", &TileLayer::setTile, "Sets one tile; False if out of bounds", py::arg("x"), py::arg("y"), py::arg("value"))
+        .def("set_row_shades", [](TileLayer& self, const RowArray& shades) {
+                 return self.setRowShades(shades.data(), static_cast<size_t>(shades.size()));
+             }, "Sets how much each row is darkened by and returns how many rows changed", py::arg("shades"))
+        .def("invalidate", &TileLayer::invalidate, "Redraws every cell at the next draw")
+        .def("draw", &TileLayer::draw, "Redraws the dirty cells and copies the layer to (x, y)", py::arg("x"), py::arg("y"))
+        .def_property_readonly("columns", &TileLayer::getColumns)
+        .def_property_readonly("rows", &TileLayer::getRows)
+        .def_property_readonly("cell_size", &TileLayer::getCellSize)
+        .def_property_readonly("dirty_count", &TileLayer::dirtyCount)
+        .def_property_readonly("last_rasterised", &TileLayer::lastRasterised, "Cells the last draw redrew")
+        .def_property_readonly("is_retained", &TileLayer::isRetained, "Whether the layer has a render target to draw from");
+
+    // Example: Bind SDL_Color struct
+    py::class_<SDL_Color>(m, "Color")
+        .def(py::init<Uint8, Uint8, Uint8, Uint8>())
+        .def_readwrite("r", &SDL_Color::r)
+        .def_readwrite("g", &SDL_Color::g)
+        .def_readwrite("b", &SDL_Color::b)
+        .def_readwrite("a", &SDL_Color::a);
+
+    // Example: Bind SDL_Rect struct
+    py::class_<SDL_Rect>(m, "SDL_Rect")
+        .def(py::init<int, int, int, int>())
+        .def_readwrite("x", &SDL_Rect::x)
+        .def_readwrite("y", &SDL_Rect::y)
+        .def_readwrite("w", &SDL_Rect::w)
+        .def_readwrite("h", &SDL_Rect::h);
+
+    py::class_<LabelCacheStats>(m, "LabelCacheStats")
+        .def_readonly("hits", &LabelCacheStats::hits)
+        .def_readonly("misses", &LabelCacheStats::misses)
+        .def_readonly("evictions", &LabelCacheStats::evictions)
+        .def_readonly("bytes", &LabelCacheStats::bytes)
+        .def_readonly("entries", &LabelCacheStats::entries)
+        .def_readonly("budget", &LabelCacheStats::budget);
+
+    py::class_<SpriteBatchStats>(m, "SpriteBatchStats")
+        .def_readonly("instances", &SpriteBatchStats::instances)
+        .def_readonly("draw_calls", &SpriteBatchStats::drawCalls)
+        .def_readonly("skipped", &SpriteBatchStats::skipped);
+
+    py::class_<GridPathfinder>(m, "GridPathfinder")
+        .def(py::init<int, int>(), "Creates an A* pathfinder over an empty width x height tile grid",
+             py::arg("width"), py::arg("height"))
+        .def("set_tiles", &setTilesBuffer, "Replaces the tile grid; returns True if any tile changed", py::arg("tiles"))
+        .def("find_path", &findPathArray, "Finds the cheapest path as an (N, 2) array of (x, y), empty if there is none",
+             py::arg("start_x"), py::arg("start_y"), py::arg("goal_x"), py::arg("goal_y"))
+        .def_property_readonly("width", [](const GridPathfinder& self) { return self.grid().width(); })
+        .def_property_readonly("height", [](const GridPathfinder& self) { return self.grid().height(); })
+        .def_property_readonly("revision", [](const GridPathfinder& self) { return self.grid().revision(); },
+                               "Bumped whenever set_tiles changes the grid")
+        .def_property_readonly("last_expanded", &GridPathfinder::lastExpanded, "Nodes expanded by the last search")
+        .def("flow_field", &GridPathfinder::flowField, "Returns the id of the flow field toward a goal tile, creating it on first use",
+             py::arg("goal_x"), py::arg("goal_y"))
+        .def("flow_next", [](GridPathfinder& self, int field, int x, int y) -> std::optional<std::pair<int, int>> {
+                 auto [flow, cell] = flowCell(self, field, x, y);
+                 const int next = flow->next(cell);
+                 if (next == -1) return std::nullopt;
+                 return std::make_pair(next % self.grid().width(), next / self.grid().width());
+             }, "The tile to step onto from (x, y) toward the field's goal, None at the goal or if unreachable",
+             py::arg("field"), py::arg("x"), py::arg("y"))
+        .def("flow_steps", [](GridPathfinder& self, int field, int x, int y) {
+                 auto [flow, cell] = flowCell(self, field, x, y);
+                 return flow->steps(cell);
+             }, "Moves from (x, y) to the field's goal, -1 if unreachable", py::arg("field"), py::arg("x"), py::arg("y"))
+        .def("flow_cost", [](GridPathfinder& self, int field, int x, int y) {
+                 auto [flow, cell] = flowCell(self, field, x, y);
+                 return flow->cost(cell) == -1 ? -1.0f : flow->cost(cell) * 0.5f;
+             }, "Path cost from (x, y) to the field's goal with bridges at 0.5, -1 if unreachable",
+             py::arg("field"), py::arg("x"), py::arg("y"))
+        .def("flow_path", [](GridPathfinder& self, int field, int startX, int startY) {
+                 std::vector<int> steps;
+                 self.flowPath(field, startX, startY, steps);
+                 return toPathArray(steps);
+             }, "Follows a flow field from a start tile, as an (N, 2) array of (x, y); empty if unreachable",
+             py::arg("field"), py::arg("start_x"), py::arg("start_y"));
+
+    py::class_<SpatialGrid>(m, "SpatialGrid")
+        .def(py::init<int, int, int>(), "Creates a bucket grid over a width x height tile area",
+             py::arg("width"), py::arg("height"), py::arg("cell_size") = 4)
+        .def("clear", &SpatialGrid::clear, "Removes every unit")
+        .def("insert", &SpatialGrid::insert, "Adds one unit",
+             py::arg("id"), py::arg("x"), py::arg("y"), py::arg("team"), py::arg("layers"))
+        .def("build", [](SpatialGrid& self, const RowArray& rows) {
+                 if (rows.size() != 0 && (rows.ndim() != 2 || rows.shape(1) != 4)) {
+                     throw py::value_error("Expected an (N, 4) array of (x, y, team, layers) rows");
+                 }
+                 self.build(rows.data(), rows.size() == 0 ? 0 : static_cast<size_t>(rows.shape(0)));
+             }, "Replaces the contents from an (N, 4) array of (x, y, team, layers); ids are row indices", py::arg("rows"))
+        .def("nearest", &SpatialGrid::nearest, "Id of the closest unit by Manhattan distance not on exclude_team, -1 if none",
+             py::arg("x"), py::arg("y"), py::arg("exclude_team") = -1, py::arg("layer_mask") = 0xFFFFFFFFu,
+             py::arg("max_distance") = -1)
+        .def("query_radius", [](SpatialGrid& self, int x, int y, int radius, int excludeTeam, Uint32 layerMask) {
+                 std::vector<int> ids;
+                 self.queryRadius(x, y, radius, excludeTeam, layerMask, ids);
+                 py::array_t<int> out(static_cast<ssize_t>(ids.size()));
+                 std::copy(ids.begin(), ids.end(), out.mutable_data());
+                 return out;
+             }, "Ids of every unit within a Manhattan radius, ascending",
+             py::arg("x"), py::arg("y"), py::arg("radius"), py::arg("exclude_team") = -1, py::arg("layer_mask") = 0xFFFFFFFFu)
+        .def("__len__", &SpatialGrid::size);
+
+    py::enum_<TowerKind>(m, "TowerKind")
+        .value("KING", TowerKind::King)
+        .value("PRINCESS", TowerKind::Princess);
+
+    // Not exported, for the same NONE clash as CullMode
+    py::enum_<TargetKind>(m, "BattleTarget")
+        .value("NONE", TargetKind::None)
+        .value("TROOP", TargetKind::Troop)
+        .value("TOWER", TargetKind::Tower);
+
+    // Shared so a MatchScheduler can hold matches that Python also references
+    py::class_<BattleSim, std::shared_ptr<BattleSim>>(m, "BattleSim")
+        .def(py::init<int, int, int>(), "Creates a match simulation over a width x height arena stepped tick_rate times a second",
+             py::arg("width"), py::arg("height"), py::arg("tick_rate") = 20)
+        .def("set_tiles", [](BattleSim& self, const py::buffer& tiles) {
+                 const py::buffer_info info = requestTiles(tiles, self.grid());
+                 return self.setTiles(static_cast<const Uint8*>(info.ptr), static_cast<size_t>(info.size));
+             }, "Replaces the tile grid; returns True if any tile changed", py::arg("tiles"))
+        .def("add_tower", &BattleSim::addTower, "Adds a tower and returns its index",
+             py::arg("x"), py::arg("y"), py::arg("owner"), py::arg("kind"), py::arg("hitpoints"))
+        .def("spawn", [](BattleSim& self, int x, int y, int owner, int hitpoints, int damage, float range,
+                         float attackSeconds, float moveSeconds, Uint32 layer, Uint32 targets, bool mobile) {
+                 return self.spawn(battleSpec(x, y, owner, hitpoints, damage, range, attackSeconds, moveSeconds, layer, targets, mobile));
+             }, "Adds a unit and returns its slot; slots of dead units are reused",
+             py::arg("x"), py::arg("y"), py::arg("owner"), py::arg("hitpoints"), py::arg("damage") = 0,
+             py::arg("range") = 0.0f, py::arg("attack_speed") = 0.0f, py::arg("move_speed") = 0.0f,
+             py::arg("layer") = 1u, py::arg("targets") = 0u, py::arg("mobile") = true)
+        .def("step", &BattleSim::step, "Advances the match by one fixed tick", py::call_guard<py::gil_scoped_release>())
+        .def("units", [](const BattleSim& self) {
+                 std::vector<BattleUnitRecord> records;
+                 self.snapshot(records);
+                 return py::array_t<BattleUnitRecord>(static_cast<ssize_t>(records.size()), records.data());
+             }, "Every slot's state as a structured array, indexed by slot")
+        .def("tower_hitpoints", [](const BattleSim& self) {
+                 py::array_t<int> out(static_cast<ssize_t>(self.towerCount()));
+                 int* data = out.mutable_data();
+                 for (size_t t = 0; t < self.towerCount(); t++) {
+                     data[t] = self.towerHitpoints(static_cast<int>(t));
+                 }
+                 return out;
+             }, "Hitpoints of each tower in add_tower order")
+        .def("winner", &BattleSim::winner, "The owner whose opponent has lost their King Tower, -1 if undecided")
+        .def("checksum", &BattleSim::checksum, "Hash of the tick, units and towers, for comparing two runs")
+        .def_property_readonly("tick", &BattleSim::tick)
+        .def_property_readonly("tick_rate", &BattleSim::tickRate)
+        .def_property_readonly("alive_count", &BattleSim::aliveCount);
+
+    py::class_<MatchRecorder>(m, "MatchRecorder")
+        .def(py::init<Uint64>(), "Appends a match's deploys to a replay file; checksums are recorded at most every checkpoint_ticks",
+             py::arg("checkpoint_ticks") = 100)
+        .def("open", &MatchRecorder::open, "Starts a replay file with the arena of a sim that has its tiles and towers",
+             py::arg("path"), py::arg("sim"))
+        .def("is_open", &MatchRecorder::isOpen)
+        .def("deploy", [](MatchRecorder& self, Uint64 tick, const std::string& card, int x, int y, int owner, int hitpoints,
+                          int damage, float range, float attackSeconds, float moveSeconds, Uint32 layer, Uint32 targets, bool mobile) {
+                 self.deploy(tick, card, battleSpec(x, y, owner, hitpoints, damage, range, attackSeconds, moveSeconds, layer, targets, mobile));
+             }, "Records a spawn made at tick, with the same arguments as BattleSim.spawn",
+             py::arg("tick"), py::arg("card"), py::arg("x"), py::arg("y"), py::arg("owner"), py::arg("hitpoints"), py::arg("damage") = 0,
+             py::arg("range") = 0.0f, py::arg("attack_speed") = 0.0f, py::arg("move_speed") = 0.0f,
+             py::arg("layer") = 1u, py::arg("targets") = 0u, py::arg("mobile") = true)
+        .def("checkpoint", &MatchRecorder::checkpoint, "Records the sim's checksum if checkpoint_ticks have passed since the last",
+             py::arg("sim"))
+        .def("finish", &MatchRecorder::finish, "Records the final tick, winner and towers and closes the file", py::arg("sim"))
+        .def_property_readonly("bytes_written", &MatchRecorder::bytesWritten);
+
+    py::class_<MatchReplay>(m, "MatchReplay")
+        .def(py::init<>())
+        .def("load", &MatchReplay::load, "Reads a replay file; False, with nothing loaded, if it isn't one", py::arg("path"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("deploys", [](const MatchReplay& self) {
+                 const std::vector<ReplayDeploy>& deploys = self.deploys();
+                 return py::array_t<ReplayDeploy>(static_cast<ssize_t>(deploys.size()), deploys.data());
+             }, "The recorded deploys as a structured array, in tick order")
+        .def("set_deploys", [](MatchReplay& self, const py::array_t<ReplayDeploy, py::array::c_style | py::array::forcecast>& deploys) {
+                 requireLoaded(self);
+                 if (deploys.ndim() != 1) {
+                     throw py::value_error("Expected a 1-D array of deploys, as returned by deploys()");
+                 }
+                 self.setDeploys(std::vector<ReplayDeploy>(deploys.data(), deploys.data() + deploys.shape(0)));
+             }, "Replaces the deploys, e.g. with rebalanced stats, and rewinds to tick 0", py::arg("deploys"))
+        .def("set_snapshot_interval", &MatchReplay::setSnapshotInterval, "Keeps a copy of the sim every ticks for seeking, 0 for none",
+             py::arg("ticks"))
+        .def("reset", [](MatchReplay& self) {
+                 requireLoaded(self);
+                 self.reset();
+             }, "Rewinds to tick 0")
+        .def("seek", [](MatchReplay& self, Uint64 tick) {
+                 requireLoaded(self);
+                 py::gil_scoped_release release;
+                 self.seek(tick);
+             }, "Moves to a tick, from the closest earlier snapshot when going back", py::arg("tick"))
+        .def("advance", [](MatchReplay& self, Uint64 ticks) {
+                 requireLoaded(self);
+                 py::gil_scoped_release release;
+                 return self.advance(ticks);
+             }, "Steps up to ticks times, stopping once a side has won; returns the ticks stepped", py::arg("ticks"))
+        .def("run", [](MatchReplay& self, Uint64 maxTicks) {
+                 requireLoaded(self);
+                 py::gil_scoped_release release;
+                 return self.run(maxTicks);
+             }, "Steps until a side wins or max_ticks pass and returns the winner, or -1", py::arg("max_ticks"))
+        .def("first_divergence", [](MatchReplay& self) {
+                 requireLoaded(self);
+                 py::gil_scoped_release release;
+                 return self.firstDivergence();
+             }, "Replays through every recorded checksum; the first tick that differs, or -1 if none do")
+        .def("units", [](const MatchReplay& self) {
+                 requireLoaded(self);
+                 std::vector<BattleUnitRecord> records;
+                 self.sim().snapshot(records);
+                 return py::array_t<BattleUnitRecord>(static_cast<ssize_t>(records.size()), records.data());
+             }, "Every slot's state at the current tick, like BattleSim.units")
+        .def("tower_hitpoints", [](const MatchReplay& self) {
+                 requireLoaded(self);
+                 const BattleSim& sim = self.sim();
+                 py::array_t<int> out(static_cast<ssize_t>(sim.towerCount()));
+                 int* data = out.mutable_data();
+                 for (size_t t = 0; t < sim.towerCount(); t++) {
+                     data[t] = sim.towerHitpoints(static_cast<int>(t));
+                 }
+                 return out;
+             }, "Hitpoints of each tower at the current tick")
+        .def("winner", [](const MatchReplay& self) {
+                 requireLoaded(self);
+                 return self.sim().winner();
+             }, "The winner so far, -1 if undecided")
+        .def_property_readonly("loaded", &MatchReplay::isLoaded, "Whether a load has succeeded")
+        .def_property_readonly("cards", &MatchReplay::cards, "Card names, indexed by a deploy's card")
+        .def_property_readonly("tick", &MatchReplay::tick)
+        .def_property_readonly("end_tick", &MatchReplay::endTick)
+        .def_property_readonly("recorded_winner", &MatchReplay::recordedWinner)
+        .def_property_readonly("recorded_tower_hitpoints", &MatchReplay::recordedTowerHitpoints)
+        .def_property_readonly("tick_rate", &MatchReplay::tickRate)
+        .def_property_readonly("width", &MatchReplay::width)
+        .def_property_readonly("height", &MatchReplay::height);
+
+    py::class_<MatchScheduler>(m, "MatchScheduler")
+        .def(py::init<int, size_t>(), "Creates a scheduler stepping matches tick_rate times a second on a pool of threads (0 for one per core)",
+             py::arg("tick_rate") = 20, py::arg("threads") = 0)
+        .def("add", &MatchScheduler::add, "Schedules a match; False if its tick rate differs or it is already scheduled",
+             py::arg("match"), py::call_guard<py::gil_scoped_release>())
+        .def("remove", &MatchScheduler::remove, "Stops scheduling a match", py::arg("match"), py::call_guard<py::gil_scoped_release>())
+        .def("__len__", &MatchScheduler::size)
+        .def("wait_and_step", &MatchScheduler::waitAndStep,
+             "Sleeps until the next tick and steps every match once per due tick (at most max_catch_up); returns the ticks stepped",
+             py::arg("max_catch_up") = 4, py::call_guard<py::gil_scoped_release>())
+        .def("step_all", &MatchScheduler::stepAll, "Steps every match once now", py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("tick_rate", &MatchScheduler::tickRate)
+        .def_property_readonly("thread_count", &MatchScheduler::threadCount)
+        .def_property_readonly("last_step_seconds", &MatchScheduler::lastStepSeconds, "Wall time of the last step over all matches");
+
+    py::class_<MatchmakingIndex>(m, "MatchmakingIndex")
+        .def(py::init<int, double, int>(),
+             "Creates a queue pairing players within base_difference trophies, widening by widen_per_second while they wait, up to max_difference",
+             py::arg("base_difference") = 100, py::arg("widen_per_second") = 10.0, py::arg("max_difference") = 1000)
+        .def("add", &MatchmakingIndex::add, "Queues a player who started waiting at now (in seconds) and returns their id",
+             py::arg("trophies"), py::arg("now"))
+        .def("remove", &MatchmakingIndex::remove, "Takes a player out of the queue; False if they weren't in it", py::arg("id"))
+        .def("__contains__", &MatchmakingIndex::contains, py::arg("id"))
+        .def("__len__", &MatchmakingIndex::size)
+        .def("best_opponent", &MatchmakingIndex::bestOpponent,
+             "The closest queued player within id's current band, the longer-waiting on a tie; -1 if there's none",
+             py::arg("id"), py::arg("now"))
+        .def("pair", [](MatchmakingIndex& self, double now) {
+                 std::vector<std::pair<int, int>> pairs;
+                 {
+                     py::gil_scoped_release release;
+                     pairs = self.pairAll(now);
+                 }
+                 py::array_t<int> out({ static_cast<ssize_t>(pairs.size()), static_cast<ssize_t>(2) });
+                 int* data = out.mutable_data();
+                 for (size_t i = 0; i < pairs.size(); i++) {
+                     data[i * 2] = pairs[i].first;
+                     data[i * 2 + 1] = pairs[i].second;
+                 }
+                 return out;
+             }, "Pairs every compatible player, longest waiting first, and removes them; an (n, 2) array of ids, older first",
+             py::arg("now"))
+        .def("band", &MatchmakingIndex::band, "The trophy band of a player who has waited this many seconds", py::arg("waited"));
+
+    py::class_<PacketCodec>(m, "PacketCodec")
+        .def(py::init<>(), "Creates an empty codec; schemas are registered from Python type hints")
+        .def("define_enum", [](PacketCodec& self, const std::string& name, const py::sequence& members) {
+                 if (!self.defineEnum(name, members.ptr())) throw py::error_already_set();
+             }, "Registers an enum by its members, which encode as their index and decode as their value",
+             py::arg("name"), py::arg("members"))
+        .def("define_struct", [](PacketCodec& self, const std::string& name,
+                                 const std::vector<std::pair<std::string, std::string>>& fields) {
+                 if (!self.defineStruct(name, fields)) throw py::error_already_set();
+             }, "Registers a struct as (field, type spec) pairs in wire order", py::arg("name"), py::arg("fields"))
+        .def("is_defined", &PacketCodec::isDefined, py::arg("name"))
+        .def("bind", [](PacketCodec& self, int packetType, const std::string& root) {
+                 if (!self.bind(packetType, root)) throw py::error_already_set();
+             }, "Encodes packets of a type with a defined struct as the root", py::arg("packet_type"), py::arg("root"))
+        .def("supports", &PacketCodec::supports, "Whether a schema is bound for a packet type", py::arg("packet_type"))
+        .def("encode", [](PacketCodec& self, int packetType, const py::handle& value) {
+                 PyObject* out = self.encode(packetType, value.ptr());
+                 if (!out) throw py::error_already_set();
+                 return py::reinterpret_steal<py::bytes>(out);
+             }, "Encodes an object by its packet type's schema", py::arg("packet_type"), py::arg("value"))
+        .def("decode", [](PacketCodec& self, int packetType, const py::buffer& data) {
+                 const py::buffer_info info = requestPayload(data);
+                 PyObject* out = self.decode(packetType, static_cast<const Uint8*>(info.ptr), static_cast<size_t>(info.size));
+                 if (!out) throw py::error_already_set();
+                 return py::reinterpret_steal<py::object>(out);
+             }, "Decodes a binary payload into SimpleNamespaces", py::arg("packet_type"), py::arg("data"));
+    m.attr("PACKET_MARKER") = PacketCodec::Marker;
+
+    // Both keep a reference to their codec, which must outlive them
+    py::class_<DeltaEncoder>(m, "DeltaEncoder")
+        .def(py::init<PacketCodec&, int, size_t>(), "Server side of delta state sync for one client",
+             py::arg("codec"), py::arg("packet_type"), py::arg("history") = 8, py::keep_alive<1, 2>())
+        .def("encode", [](DeltaEncoder& self, const py::handle& state, Uint32 ack) {
+                 PyObject* out = self.encode(state.ptr(), ack);
+                 if (!out) throw py::error_already_set();
+                 return py::reinterpret_steal<py::bytes>(out);
+             }, "Encodes a state as a delta against the acked one if it's still held, otherwise in full",
+             py::arg("state"), py::arg("ack") = 0)
+        .def("reset", &DeltaEncoder::reset, "Forgets every sent state so the next one is full")
+        .def_property_readonly("last_sequence", &DeltaEncoder::lastSequence)
+        .def_property_readonly("last_was_delta", &DeltaEncoder::lastWasDelta)
+        .def_property_readonly("last_bytes", &DeltaEncoder::lastBytes);
+
+    py::class_<DeltaDecoder>(m, "DeltaDecoder")
+        .def(py::init<PacketCodec&, int, size_t>(), "Client side of delta state sync",
+             py::arg("codec"), py::arg("packet_type"), py::arg("history") = 8, py::keep_alive<1, 2>())
+        .def("apply", [](DeltaDecoder& self, const py::buffer& data) {
+                 const py::buffer_info info = requestPayload(data);
+                 PyObject* out = self.apply(static_cast<const Uint8*>(info.ptr), static_cast<size_t>(info.size));
+                 if (!out) throw py::error_already_set();
+                 return py::reinterpret_steal<py::object>(out);
+             }, "The state a payload carries; ValueError if its base is no longer held", py::arg("data"))
+        .def("reset", &DeltaDecoder::reset, "Forgets every state, so the next ack asks for a full one")
+        .def_property_readonly("last_sequence", &DeltaDecoder::lastSequence, "The sequence to ack");
+
+    py::class_<FrameReader>(m, "FrameReader")
+        .def(py::init<int, size_t>(), "Reads Packet frames from a socket fd into a fixed buffer of capacity bytes",
+             py::arg("fd"), py::arg("capacity") = static_cast<size_t>(1 << 20))
+        .def("fill", [](FrameReader& self, int timeoutMs) {
+                 long received;
+                 int err;
+                 {
+                     py::gil_scoped_release release;
+                     received = self.fill(timeoutMs);
+                     err = errno;
+                 }
+                 if (received == -2) {
+                     errno = err;
+                     PyErr_SetFromErrno(PyExc_OSError);
+                     throw py::error_already_set();
+                 }
+                 return received;
+             }, "Waits up to timeout_ms (-1 forever) and reads what has arrived; bytes read, 0 on timeout, -1 once closed",
+             py::arg("timeout_ms") = -1)
+        .def("drain", [](FrameReader& self, size_t maxFrames) {
+                 std::vector<Frame> frames;
+                 if (!self.drain(frames, maxFrames)) {
+                     throw py::value_error("Frame of " + std::to_string(self.oversized()) + " bytes exceeds the reader's capacity of " +
+                                           std::to_string(self.capacity()));
+                 }
+                 py::list out;
+                 for (const Frame& frame : frames) {
+                     out.append(py::make_tuple(frame.type, py::memoryview::from_memory(frame.data, static_cast<ssize_t>(frame.size))));
+                 }
+                 return out;
+             }, "Complete frames as (type, payload) with read-only memoryviews into the buffer, valid until the next fill",
+             py::arg("max_frames") = 0)
+        .def_property_readonly("fd", &FrameReader::fd)
+        .def_property_readonly("capacity", &FrameReader::capacity)
+        .def_property_readonly("buffered", &FrameReader::buffered, "Bytes read but not yet drained");
+
+#ifndef _WIN32
+    py::class_<EventLoop>(m, "EventLoop")
+        .def(py::init([](int port, size_t capacity) {
+                 auto loop = std::make_unique<EventLoop>(capacity);
+                 if (!loop->listen(port)) {
+                     PyErr_SetFromErrno(PyExc_OSError);
+                     throw py::error_already_set();
+                 }
+                 return loop;
+             }), "Listens on port (0 for any free one), reading each client's frames into a buffer of capacity bytes",
+             py::arg("port"), py::arg("capacity") = static_cast<size_t>(64 << 10))
+        .def("run_once", [](EventLoop& self, int timeoutMs, const py::function& callback) {
+                 bool polled;
+                 int err;
+                 {
+                     py::gil_scoped_release release;
+                     polled = self.poll(timeoutMs);
+                     err = errno;
+                 }
+                 if (!polled) {
+                     errno = err;
+                     PyErr_SetFromErrno(PyExc_OSError);
+                     throw py::error_already_set();
+                 }
+                 const LoopEvents& events = self.events();
+                 if (events.empty()) return static_cast<size_t>(0);
+
+                 py::list opened, frames, closed;
+                 for (int client : events.opened) {
+                     opened.append(client);
+                 }
+                 for (const ClientFrame& entry : events.frames) {
+                     frames.append(py::make_tuple(entry.client, entry.frame.type,
+                                                  py::memoryview::from_memory(entry.frame.data, static_cast<ssize_t>(entry.frame.size))));
+                 }
+                 for (int client : events.closed) {
+                     closed.append(client);
+                 }
+                 callback(opened, frames, closed);
+
+                 py::gil_scoped_release release;
+                 self.flush();
+                 return events.frames.size();
+             }, "Waits up to timeout_ms (-1 forever), calls callback(opened, frames, closed) once with what happened and "
+                "flushes what it sent. frames are (client, type, payload) with payloads valid until the next run_once; "
+                "returns how many there were",
+             py::arg("timeout_ms"), py::arg("callback"))
+        .def("send", [](EventLoop& self, int client, const py::buffer& data) {
+                 const py::buffer_info info = requestPayload(data);
+                 return self.send(client, static_cast<const Uint8*>(info.ptr), static_cast<size_t>(info.size));
+             }, "Queues framed packets for client, written at the next flush; False once it has closed",
+             py::arg("client"), py::arg("data"))
+        .def("close", &EventLoop::close, "Closes client after its queued writes, reporting it to the next run_once",
+             py::arg("client"))
+        .def("wake", &EventLoop::wake, "Ends a run_once that's waiting")
+        .def_property_readonly("port", &EventLoop::port)
+        .def_property_readonly("client_count", &EventLoop::clientCount);
+#endif
+
+    py::class_<FrameQueue>(m, "FrameQueue")
+        .def(py::init<bool, size_t>(), "A consumer queue: send order when plain, (available_at, priority, id) order when priority",
+             py::arg("priority") = false, py::arg("capacity") = static_cast<size_t>(1024))
+        .def("send", [](FrameQueue& self, const py::object& frame, double availableAt, long priority, Uint64 id) {
+                 return self.push(frame.ptr(), availableAt, priority, id);
+             }, "Queues frame; False if the plain lane is full or the queue is closed",
+             py::arg("frame"), py::arg("available_at") = 0.0, py::arg("priority") = 0, py::arg("id") = 0)
+        .def("send_front", [](FrameQueue& self, const py::object& frame, double availableAt, long priority, Uint64 id) {
+                 return self.pushFront(frame.ptr(), availableAt, priority, id);
+             }, "Puts back a frame just received, ahead of the rest of the plain lane; False if the queue is closed",
+             py::arg("frame"), py::arg("available_at") = 0.0, py::arg("priority") = 0, py::arg("id") = 0)
+        .def("receive", [](FrameQueue& self) -> py::object {
+                 PyObject* frame = self.pop();
+                 if (!frame) return py::none();
+                 return py::reinterpret_steal<py::object>(frame);
+             }, "The next due frame, or None")
+        .def("batch_receive", [](FrameQueue& self, size_t maxFrames, double timeout) {
+                 if (timeout != 0) {
+                     py::gil_scoped_release release;
+                     self.wait(timeout);
+                 }
+                 std::vector<PyObject*> frames;
+                 self.popBatch(frames, maxFrames);
+                 py::list out;
+                 for (PyObject* frame : frames) {
+                     out.append(py::reinterpret_steal<py::object>(frame));
+                 }
+                 return out;
+             }, "Up to max_frames (0 for all) due frames, first waiting up to timeout seconds (negative for no limit) "
+                "without the GIL if none are",
+             py::arg("max_frames") = 0, py::arg("timeout") = 0.0)
+        .def("take_all", [](FrameQueue& self) {
+                 std::vector<PyObject*> frames;
+                 self.takeAll(frames);
+                 py::list out;
+                 for (PyObject* frame : frames) {
+                     out.append(py::reinterpret_steal<py::object>(frame));
+                 }
+                 return out;
+             }, "Removes and returns every frame, due or not, in delivery order")
+        .def("clear", &FrameQueue::clear)
+        .def("wake", &FrameQueue::wake, "Ends every batch_receive that's waiting")
+        .def("close", &FrameQueue::close, "Refuses further sends and ends every wait")
+        .def("__len__", &FrameQueue::size)
+        .def_property_readonly("priority", &FrameQueue::isPriority)
+        .def_property_readonly("closed", &FrameQueue::isClosed)
+        .def_property_readonly("next_available", &FrameQueue::nextAvailable,
+                               "available_at of the next priority frame, inf if there's none");
+
+py::enum_<SDL_Scancode>(m, "SDL_Scancode")
+        .value("Unknown", SDL_SCANCODE_UNKNOWN)
+        .value("A", SDL_SCANCODE_A)
+        .value("B", SDL_SCANCODE_B)
+        .value("C", SDL_SCANCODE_C)
+        .value("D", SDL_SCANCODE_D)
+        .value("E", SDL_SCANCODE_E)
+        .value("F", SDL_SCANCODE_F)
+        .value("G", SDL_SCANCODE_G)
+        .value("H", SDL_SCANCODE_H)
+        .value("I", SDL_SCANCODE_I)
+        .value("J", SDL_SCANCODE_J)
+        .value("K", SDL_SCANCODE_K)
+        .value("L", SDL_SCANCODE_L)
+        .value("M", SDL_SCANCODE_M)
+        .value("N", SDL_SCANCODE_N)
+        .value("O", SDL_SCANCODE_O)
+        .value("P", SDL_SCANCODE_P)
+        .value("Q", SDL_SCANCODE_Q)
+        .value("R", SDL_SCANCODE_R)
+        .value("S", SDL_SCANCODE_S)
+        .value("T", SDL_SCANCODE_T)
+        .value("U", SDL_SCANCODE_U)
+        .value("V", SDL_SCANCODE_V)
+        .value("W", SDL_SCANCODE_W)
+        .value("X", SDL_SCANCODE_X)
+        .value("Y", SDL_SCANCODE_Y)
+        .value("Z", SDL_SCANCODE_Z)
+        .value("One", SDL_SCANCODE_1)
+        .value("Two", SDL_SCANCODE_2)
+        .value("Three", SDL_SCANCODE_3)
+        .value("Four", SDL_SCANCODE_4)
+        .value("Five", SDL_SCANCODE_5)
+        .value("Six", SDL_SCANCODE_6)
+        .value("Seven", SDL_SCANCODE_7)
+        .value("Eight", SDL_SCANCODE_8)
+        .value("Nine", SDL_SCANCODE_9)
+        .value("Zero", SDL_SCANCODE_0)
+        .value("Return", SDL_SCANCODE_RETURN)
+        .value("Escape", SDL_SCANCODE_ESCAPE)
+        .value("Backspace", SDL_SCANCODE_BACKSPACE)
+        .value("Tab", SDL_SCANCODE_TAB)
+        .value("Space", SDL_SCANCODE_SPACE)
+        .value("Minus", SDL_SCANCODE_MINUS)
+        .value("Equals", SDL_SCANCODE_EQUALS)
+        .value("LeftBracket", SDL_SCANCODE_LEFTBRACKET)
+        .value("RightBracket", SDL_SCANCODE_RIGHTBRACKET)
+        .value("Backslash", SDL_SCANCODE_BACKSLASH)
+        .value("Semicolon", SDL_SCANCODE_SEMICOLON)
+        .value("Apostrophe", SDL_SCANCODE_APOSTROPHE)
+        .value("Grave", SDL_SCANCODE_GRAVE)
+        .value("Comma", SDL_SCANCODE_COMMA)
+        .value("Period", SDL_SCANCODE_PERIOD)
+        .value("Slash", SDL_SCANCODE_SLASH)
+        .value("CapsLock", SDL_SCANCODE_CAPSLOCK)
+        .value("F1", SDL_SCANCODE_F1)
+        .value("F2", SDL_SCANCODE_F2)
+        .value("F3", SDL_SCANCODE_F3)
+        .value("F4", SDL_SCANCODE_F4)
+        .value("F5", SDL_SCANCODE_F5)
+        .value("F6", SDL_SCANCODE_F6)
+        .value("F7", SDL_SCANCODE_F7)
+        .value("F8", SDL_SCANCODE_F8)
+        .value("F9", SDL_SCANCODE_F9)
+        .value("F10", SDL_SCANCODE_F10)
+        .value("F11", SDL_SCANCODE_F11)
+        .value("F12", SDL_SCANCODE_F12)
+        .value("Right", SDL_SCANCODE_RIGHT)  // Added Right Arrow
+        .value("Left", SDL_SCANCODE_LEFT)    // Added Left Arrow
+        .value("Down", SDL_SCANCODE_DOWN)   // Added Down Arrow
+        .value("Up", SDL_SCANCODE_UP)     // Added Up Arrow
+        .export_values();
+
+      py::class_<SDL_Event>(m, "SDL_Event")
+        .def(py::init<>())
+        .def_readwrite("type", &SDL_Event::type)
+        .def_readwrite("key", &SDL_Event::key)
+        .def_readwrite("motion", &SDL_Event::motion)
+        .def_readwrite("button", &SDL_Event::button)
+        .def_readwrite("window", &SDL_Event::window)
+        .def_readwrite("quit", &SDL_Event::quit)
+        .def_readwrite("user", &SDL_Event::user)
+        .def_readwrite("jdevice", &SDL_Event::jdevice)
+        .def_readwrite("cdevice", &SDL_Event::cdevice)
+        .def_readwrite("sensor", &SDL_Event::sensor)
+        .def_readwrite("adevice", &SDL_Event::adevice);
+
+    py::class_<SDL_KeyboardEvent>(m, "SDL_KeyboardEvent")
+        .def_readwrite("type", &SDL_KeyboardEvent::type)
+        .def_readwrite("timestamp", &SDL_KeyboardEvent::timestamp)
+        .def_readwrite("windowID", &SDL_KeyboardEvent::windowID)
+        .def_readwrite("state", &SDL_KeyboardEvent::state)
+        .def_readwrite("repeat", &SDL_KeyboardEvent::repeat)
+        .def_readwrite("keysym", &SDL_KeyboardEvent::keysym);
+
+    py::class_<SDL_MouseMotionEvent>(m, "SDL_MouseMotionEvent")
+        .def_readwrite("type", &SDL_MouseMotionEvent::type)
+        .def_readwrite("timestamp", &SDL_MouseMotionEvent::timestamp)
+        .def_readwrite("windowID", &SDL_MouseMotionEvent::windowID)
+        .def_readwrite("which", &SDL_MouseMotionEvent::which)
+        .def_readwrite("state", &SDL_MouseMotionEvent::state)
+        .def_readwrite("x", &SDL_MouseMotionEvent::x)
+        .def_readwrite("y", &SDL_MouseMotionEvent::y)
+        .def_readwrite("xrel", &SDL_MouseMotionEvent::xrel)
+        .def_readwrite("yrel", &SDL_MouseMotionEvent::yrel);
+
+    py::class_<SDL_MouseButtonEvent>(m, "SDL_MouseButtonEvent")
+        .def_readwrite("type", &SDL_MouseButtonEvent::type)
+        .def_readwrite("timestamp", &SDL_MouseButtonEvent::timestamp)
+        .def_readwrite("windowID", &SDL_MouseButtonEvent::windowID)
+        .def_readwrite("which", &SDL_MouseButtonEvent::which)
+        .def_readwrite("button", &SDL_MouseButtonEvent::button)
+        .def_readwrite("state", &SDL_MouseButtonEvent::state)
+        .def_readwrite("x", &SDL_MouseButtonEvent::x)
+        .def_readwrite("y", &SDL_MouseButtonEvent::y);
+
+    py::class_<SDL_WindowEvent>(m, "SDL_WindowEvent")
+        .def_readwrite("type", &SDL_WindowEvent::type)
+        .def_readwrite("timestamp", &SDL_WindowEvent::timestamp)
+        .def_readwrite("windowID", &SDL_WindowEvent::windowID)
+        .def_readwrite("event", &SDL_WindowEvent::event)
+        .def_readwrite("data1", &SDL_WindowEvent::data1)
+        .def_readwrite("data2", &SDL_WindowEvent::data2);
+
+    py::class_<SDL_QuitEvent>(m, "SDL_QuitEvent")
+        .def_readwrite("type", &SDL_QuitEvent::type)
+        .def_readwrite("timestamp", &SDL_QuitEvent::timestamp);
+
+    py::class_<SDL_UserEvent>(m, "SDL_UserEvent")
+        .def_readwrite("type", &SDL_UserEvent::type)
+        .def_readwrite("timestamp", &SDL_UserEvent::timestamp)
+        .def_readwrite("windowID", &SDL_UserEvent::windowID)
+        .def_readwrite("code", &SDL_UserEvent::code)
+        .def_readwrite("data1", &SDL_UserEvent::data1)
+        .def_readwrite("data2", &SDL_UserEvent::data2);
+
+    py::class_<SDL_JoyDeviceEvent>(m, "SDL_JoyDeviceEvent")
+        .def_readwrite("type", &SDL_JoyDeviceEvent::type)
+        .def_readwrite("timestamp", &SDL_JoyDeviceEvent::timestamp)
+        .def_readwrite("which", &SDL_JoyDeviceEvent::which);
+
+    py::class_<SDL_ControllerDeviceEvent>(m, "SDL_ControllerDeviceEvent")
+        .def_readwrite("type", &SDL_ControllerDeviceEvent::type)
+        .def_readwrite("timestamp", &SDL_ControllerDeviceEvent::timestamp)
+        .def_readwrite("which", &SDL_ControllerDeviceEvent::which);
+
+    py::class_<SDL_SensorEvent>(m, "SDL_SensorEvent")
+        .def_readwrite("type", &SDL_SensorEvent::type)
+        .def_readwrite("timestamp", &SDL_SensorEvent::timestamp)
+        .def_readwrite("which", &SDL_SensorEvent::which);
+
+    py::class_<SDL_AudioDeviceEvent>(m, "SDL_AudioDeviceEvent")
+        .def_readwrite("type", &SDL_AudioDeviceEvent::type)
+        .def_readwrite("timestamp", &SDL_AudioDeviceEvent::timestamp)
+        .def_readwrite("which", &SDL_AudioDeviceEvent::which)
+        .def_readwrite("iscapture", &SDL_AudioDeviceEvent::iscapture);
+
+    py::class_<SDL_Keysym>(m, "SDL_Keysym")
+        .def_readwrite("scancode", &SDL_Keysym::scancode)
+        .def_readwrite("sym", &SDL_Keysym::sym)
+        .def_readwrite("mod", &SDL_Keysym::mod)
+        .def_readwrite("unused", &SDL_Keysym::unused);
+
+      py::enum_<SDL_EventType>(m, "SDL_EventType")
+        .value("QUIT", SDL_QUIT)
+        .value("KEYDOWN", SDL_KEYDOWN)
+        .value("KEYUP", SDL_KEYUP)
+        .value("MOUSEMOTION", SDL_MOUSEMOTION)
+        .value("MOUSEBUTTONDOWN", SDL_MOUSEBUTTONDOWN)
+        .value("MOUSEBUTTONUP", SDL_MOUSEBUTTONUP)
+        .value("WINDOWEVENT", SDL_WINDOWEVENT)
+        .value("JOYDEVICEADDED", SDL_JOYDEVICEADDED)
+        .value("JOYDEVICEREMOVED", SDL_JOYDEVICEREMOVED)
+        .value("JOYAXISMOTION", SDL_JOYAXISMOTION)
+        .value("JOYBALLMOTION", SDL_JOYBALLMOTION)
+        .value("JOYHATMOTION", SDL_JOYHATMOTION)
+        .value("JOYBUTTONDOWN", SDL_JOYBUTTONDOWN)
+        .value("JOYBUTTONUP", SDL_JOYBUTTONUP)
+        .value("CONTROLLERDEVICEADDED", SDL_CONTROLLERDEVICEADDED)
+        .value("CONTROLLERDEVICEREMOVED", SDL_CONTROLLERDEVICEREMOVED)
+        .value("CONTROLLERAXISMOTION", SDL_CONTROLLERAXISMOTION)
+        .value("CONTROLLERBUTTONDOWN", SDL_CONTROLLERBUTTONDOWN)
+        .value("CONTROLLERBUTTONUP", SDL_CONTROLLERBUTTONUP)
+        .value("SENSORUPDATE", SDL_SENSORUPDATE)
+        .value("AUDIODEVICEADDED", SDL_AUDIODEVICEADDED)
+        .value("AUDIODEVICEREMOVED", SDL_AUDIODEVICEREMOVED)
+        // Add all required SDL_EventType values.
+        .export_values();
+
+  m.attr("SDL_BUTTON_LEFT") = SDL_BUTTON_LEFT;
+m.attr("SDL_BUTTON_MIDDLE") = SDL_BUTTON_MIDDLE;
+m.attr("SDL_BUTTON_RIGHT") = SDL_BUTTON_RIGHT;
+m.attr("SDL_BUTTON_X1") = SDL_BUTTON_X1;
+m.attr("SDL_BUTTON_X2") = SDL_BUTTON_X2;
+
+
+}
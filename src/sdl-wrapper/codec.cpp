@@ -0,0 +1,113 @@
+#include "codec.h"
+#include <cstring>
+
+void ByteWriter::writeVarint(Uint64 value) {
+    while (value >= 0x80) {
+        buf.push_back(static_cast<Uint8>(value) | 0x80);
+        value >>= 7;
+    }
+    buf.push_back(static_cast<Uint8>(value));
+}
+
+void ByteWriter::writeFixed32(Uint32 value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        buf.push_back(static_cast<Uint8>(value >> shift));
+    }
+}
+
+void ByteWriter::writeFloat(float value) {
+    Uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeFixed32(bits);
+}
+
+void ByteWriter::writeDouble(double value) {
+    Uint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    writeFixed32(static_cast<Uint32>(bits));
+    writeFixed32(static_cast<Uint32>(bits >> 32));
+}
+
+void ByteWriter::writeBytes(const void* data, size_t size) {
+    const Uint8* bytes = static_cast<const Uint8*>(data);
+    buf.insert(buf.end(), bytes, bytes + size);
+}
+
+void ByteWriter::writeString(const char* data, size_t size) {
+    writeVarint(size);
+    writeBytes(data, size);
+}
+
+bool ByteReader::readByte(Uint8& out) {
+    if (cur == end) return false;
+    out = *cur++;
+    return true;
+}
+
+bool ByteReader::readVarint(Uint64& out) {
+    Uint64 value = 0;
+    const Uint8* p = cur;
+    // Ten bytes carry all 64 bits; anything longer is corrupt
+    for (int shift = 0; shift < 70 && p != end; shift += 7) {
+        const Uint8 byte = *p++;
+        value |= static_cast<Uint64>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            cur = p;
+            out = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ByteReader::readZigzag(Sint64& out) {
+    Uint64 raw;
+    if (!readVarint(raw)) return false;
+    out = static_cast<Sint64>(raw >> 1) ^ -static_cast<Sint64>(raw & 1);
+    return true;
+}
+
+bool ByteReader::readFixed32(Uint32& out) {
+    if (remaining() < 4) return false;
+    out = static_cast<Uint32>(cur[0]) | static_cast<Uint32>(cur[1]) << 8 | static_cast<Uint32>(cur[2]) << 16 |
+          static_cast<Uint32>(cur[3]) << 24;
+    cur += 4;
+    return true;
+}
+
+bool ByteReader::readFloat(float& out) {
+    Uint32 bits;
+    if (!readFixed32(bits)) return false;
+    std::memcpy(&out, &bits, sizeof(out));
+    return true;
+}
+
+bool ByteReader::readDouble(double& out) {
+    if (remaining() < 8) return false;
+    Uint32 low, high;
+    readFixed32(low);
+    readFixed32(high);
+    const Uint64 bits = static_cast<Uint64>(high) << 32 | low;
+    std::memcpy(&out, &bits, sizeof(out));
+    return true;
+}
+
+bool ByteReader::readBytes(size_t size, const Uint8*& out) {
+    if (remaining() < size) return false;
+    out = cur;
+    cur += size;
+    return true;
+}
+
+bool ByteReader::readString(const char*& out, size_t& size) {
+    const Uint8* start = cur;
+    Uint64 length;
+    const Uint8* bytes;
+    if (!readVarint(length) || length > remaining() || !readBytes(static_cast<size_t>(length), bytes)) {
+        cur = start;
+        return false;
+    }
+    out = reinterpret_cast<const char*>(bytes);
+    size = static_cast<size_t>(length);
+    return true;
+}
@@ -0,0 +1,56 @@
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <SDL.h>
+#include <string>
+#include <vector>
+
+// Growable little-endian output buffer for the binary packet formats. Integers go out as LEB128
+// varints (signed ones zigzagged first, so small negatives stay short); floats and doubles are fixed
+// width so they round-trip exactly.
+class ByteWriter {
+public:
+    void clear() { buf.clear(); }
+    void reserve(size_t bytes) { buf.reserve(bytes); }
+
+    void writeByte(Uint8 value) { buf.push_back(value); }
+    void writeVarint(Uint64 value);
+    void writeZigzag(Sint64 value) { writeVarint((static_cast<Uint64>(value) << 1) ^ static_cast<Uint64>(value >> 63)); }
+    void writeFixed32(Uint32 value);
+    void writeFloat(float value);
+    void writeDouble(double value);
+    void writeBytes(const void* data, size_t size);
+    // Length-prefixed with a varint
+    void writeString(const char* data, size_t size);
+
+    const Uint8* data() const { return buf.data(); }
+    size_t size() const { return buf.size(); }
+
+private:
+    std::vector<Uint8> buf;
+};
+
+// Bounds-checked reader over a borrowed buffer. Every read returns false instead of running past the
+// end (or on an overlong varint), leaving the output untouched.
+class ByteReader {
+public:
+    ByteReader(const Uint8* data, size_t size) : cur(data), end(data + size) {}
+
+    bool readByte(Uint8& out);
+    bool readVarint(Uint64& out);
+    bool readZigzag(Sint64& out);
+    bool readFixed32(Uint32& out);
+    bool readFloat(float& out);
+    bool readDouble(double& out);
+    // Points out at the next size bytes in place, without copying
+    bool readBytes(size_t size, const Uint8*& out);
+    bool readString(const char*& out, size_t& size);
+
+    size_t remaining() const { return static_cast<size_t>(end - cur); }
+
+private:
+    const Uint8* cur;
+    const Uint8* end;
+};
+
+#endif
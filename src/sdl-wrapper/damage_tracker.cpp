@@ -0,0 +1,75 @@
+#include "damage_tracker.h"
+
+void DamageTracker::_add(const SDL_Rect& rect) {
+    if (rect.w <= 0 || rect.h <= 0) return;
+    if (pending.w <= 0 || pending.h <= 0) {
+        pending = rect;
+    } else {
+        SDL_UnionRect(&pending, &rect, &pending);
+    }
+}
+
+bool DamageTracker::track(Uint64 key, Uint64 signature, const SDL_Rect& bounds) {
+    auto found = tracked.find(key);
+    if (found == tracked.end()) {
+        tracked.emplace(key, Entry{ signature, bounds, frame });
+        _add(bounds);
+        return true;
+    }
+    Entry& entry = found->second;
+    entry.frame = frame;
+    if (entry.signature == signature && SDL_RectEquals(&entry.bounds, &bounds)) return false;
+    _add(entry.bounds);
+    _add(bounds);
+    entry.signature = signature;
+    entry.bounds = bounds;
+    return true;
+}
+
+void DamageTracker::forget(Uint64 key) {
+    auto found = tracked.find(key);
+    if (found == tracked.end()) return;
+    _add(found->second.bounds);
+    tracked.erase(found);
+}
+
+void DamageTracker::invalidate(const SDL_Rect& rect) {
+    _add(rect);
+}
+
+void DamageTracker::invalidateAll() {
+    everything.store(true);
+}
+
+void DamageTracker::reset() {
+    tracked.clear();
+    pending = current = SDL_Rect{ 0, 0, 0, 0 };
+    everything.store(true);
+}
+
+bool DamageTracker::beginFrame(int screenW, int screenH, SDL_Rect& out) {
+    // Whatever wasn't drawn last frame has gone, so the pixels it left behind are stale
+    for (auto it = tracked.begin(); it != tracked.end();) {
+        if (it->second.frame != frame) {
+            _add(it->second.bounds);
+            it = tracked.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    frame++;
+
+    const SDL_Rect screen{ 0, 0, screenW, screenH };
+    if (everything.exchange(false)) {
+        current = screen;
+    } else if (!SDL_IntersectRect(&pending, &screen, &current)) {
+        current = SDL_Rect{ 0, 0, 0, 0 };
+    }
+    pending = SDL_Rect{ 0, 0, 0, 0 };
+    out = current;
+    return current.w > 0 && current.h > 0;
+}
+
+bool DamageTracker::isDamaged(const SDL_Rect& rect) const {
+    return SDL_HasIntersection(&rect, &current) == SDL_TRUE;
+}
@@ -0,0 +1,45 @@
+#ifndef DAMAGE_TRACKER_H
+#define DAMAGE_TRACKER_H
+
+#include <SDL.h>
+#include <atomic>
+#include <unordered_map>
+
+// Works out which part of a retained frame has to be redrawn. Callers describe each thing they draw
+// with a key, a signature of its current look and its bounds; whenever the signature or bounds of a
+// key change, or a key stops being tracked, its old and new bounds are damaged. beginFrame folds it
+// all into one rect, since SDL clips to a single rectangle.
+class DamageTracker {
+public:
+    // Returns true if this damaged anything
+    bool track(Uint64 key, Uint64 signature, const SDL_Rect& bounds);
+    void forget(Uint64 key);
+    void invalidate(const SDL_Rect& rect);
+    // Safe from any thread
+    void invalidateAll();
+    void reset();
+
+    // Drops keys that weren't tracked since the previous call, then returns whether anything within
+    // a screenW x screenH screen is damaged, with its bounds in out. Clears the damage.
+    bool beginFrame(int screenW, int screenH, SDL_Rect& out);
+    bool isDamaged(const SDL_Rect& rect) const;
+    const SDL_Rect& frameDamage() const { return current; }
+    size_t trackedCount() const { return tracked.size(); }
+
+private:
+    struct Entry {
+        Uint64 signature;
+        SDL_Rect bounds;
+        Uint64 frame;
+    };
+
+    std::unordered_map<Uint64, Entry> tracked;
+    Uint64 frame = 0;
+    SDL_Rect pending{ 0, 0, 0, 0 };
+    SDL_Rect current{ 0, 0, 0, 0 };
+    std::atomic<bool> everything{ true };
+
+    void _add(const SDL_Rect& rect);
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "delta_sync.h"
+#include <algorithm>
+
+DeltaEncoder::DeltaEncoder(PacketCodec& codec, int packetType, size_t history)
+    : codec(codec), packetType(packetType), history(std::max<size_t>(history, 1)) {}
+
+PyObject* DeltaEncoder::encode(PyObject* state, Uint32 ack) {
+    // The client only acks forward, so anything before its ack can never be a base again
+    while (!sent.empty() && ack != 0 && sent.front().first < ack) {
+        sent.pop_front();
+    }
+    const Snapshot* base = nullptr;
+    if (ack != 0 && !sent.empty() && sent.front().first == ack) {
+        base = &sent.front().second;
+    }
+
+    Snapshot current;
+    if (!codec.snapshot(packetType, state, current)) return nullptr;
+
+    out.clear();
+    out.writeByte(PacketCodec::Marker);
+    out.writeVarint(sequence + 1);
+    out.writeVarint(base ? ack : 0);
+    if (base) {
+        if (!codec.writeDelta(packetType, *base, current, out)) return nullptr;
+    } else {
+        out.writeBytes(current.bytes.data(), current.bytes.size());
+    }
+
+    PyObject* payload = PyBytes_FromStringAndSize(reinterpret_cast<const char*>(out.data()), static_cast<Py_ssize_t>(out.size()));
+    if (!payload) return nullptr;
+    sequence++;
+    lastDelta = base != nullptr;
+    lastSize = out.size();
+    sent.emplace_back(sequence, std::move(current));
+    while (sent.size() > history) {
+        sent.pop_front();
+    }
+    return payload;
+}
+
+DeltaDecoder::DeltaDecoder(PacketCodec& codec, int packetType, size_t history)
+    : codec(codec), packetType(packetType), history(std::max<size_t>(history, 1)) {}
+
+DeltaDecoder::~DeltaDecoder() {
+    reset();
+}
+
+void DeltaDecoder::reset() {
+    for (auto& entry : received) {
+        Py_DECREF(entry.second);
+    }
+    received.clear();
+}
+
+PyObject* DeltaDecoder::apply(const Uint8* data, size_t size) {
+    ByteReader in(data, size);
+    Uint8 marker;
+    Uint64 sequence, base;
+    if (!in.readByte(marker) || marker != PacketCodec::Marker || !in.readVarint(sequence) || !in.readVarint(base) ||
+        sequence == 0 || sequence > UINT32_MAX) {
+        PyErr_SetString(PyExc_ValueError, "Not a delta sync payload");
+        return nullptr;
+    }
+
+    PyObject* state;
+    if (base == 0) {
+        state = codec.decodeValue(packetType, in);
+    } else {
+        auto it = std::find_if(received.begin(), received.end(), [base](const auto& entry) { return entry.first == base; });
+        if (it == received.end()) {
+            PyErr_Format(PyExc_ValueError, "Delta base %llu is no longer held", static_cast<unsigned long long>(base));
+            return nullptr;
+        }
+        state = codec.applyDelta(packetType, it->second, in);
+    }
+    if (state && in.remaining() != 0) {
+        Py_CLEAR(state);
+        PyErr_SetString(PyExc_ValueError, "Trailing bytes after packet");
+    }
+    if (!state) return nullptr;
+
+    Py_INCREF(state);
+    received.emplace_back(static_cast<Uint32>(sequence), state);
+    while (received.size() > history) {
+        Py_DECREF(received.front().second);
+        received.pop_front();
+    }
+    return state;
+}
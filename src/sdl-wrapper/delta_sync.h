@@ -0,0 +1,63 @@
+#ifndef DELTA_SYNC_H
+#define DELTA_SYNC_H
+
+#include "packet_codec.h"
+#include <deque>
+#include <utility>
+
+// Both ends of delta-compressed state sync for one connection. Every state is numbered; a payload is
+// Marker, its sequence, its base sequence (0 for a full state) and then either the full value or a
+// PacketCodec delta against the base. The client acks the last sequence it applied and the server
+// diffs against that, so a lost or late ack only costs a bigger delta or a full state.
+//
+// Like PacketCodec, both must be used with the GIL held and report failure with a Python exception.
+class DeltaEncoder {
+public:
+    // history caps the states kept while waiting for an ack
+    DeltaEncoder(PacketCodec& codec, int packetType, size_t history = 8);
+
+    // A new bytes object for state, diffed against the state numbered ack if it's still held
+    PyObject* encode(PyObject* state, Uint32 ack);
+    // Drops every held state, so the next payload is full
+    void reset() { sent.clear(); }
+
+    Uint32 lastSequence() const { return sequence; }
+    // Whether the last payload was a delta, and its size
+    bool lastWasDelta() const { return lastDelta; }
+    size_t lastBytes() const { return lastSize; }
+
+private:
+    PacketCodec& codec;
+    int packetType;
+    size_t history;
+    Uint32 sequence = 0;
+    bool lastDelta = false;
+    size_t lastSize = 0;
+    std::deque<std::pair<Uint32, Snapshot>> sent; // Oldest first; nothing older than the last ack
+    ByteWriter out;
+};
+
+class DeltaDecoder {
+public:
+    DeltaDecoder(PacketCodec& codec, int packetType, size_t history = 8);
+    ~DeltaDecoder();
+
+    DeltaDecoder(const DeltaDecoder&) = delete;
+    DeltaDecoder& operator=(const DeltaDecoder&) = delete;
+
+    // A new reference to the state a payload carries; fails with ValueError if its base is no longer
+    // held, after which the caller should reset and ack 0 to get a full state
+    PyObject* apply(const Uint8* data, size_t size);
+    void reset();
+
+    // What to ack: the newest state applied, 0 before the first or after a reset
+    Uint32 lastSequence() const { return received.empty() ? 0 : received.back().first; }
+
+private:
+    PacketCodec& codec;
+    int packetType;
+    size_t history;
+    std::deque<std::pair<Uint32, PyObject*>> received; // Owned, oldest first
+};
+
+#endif
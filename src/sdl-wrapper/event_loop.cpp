@@ -0,0 +1,414 @@
+#include "event_loop.h"
+#include <algorithm>
+#include <cerrno>
+
+#ifdef _WIN32
+
+// No pipe or readiness API to build on; the Server keeps its threads there
+EventLoop::EventLoop(size_t capacity) : capacity(capacity) {}
+EventLoop::~EventLoop() {}
+bool EventLoop::listen(int) {
+    errno = ENOSYS;
+    return false;
+}
+bool EventLoop::poll(int) {
+    errno = ENOSYS;
+    return false;
+}
+void EventLoop::flush() {}
+bool EventLoop::send(int, const Uint8*, size_t) { return false; }
+void EventLoop::close(int) {}
+void EventLoop::wake() {}
+size_t EventLoop::clientCount() const { return 0; }
+
+#else
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#define EVENT_LOOP_EPOLL
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+#include <sys/event.h>
+#define EVENT_LOOP_KQUEUE
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // SO_NOSIGPIPE is set on each socket instead
+#endif
+
+static bool setNonBlocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0 && fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+EventLoop::EventLoop(size_t capacity) : capacity(capacity) {}
+
+EventLoop::~EventLoop() {
+    for (auto& entry : connections) {
+        ::close(entry.second->fd);
+    }
+    for (int fd : { listener, poller, wakeRead, wakeWrite }) {
+        if (fd >= 0) ::close(fd);
+    }
+}
+
+bool EventLoop::listen(int port) {
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) return false;
+    const int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    socklen_t length = sizeof(addr);
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listener, SOMAXCONN) != 0 ||
+        !setNonBlocking(listener) || getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+        return false;
+    }
+    boundPort = ntohs(addr.sin_port);
+
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    wakeRead = fds[0];
+    wakeWrite = fds[1];
+    if (!setNonBlocking(wakeRead) || !setNonBlocking(wakeWrite)) return false;
+
+#if defined(EVENT_LOOP_EPOLL)
+    poller = epoll_create1(EPOLL_CLOEXEC);
+    if (poller < 0) return false;
+#elif defined(EVENT_LOOP_KQUEUE)
+    poller = kqueue();
+    if (poller < 0) return false;
+#endif
+    _register(listener, ListenToken);
+    _register(wakeRead, WakeToken);
+    return true;
+}
+
+void EventLoop::_register(int fd, long token) {
+#if defined(EVENT_LOOP_EPOLL)
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = static_cast<Uint64>(token);
+    epoll_ctl(poller, EPOLL_CTL_ADD, fd, &event);
+#elif defined(EVENT_LOOP_KQUEUE)
+    struct kevent change;
+    EV_SET(&change, fd, EVFILT_READ, EV_ADD, 0, 0, reinterpret_cast<void*>(static_cast<intptr_t>(token)));
+    kevent(poller, &change, 1, nullptr, 0, nullptr);
+#else
+    (void)fd;
+    (void)token; // poll is handed every socket each time
+#endif
+}
+
+void EventLoop::_watchWrites(Connection& conn, long token, bool on) {
+    if (conn.writing == on) return;
+    conn.writing = on;
+#if defined(EVENT_LOOP_EPOLL)
+    epoll_event event{};
+    event.events = EPOLLIN | (on ? static_cast<Uint32>(EPOLLOUT) : 0);
+    event.data.u64 = static_cast<Uint64>(token);
+    epoll_ctl(poller, EPOLL_CTL_MOD, conn.fd, &event);
+#elif defined(EVENT_LOOP_KQUEUE)
+    struct kevent change;
+    EV_SET(&change, conn.fd, EVFILT_WRITE, on ? EV_ADD | EV_ENABLE : EV_DELETE, 0, 0,
+           reinterpret_cast<void*>(static_cast<intptr_t>(token)));
+    kevent(poller, &change, 1, nullptr, 0, nullptr);
+#else
+    (void)token;
+#endif
+}
+
+bool EventLoop::_wait(int timeoutMs) {
+    readiness.clear();
+#if defined(EVENT_LOOP_EPOLL)
+    epoll_event events[256];
+    const int count = epoll_wait(poller, events, 256, timeoutMs);
+    if (count < 0) return errno == EINTR;
+    for (int i = 0; i < count; i++) {
+        // Hangups and errors are picked up by the read that follows
+        const Uint32 flags = events[i].events;
+        readiness.push_back(Readiness{ static_cast<long>(static_cast<int64_t>(events[i].data.u64)),
+                                       (flags & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0, (flags & EPOLLOUT) != 0 });
+    }
+#elif defined(EVENT_LOOP_KQUEUE)
+    struct kevent events[256];
+    timespec timeout{ timeoutMs / 1000, (timeoutMs % 1000) * 1000000L };
+    const int count = kevent(poller, nullptr, 0, events, 256, timeoutMs < 0 ? nullptr : &timeout);
+    if (count < 0) return errno == EINTR;
+    for (int i = 0; i < count; i++) {
+        // One event per filter, so a socket that's readable and writable comes up twice
+        const long token = static_cast<long>(reinterpret_cast<intptr_t>(events[i].udata));
+        readiness.push_back(Readiness{ token, events[i].filter == EVFILT_READ, events[i].filter == EVFILT_WRITE });
+    }
+#else
+    std::vector<pollfd> fds;
+    std::vector<long> tokens;
+    fds.push_back(pollfd{ listener, POLLIN, 0 });
+    tokens.push_back(ListenToken);
+    fds.push_back(pollfd{ wakeRead, POLLIN, 0 });
+    tokens.push_back(WakeToken);
+    for (auto& entry : connections) {
+        const short events = (entry.second->draining ? 0 : POLLIN) | (entry.second->writing ? POLLOUT : 0);
+        fds.push_back(pollfd{ entry.second->fd, events, 0 });
+        tokens.push_back(entry.first);
+    }
+    const int count = ::poll(fds.data(), static_cast<nfds_t>(fds.size()), timeoutMs);
+    if (count < 0) return errno == EINTR;
+    for (size_t i = 0; i < fds.size(); i++) {
+        const short flags = fds[i].revents;
+        if (flags == 0) continue;
+        readiness.push_back(Readiness{ tokens[i], (flags & (POLLIN | POLLHUP | POLLERR)) != 0, (flags & POLLOUT) != 0 });
+    }
+#endif
+    return true;
+}
+
+bool EventLoop::poll(int timeoutMs) {
+    loopThread.store(std::this_thread::get_id());
+    ready.opened.clear();
+    ready.frames.clear();
+    ready.closed.clear();
+    // Nothing from the last poll is handed out any more
+    retired.clear();
+
+    flush();
+    std::vector<int> requested;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        requested.swap(closing);
+    }
+    for (int client : requested) {
+        auto it = connections.find(client);
+        if (it != connections.end() && !it->second->draining) _close(client, *it->second);
+    }
+    // Report those closes now rather than after the next bit of traffic
+    if (!requested.empty()) timeoutMs = 0;
+    timeoutMs = _retireDrained(timeoutMs);
+
+    if (!_wait(timeoutMs)) return false;
+    for (const Readiness& entry : readiness) {
+        if (entry.token == ListenToken) {
+            _accept();
+            continue;
+        }
+        if (entry.token == WakeToken) {
+            Uint8 drained[64];
+            woken.store(false);
+            while (read(wakeRead, drained, sizeof(drained)) > 0) {}
+            continue;
+        }
+        const int client = static_cast<int>(entry.token);
+        auto it = connections.find(client);
+        if (it == connections.end()) continue; // Closed earlier in this poll
+        Connection& conn = *it->second;
+        if (entry.writable) _write(client, conn);
+        if (conn.draining) {
+            // Only hangups and errors are still reported; either of them, or an empty queue, ends it
+            if (conn.out.empty() || entry.readable) _retire(client);
+            continue;
+        }
+        if (entry.readable) _read(client, conn);
+    }
+    return true;
+}
+
+void EventLoop::_close(int client, Connection& conn) {
+    // flush has just run, so anything left is waiting on the socket
+    if (conn.out.empty()) {
+        _retire(client);
+        return;
+    }
+    conn.draining = true;
+    conn.closeBy = Clock::now() + std::chrono::milliseconds(CloseTimeoutMs);
+    draining.push_back(client);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        live.erase(client);
+        pending.erase(client);
+    }
+
+    // Stop reading; frames that arrive after the close aren't handed out
+#if defined(EVENT_LOOP_EPOLL)
+    epoll_event event{};
+    event.events = EPOLLOUT;
+    event.data.u64 = static_cast<Uint64>(client);
+    epoll_ctl(poller, EPOLL_CTL_MOD, conn.fd, &event);
+#elif defined(EVENT_LOOP_KQUEUE)
+    struct kevent change;
+    EV_SET(&change, conn.fd, EVFILT_READ, EV_DELETE, 0, 0, nullptr);
+    kevent(poller, &change, 1, nullptr, 0, nullptr);
+#endif
+}
+
+int EventLoop::_retireDrained(int timeoutMs) {
+    if (draining.empty()) return timeoutMs;
+
+    const Clock::time_point now = Clock::now();
+    std::vector<int> waiting;
+    bool retiredAny = false;
+    for (int client : draining) {
+        auto it = connections.find(client);
+        if (it == connections.end()) continue; // Retired by a hangup
+        const Connection& conn = *it->second;
+        if (conn.out.empty() || now >= conn.closeBy) {
+            _retire(client);
+            retiredAny = true;
+            continue;
+        }
+        // Wake up in time for the deadline
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(conn.closeBy - now).count() + 1;
+        if (timeoutMs < 0 || left < timeoutMs) timeoutMs = static_cast<int>(left);
+        waiting.push_back(client);
+    }
+    draining.swap(waiting);
+    return retiredAny ? 0 : timeoutMs;
+}
+
+void EventLoop::_accept() {
+    while (true) {
+        const int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return; // Drained, or out of descriptors until a client leaves
+        }
+        if (!setNonBlocking(fd)) {
+            ::close(fd);
+            continue;
+        }
+        const int on = 1;
+        // Writes are already coalesced, so don't hold the last one back
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        const int client = nextClient++;
+        connections.emplace(client, std::make_unique<Connection>(fd, capacity));
+        _register(fd, client);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            live.insert(client);
+        }
+        ready.opened.push_back(client);
+    }
+}
+
+void EventLoop::_read(int client, Connection& conn) {
+    const long received = conn.reader.readAvailable();
+    scratch.clear();
+    const bool fits = conn.reader.drain(scratch);
+    for (const Frame& frame : scratch) {
+        ready.frames.push_back(ClientFrame{ client, frame });
+    }
+    // A frame that can never fit leaves the stream unreadable past it
+    if (received < 0 || !fits) _retire(client);
+}
+
+void EventLoop::_write(int client, Connection& conn) {
+    while (conn.written < conn.out.size()) {
+        const auto sent = ::send(conn.fd, conn.out.data() + conn.written, conn.out.size() - conn.written, MSG_NOSIGNAL);
+        if (sent > 0) {
+            conn.written += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            _watchWrites(conn, client, true);
+            return;
+        }
+        // Broken: let the next read see it, so the close is reported with the rest
+        conn.out.clear();
+        conn.written = 0;
+        shutdown(conn.fd, SHUT_RDWR);
+        return;
+    }
+    conn.out.clear();
+    conn.written = 0;
+    _watchWrites(conn, client, false);
+}
+
+void EventLoop::flush() {
+    std::unordered_map<int, std::vector<Uint8>> outgoing;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        outgoing.swap(pending);
+    }
+    for (auto& entry : outgoing) {
+        auto it = connections.find(entry.first);
+        if (it == connections.end()) continue;
+        Connection& conn = *it->second;
+        if (conn.out.empty()) {
+            conn.out.swap(entry.second);
+        } else {
+            conn.out.insert(conn.out.end(), entry.second.begin(), entry.second.end());
+        }
+        if (conn.out.size() - conn.written > MaxBacklog) {
+            conn.out.clear();
+            conn.written = 0;
+            shutdown(conn.fd, SHUT_RDWR);
+            continue;
+        }
+        // Otherwise the writable event flushes it
+        if (!conn.writing) _write(entry.first, conn);
+    }
+}
+
+void EventLoop::_retire(int client) {
+    auto it = connections.find(client);
+#ifdef EVENT_LOOP_EPOLL
+    epoll_ctl(poller, EPOLL_CTL_DEL, it->second->fd, nullptr);
+#endif
+    // kqueue drops a descriptor's events when it's closed
+    ::close(it->second->fd);
+    retired.push_back(std::move(it->second));
+    connections.erase(it);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        live.erase(client);
+        pending.erase(client);
+    }
+    ready.closed.push_back(client);
+}
+
+bool EventLoop::send(int client, const Uint8* data, size_t size) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!live.count(client)) return false;
+        auto& queued = pending[client];
+        queued.insert(queued.end(), data, data + size);
+    }
+    // The loop thread flushes after its callback anyway
+    if (loopThread.load() != std::this_thread::get_id()) wake();
+    return true;
+}
+
+void EventLoop::close(int client) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!live.count(client)) return;
+        closing.push_back(client);
+    }
+    if (loopThread.load() != std::this_thread::get_id()) wake();
+}
+
+void EventLoop::wake() {
+    if (wakeWrite < 0 || woken.exchange(true)) return;
+    const Uint8 byte = 1;
+    // A full pipe is already a pending wake up
+    (void)!write(wakeWrite, &byte, 1);
+}
+
+size_t EventLoop::clientCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return live.size();
+}
+
+#endif
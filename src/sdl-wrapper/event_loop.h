@@ -0,0 +1,121 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include "frame_reader.h"
+#include <SDL.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// A frame from one of an EventLoop's clients
+struct ClientFrame {
+    int client;
+    Frame frame;
+};
+
+// Everything one EventLoop::poll saw, in the order to handle it: clients that connected, the frames that
+// arrived and clients that went away. Frames are valid until the next poll, even for closed clients.
+struct LoopEvents {
+    std::vector<int> opened;
+    std::vector<ClientFrame> frames;
+    std::vector<int> closed;
+
+    bool empty() const { return opened.empty() && frames.empty() && closed.empty(); }
+};
+
+// A listening socket and every client it accepts, serviced from one thread with epoll on Linux, kqueue on
+// macOS and the BSDs and poll elsewhere. Each client reads into its own FrameReader and queues its writes,
+// so whatever is sent to it between flushes goes out in one write. Clients are numbered from 1 and numbers
+// are never reused.
+//
+// poll and flush belong to the loop thread. send, close and wake can be called from any thread; the loop
+// thread carries them out, and is woken up to do so if it's waiting.
+class EventLoop {
+public:
+    // capacity bounds each client's largest frame, header included
+    explicit EventLoop(size_t capacity = 64 << 10);
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Listens on every interface; port 0 picks a free one. Returns false with errno set on failure
+    bool listen(int port);
+
+    // Flushes and closes what was asked for, waits up to timeoutMs (-1 forever) and then accepts, reads and
+    // writes whatever is ready. Returns false on a poller error (left in errno)
+    bool poll(int timeoutMs);
+    const LoopEvents& events() const { return ready; }
+    // Writes everything sent since the last flush, one write per client
+    void flush();
+
+    // Queues data, one or more framed packets, for client. Returns false once it has closed
+    bool send(int client, const Uint8* data, size_t size);
+    // Closes client at the next poll, reporting it as closed once its queued writes have gone out (or
+    // CloseTimeoutMs has passed). Nothing more is read from it or can be sent to it in between.
+    void close(int client);
+    // Ends a poll that's waiting, from another thread
+    void wake();
+
+    int port() const { return boundPort; }
+    size_t clientCount() const;
+
+private:
+    static constexpr long ListenToken = -1, WakeToken = -2;
+    // A client that's this far behind on reading is disconnected rather than queued for
+    static constexpr size_t MaxBacklog = 8 << 20;
+    // How long a closed client's queued writes get to go out
+    static constexpr int CloseTimeoutMs = 5000;
+    using Clock = std::chrono::steady_clock;
+
+    struct Connection {
+        Connection(int fd, size_t capacity) : fd(fd), reader(fd, capacity) {}
+        int fd;
+        FrameReader reader;
+        std::vector<Uint8> out;
+        size_t written = 0; // Bytes of out already sent
+        bool writing = false; // Waiting for the socket to be writable
+        bool draining = false; // Closed, but with writes still queued
+        Clock::time_point closeBy;
+    };
+    struct Readiness {
+        long token;
+        bool readable, writable;
+    };
+
+    size_t capacity;
+    int listener = -1, poller = -1, wakeRead = -1, wakeWrite = -1;
+    int boundPort = 0;
+    int nextClient = 1;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::vector<std::unique_ptr<Connection>> retired; // Closed this poll, kept while their frames are out
+    std::vector<int> draining; // Clients waiting for their writes to finish before closing
+    LoopEvents ready;
+    std::vector<Readiness> readiness;
+    std::vector<Frame> scratch;
+
+    // Shared with other threads
+    mutable std::mutex lock;
+    std::unordered_set<int> live;
+    std::unordered_map<int, std::vector<Uint8>> pending;
+    std::vector<int> closing;
+    std::atomic<bool> woken{ false };
+    std::atomic<std::thread::id> loopThread{};
+
+    bool _wait(int timeoutMs);
+    void _register(int fd, long token);
+    void _watchWrites(Connection& conn, long token, bool on);
+    void _accept();
+    void _read(int client, Connection& conn);
+    void _write(int client, Connection& conn);
+    void _close(int client, Connection& conn);
+    int _retireDrained(int timeoutMs);
+    void _retire(int client);
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "frame_encoder.h"
+#include <SDL_image.h>
+
+FrameEncoder::FrameEncoder(size_t maxQueued)
+    : maxQueued(maxQueued > 0 ? maxQueued : 1), worker(&FrameEncoder::_work, this) {}
+
+FrameEncoder::~FrameEncoder() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void FrameEncoder::savePng(SDL_Surface* surface, const std::string& path) {
+    if (surface == nullptr) return;
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        drained.wait(guard, [this] { return jobs.size() < maxQueued; });
+        jobs.push_back({ surface, path });
+    }
+    wake.notify_one();
+}
+
+void FrameEncoder::wait() {
+    std::unique_lock<std::mutex> guard(lock);
+    drained.wait(guard, [this] { return jobs.empty() && !encoding; });
+}
+
+void FrameEncoder::_work() {
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [this] { return stopping || !jobs.empty(); });
+        // Stopping still drains the queue, so a replay's last frames aren't lost
+        if (jobs.empty()) return;
+        Job job = jobs.front();
+        jobs.pop_front();
+        encoding = true;
+
+        guard.unlock();
+        const bool written = IMG_SavePNG(job.surface, job.path.c_str()) == 0;
+        if (!written) {
+            SDL_Log("Unable to write frame to %s! SDL_image Error: %s\n", job.path.c_str(), IMG_GetError());
+        }
+        SDL_FreeSurface(job.surface);
+        guard.lock();
+
+        encoding = false;
+        if (!written) failed++;
+        drained.notify_all();
+    }
+}
+
+size_t FrameEncoder::pending() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return jobs.size() + (encoding ? 1 : 0);
+}
+
+size_t FrameEncoder::failures() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return failed;
+}
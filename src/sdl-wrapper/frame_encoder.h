@@ -0,0 +1,51 @@
+#ifndef FRAME_ENCODER_H
+#define FRAME_ENCODER_H
+
+#include <SDL.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Writes captured frames to PNG files on one background thread, so the render thread only pays for
+// reading the pixels back. Frames are written in the order they were queued. At most maxQueued wait
+// at once; past that savePng blocks until the encoder catches up rather than buffering without bound.
+class FrameEncoder {
+public:
+    explicit FrameEncoder(size_t maxQueued = 8);
+    // Finishes writing whatever is queued, then joins the worker
+    ~FrameEncoder();
+
+    FrameEncoder(const FrameEncoder&) = delete;
+    FrameEncoder& operator=(const FrameEncoder&) = delete;
+
+    // Takes ownership of surface, which must not be used by anything else afterwards
+    void savePng(SDL_Surface* surface, const std::string& path);
+    // Blocks until everything queued so far is written
+    void wait();
+    // Frames queued or being written
+    size_t pending() const;
+    // Frames that couldn't be written since the encoder started
+    size_t failures() const;
+
+private:
+    struct Job {
+        SDL_Surface* surface;
+        std::string path;
+    };
+
+    const size_t maxQueued;
+    mutable std::mutex lock;
+    std::condition_variable wake;   // Worker: a job arrived or it's stopping
+    std::condition_variable drained; // Producers: a job finished
+    std::deque<Job> jobs;
+    bool encoding = false;
+    bool stopping = false;
+    size_t failed = 0;
+    std::thread worker;
+
+    void _work();
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include "frame_profiler.h"
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+constexpr size_t counterCount = static_cast<size_t>(ProfileCounter::Count);
+
+const char* counterNames[counterCount] = {
+    "clear", "fill_rect", "draw_rect", "line", "point", "circle", "polygon", "geometry", "mesh",
+    "texture", "text", "label", "batch_flush", "present", "sleep", "asset_upload", "batch_command",
+    "sprite_instance", "sprite_draw_call", "color_change", "texture_upload", "text_raster"
+};
+
+void appendf(std::string& out, const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    const int written = std::vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (written > 0) out.append(buffer, std::min(static_cast<size_t>(written), sizeof(buffer) - 1));
+}
+}
+
+const char* FrameProfiler::counterName(ProfileCounter counter) {
+    const size_t index = static_cast<size_t>(counter);
+    return index < counterCount ? counterNames[index] : "unknown";
+}
+
+FrameProfiler::FrameProfiler(size_t frameCapacity, size_t spanCapacity)
+    : records(std::max<size_t>(frameCapacity, 1)), spans(std::max<size_t>(spanCapacity, 1)) {}
+
+void FrameProfiler::setEnabled(bool enabled, bool tracing) {
+    if (enabled && !this->enabled) {
+        clear();
+    }
+    this->enabled = enabled;
+    this->tracing = enabled && tracing;
+}
+
+void FrameProfiler::clear() {
+    frequency = SDL_GetPerformanceFrequency();
+    if (frequency == 0) frequency = 1;
+    origin = SDL_GetPerformanceCounter();
+    frameNumber = 0;
+    written = 0;
+    spansWritten = 0;
+    depth = 0;
+    _resetFrame(origin);
+}
+
+void FrameProfiler::_resetFrame(Uint64 now) {
+    frameStart = now;
+    sdlTicks = presentTicks = sleepTicks = 0;
+    for (Uint32& count : counts) count = 0;
+}
+
+ProfileScope::~ProfileScope() {
+    if (!profiler) return;
+    const Uint64 end = SDL_GetPerformanceCounter();
+    const Uint64 elapsed = end - start;
+    FrameProfiler& p = *profiler;
+    p.counts[static_cast<size_t>(counter)]++;
+    if (--p.depth == 0) p.sdlTicks += elapsed;
+    if (counter == ProfileCounter::Present) p.presentTicks += elapsed;
+    if (counter == ProfileCounter::Sleep) p.sleepTicks += elapsed;
+    if (p.tracing) {
+        p.spans[p.spansWritten % p.spans.size()] = { start, end, counter };
+        p.spansWritten++;
+    }
+}
+
+void FrameProfiler::endFrame() {
+    if (!enabled) return;
+    const Uint64 now = SDL_GetPerformanceCounter();
+    auto count = [this](ProfileCounter counter) { return counts[static_cast<size_t>(counter)]; };
+
+    FrameRecord& record = records[written % records.size()];
+    record.frame = frameNumber++;
+    record.start = _seconds(frameStart - origin);
+    record.duration = _seconds(now - frameStart);
+    // Sleeping happens in a scope too, but it isn't time spent in SDL
+    record.sdlSeconds = _seconds(sdlTicks - std::min(sleepTicks, sdlTicks));
+    record.presentSeconds = _seconds(presentTicks);
+    record.sleepSeconds = _seconds(sleepTicks);
+    record.otherSeconds = std::max(0.0, record.duration - _seconds(sdlTicks));
+    record.clears = count(ProfileCounter::Clear);
+    record.fillRects = count(ProfileCounter::FillRect);
+    record.drawRects = count(ProfileCounter::DrawRect);
+    record.lines = count(ProfileCounter::Line);
+    record.points = count(ProfileCounter::Point);
+    record.circles = count(ProfileCounter::Circle);
+    record.polygons = count(ProfileCounter::Polygon);
+    record.geometry = count(ProfileCounter::Geometry);
+    record.meshes = count(ProfileCounter::Mesh);
+    record.textures = count(ProfileCounter::Texture);
+    record.texts = count(ProfileCounter::Text);
+    record.labels = count(ProfileCounter::Label);
+    record.batchFlushes = count(ProfileCounter::BatchFlush);
+    record.batchCommands = count(ProfileCounter::BatchCommand);
+    record.spriteInstances = count(ProfileCounter::SpriteInstance);
+    record.spriteDrawCalls = count(ProfileCounter::SpriteDrawCall);
+    record.colorChanges = count(ProfileCounter::ColorChange);
+    record.textureUploads = count(ProfileCounter::TextureUpload);
+    record.textRasters = count(ProfileCounter::TextRaster);
+    record.assetUploads = count(ProfileCounter::AssetUpload);
+    written++;
+
+    _resetFrame(now);
+}
+
+std::vector<FrameRecord> FrameProfiler::frames() const {
+    std::vector<FrameRecord> out;
+    const size_t n = frameCount();
+    out.reserve(n);
+    for (size_t i = written - n; i < written; i++) {
+        out.push_back(records[i % records.size()]);
+    }
+    return out;
+}
+
+std::string FrameProfiler::chromeTrace() const {
+    // Timestamps are microseconds since profiling was enabled
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"SDLWrapper\"}}";
+    out += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"frames\"}}";
+    out += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"render\"}}";
+
+    for (const FrameRecord& record : frames()) {
+        const double ts = record.start * 1e6;
+        appendf(out, ",\n{\"name\":\"frame %llu\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+            "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"sdl_ms\":%.3f,\"present_ms\":%.3f,\"sleep_ms\":%.3f,"
+            "\"other_ms\":%.3f}}",
+            static_cast<unsigned long long>(record.frame), ts, record.duration * 1e6,
+            record.sdlSeconds * 1e3, record.presentSeconds * 1e3, record.sleepSeconds * 1e3,
+            record.otherSeconds * 1e3);
+        const Uint32 draws = record.fillRects + record.drawRects + record.lines + record.points
+            + record.circles + record.polygons + record.geometry + record.meshes + record.textures
+            + record.texts + record.labels + record.batchCommands + record.spriteDrawCalls;
+        appendf(out, ",\n{\"name\":\"draws\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"calls\":%u,"
+            "\"batch_commands\":%u,\"sprites\":%u}}",
+            ts, draws, record.batchCommands, record.spriteInstances);
+        appendf(out, ",\n{\"name\":\"state\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"color_changes\":%u,"
+            "\"texture_uploads\":%u,\"text_rasters\":%u}}",
+            ts, record.colorChanges, record.textureUploads, record.textRasters);
+    }
+
+    const size_t n = std::min(spansWritten, spans.size());
+    for (size_t i = spansWritten - n; i < spansWritten; i++) {
+        const Span& span = spans[i % spans.size()];
+        if (span.start < origin) continue;
+        appendf(out, ",\n{\"name\":\"%s\",\"cat\":\"sdl\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f}",
+            counterName(span.counter), _seconds(span.start - origin) * 1e6, _seconds(span.end - span.start) * 1e6);
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+bool FrameProfiler::writeChromeTrace(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        SDL_Log("Unable to open %s to write the frame trace!\n", path.c_str());
+        return false;
+    }
+    file << chromeTrace();
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,126 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <SDL.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// What a profiled wrapper call counts as. The timed ones also name spans in a Chrome trace.
+enum class ProfileCounter : Uint8 {
+    Clear,
+    FillRect,
+    DrawRect,
+    Line,
+    Point,
+    Circle,
+    Polygon,
+    Geometry,
+    Mesh,
+    Texture,     // Texture and framebuffer copies
+    Text,
+    Label,
+    BatchFlush,
+    Present,
+    Sleep,        // paceFrame
+    AssetUpload,
+    // Counted without a span
+    BatchCommand,
+    SpriteInstance,
+    SpriteDrawCall,
+    ColorChange,
+    TextureUpload,
+    TextRaster,   // Text rendered by SDL_ttf rather than drawn from an atlas or cached label
+    Count
+};
+
+// One frame, from the end of the previous updateScreen to the end of this one
+struct FrameRecord {
+    Uint64 frame;
+    double start;          // Seconds since profiling was enabled
+    double duration;
+    double sdlSeconds;     // Inside profiled wrapper calls, present included
+    double presentSeconds;
+    double sleepSeconds;   // In paceFrame
+    double otherSeconds;   // The rest: Python and anything the wrapper doesn't see
+    Uint32 clears, fillRects, drawRects, lines, points, circles, polygons, geometry, meshes, textures;
+    Uint32 texts, labels, batchFlushes, batchCommands, spriteInstances, spriteDrawCalls;
+    Uint32 colorChanges, textureUploads, textRasters, assetUploads;
+};
+
+// Per-frame counters and timings for SDLWrapper, kept in a fixed ring of the last frames. Profiled
+// calls are wrapped in a ProfileScope; only the outermost scope's time counts towards sdlSeconds, so
+// a flush that draws sprites isn't timed twice. With tracing on every scope is also kept as a span
+// (in a second fixed ring) for chromeTrace. Disabled, a scope costs one branch. Render thread only.
+class FrameProfiler {
+public:
+    explicit FrameProfiler(size_t frameCapacity = 600, size_t spanCapacity = 1 << 16);
+
+    void setEnabled(bool enabled, bool tracing = false);
+    bool isEnabled() const { return enabled; }
+    bool isTracing() const { return tracing; }
+    void clear();
+
+    void count(ProfileCounter counter, Uint32 n = 1) {
+        if (enabled) counts[static_cast<size_t>(counter)] += n;
+    }
+    // Closes the current frame; updateScreen calls it once the present returns
+    void endFrame();
+
+    // Oldest first
+    std::vector<FrameRecord> frames() const;
+    size_t frameCount() const { return std::min(written, records.size()); }
+    // The frames and spans still in the rings in the Trace Event Format, for chrome://tracing or Perfetto
+    std::string chromeTrace() const;
+    bool writeChromeTrace(const std::string& path) const;
+
+    static const char* counterName(ProfileCounter counter);
+
+private:
+    friend class ProfileScope;
+    struct Span {
+        Uint64 start, end; // Performance counter ticks
+        ProfileCounter counter;
+    };
+
+    bool enabled = false;
+    bool tracing = false;
+    Uint64 frequency = 1;
+    Uint64 origin = 0;     // Tick profiling was enabled at
+    Uint64 frameStart = 0;
+    Uint64 frameNumber = 0;
+    Uint32 counts[static_cast<size_t>(ProfileCounter::Count)] = {};
+    Uint64 sdlTicks = 0, presentTicks = 0, sleepTicks = 0;
+    int depth = 0;
+
+    std::vector<FrameRecord> records;
+    size_t written = 0;
+    std::vector<Span> spans;
+    size_t spansWritten = 0;
+
+    double _seconds(Uint64 ticks) const { return static_cast<double>(ticks) / static_cast<double>(frequency); }
+    void _resetFrame(Uint64 now);
+};
+
+// Counts and times one profiled call for as long as it's in scope
+class ProfileScope {
+public:
+    ProfileScope(FrameProfiler& profiler, ProfileCounter counter)
+        : profiler(profiler.enabled ? &profiler : nullptr), counter(counter) {
+        if (this->profiler) {
+            this->profiler->depth++;
+            start = SDL_GetPerformanceCounter();
+        }
+    }
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    FrameProfiler* profiler;
+    ProfileCounter counter;
+    Uint64 start = 0;
+};
+
+#endif
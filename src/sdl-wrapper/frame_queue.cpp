@@ -0,0 +1,237 @@
+#include "frame_queue.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+FrameQueue::FrameQueue(bool priority, size_t capacity) : priority(priority) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    mask = size - 1;
+    if (!priority) {
+        cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+            cells[i].frame = nullptr;
+        }
+    }
+}
+
+FrameQueue::~FrameQueue() {
+    clear();
+}
+
+double FrameQueue::now() {
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool FrameQueue::_ringPush(PyObject* frame) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &cells[pos & mask];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false; // Full: the cell a lap behind hasn't been consumed
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    cell->frame = frame;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool FrameQueue::_ringPop(PyObject*& frame) {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &cells[pos & mask];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false; // Empty
+        } else {
+            pos = dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+    frame = cell->frame;
+    cell->frame = nullptr;
+    cell->sequence.store(pos + mask + 1, std::memory_order_release);
+    return true;
+}
+
+bool FrameQueue::_returnedPop(PyObject*& frame) {
+    if (returnedCount.load() == 0) return false;
+    std::lock_guard<std::mutex> guard(returnedLock);
+    if (returned.empty()) return false;
+    frame = returned.front();
+    returned.pop_front();
+    returnedCount--;
+    return true;
+}
+
+bool FrameQueue::_later(const Entry& a, const Entry& b) {
+    if (a.availableAt != b.availableAt) return a.availableAt > b.availableAt;
+    if (a.priority != b.priority) return a.priority > b.priority;
+    if (a.id != b.id) return a.id > b.id;
+    return a.order > b.order;
+}
+
+bool FrameQueue::_heapPop(PyObject*& frame, double dueBy) {
+    std::lock_guard<std::mutex> guard(heapLock);
+    if (heap.empty() || heap.front().availableAt > dueBy) return false;
+    std::pop_heap(heap.begin(), heap.end(), _later);
+    frame = heap.back().frame;
+    heap.pop_back();
+    return true;
+}
+
+bool FrameQueue::push(PyObject* frame, double availableAt, long priority, Uint64 id) {
+    if (closed.load()) return false;
+    Py_INCREF(frame);
+    if (this->priority) {
+        std::lock_guard<std::mutex> guard(heapLock);
+        heap.push_back(Entry{ availableAt, priority, id, pushed++, frame });
+        std::push_heap(heap.begin(), heap.end(), _later);
+    } else if (!_ringPush(frame)) {
+        Py_DECREF(frame);
+        return false;
+    }
+    _notify();
+    return true;
+}
+
+bool FrameQueue::pushFront(PyObject* frame, double availableAt, long priority, Uint64 id) {
+    if (this->priority) return push(frame, availableAt, priority, id);
+    if (closed.load()) return false;
+    Py_INCREF(frame);
+    {
+        std::lock_guard<std::mutex> guard(returnedLock);
+        returned.push_front(frame);
+        returnedCount++;
+    }
+    _notify();
+    return true;
+}
+
+PyObject* FrameQueue::pop() {
+    PyObject* frame = nullptr;
+    if (priority ? _heapPop(frame, now()) : (_returnedPop(frame) || _ringPop(frame))) return frame;
+    return nullptr;
+}
+
+size_t FrameQueue::popBatch(std::vector<PyObject*>& out, size_t maxFrames) {
+    // One clock read for the batch: anything that comes due during it waits for the next
+    const double dueBy = priority ? now() : 0;
+    size_t taken = 0;
+    PyObject* frame;
+    while ((maxFrames == 0 || taken < maxFrames)
+           && (priority ? _heapPop(frame, dueBy) : (_returnedPop(frame) || _ringPop(frame)))) {
+        out.push_back(frame);
+        taken++;
+    }
+    return taken;
+}
+
+void FrameQueue::takeAll(std::vector<PyObject*>& out) {
+    PyObject* frame;
+    if (!priority) {
+        while (_returnedPop(frame) || _ringPop(frame)) {
+            out.push_back(frame);
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> guard(heapLock);
+    std::sort_heap(heap.begin(), heap.end(), _later);
+    // sort_heap leaves it ascending under _later, so latest first
+    for (auto it = heap.rbegin(); it != heap.rend(); ++it) {
+        out.push_back(it->frame);
+    }
+    heap.clear();
+}
+
+void FrameQueue::clear() {
+    std::vector<PyObject*> frames;
+    takeAll(frames);
+    for (PyObject* frame : frames) {
+        Py_DECREF(frame);
+    }
+}
+
+size_t FrameQueue::size() const {
+    if (priority) {
+        std::lock_guard<std::mutex> guard(heapLock);
+        return heap.size();
+    }
+    // Pushes and pops racing this can leave dequeue briefly ahead of a stale enqueue
+    const size_t head = dequeuePos.load(), tail = enqueuePos.load();
+    return (tail > head ? tail - head : 0) + returnedCount.load();
+}
+
+double FrameQueue::nextAvailable() const {
+    if (!priority) return size() > 0 ? 0 : std::numeric_limits<double>::infinity();
+    std::lock_guard<std::mutex> guard(heapLock);
+    return heap.empty() ? std::numeric_limits<double>::infinity() : heap.front().availableAt;
+}
+
+bool FrameQueue::_due(double at) const {
+    return priority ? nextAvailable() <= at : size() > 0;
+}
+
+void FrameQueue::_notify() {
+    // A waiter registers before checking, so either it sees this frame or it's already waiting here
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load() == 0) return;
+    std::lock_guard<std::mutex> guard(waitLock);
+    ready.notify_all();
+}
+
+bool FrameQueue::wait(double timeoutSeconds) {
+    using Clock = std::chrono::steady_clock;
+    const bool forever = timeoutSeconds < 0 || std::isinf(timeoutSeconds);
+    const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                             std::chrono::duration<double>(forever ? 0 : timeoutSeconds));
+    const Uint64 woken = wakeups.load();
+
+    waiters++;
+    std::unique_lock<std::mutex> guard(waitLock);
+    bool due;
+    while (!(due = _due(now())) && !closed.load() && wakeups.load() == woken) {
+        // A frame that's queued but not due yet sets its own, earlier deadline. Its availability is
+        // wall clock time while the wait runs on the steady clock, so this is rechecked on waking
+        auto until = forever ? Clock::time_point::max() : deadline;
+        const double next = nextAvailable();
+        if (!std::isinf(next)) {
+            const auto untilNext = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                                      std::chrono::duration<double>(std::max(0.0, next - now())));
+            until = std::min(until, untilNext);
+        }
+        if (until == Clock::time_point::max()) {
+            ready.wait(guard);
+        } else if (ready.wait_until(guard, until) == std::cv_status::timeout && until == deadline) {
+            due = _due(now());
+            break;
+        }
+    }
+    waiters--;
+    return due;
+}
+
+void FrameQueue::wake() {
+    wakeups++;
+    std::lock_guard<std::mutex> guard(waitLock);
+    ready.notify_all();
+}
+
+void FrameQueue::close() {
+    closed.store(true);
+    wake();
+}
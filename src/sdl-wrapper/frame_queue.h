@@ -0,0 +1,104 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <Python.h>
+#include <SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// One FramePipeline consumer's queue of Frame objects, in one of two lanes. The plain lane is a
+// bounded lock-free multi-producer multi-consumer ring that delivers in send order. The priority lane
+// is a binary heap ordered like Frame itself, by (available_at, priority, id), and only hands out
+// frames whose available_at has passed, so delayed and prioritised delivery cost a log n push and
+// pop instead of a sorted list insert.
+//
+// The queue owns a reference to every frame in it, so sends, receives and clear need the GIL. Only
+// wait may (and should) be called without it.
+class FrameQueue {
+public:
+    // capacity bounds the plain lane, rounded up to a power of two; the priority lane grows
+    FrameQueue(bool priority, size_t capacity = 1024);
+    ~FrameQueue();
+
+    FrameQueue(const FrameQueue&) = delete;
+    FrameQueue& operator=(const FrameQueue&) = delete;
+
+    // Takes a new reference to frame. Returns false if the plain lane is full or the queue is closed
+    bool push(PyObject* frame, double availableAt = 0, long priority = 0, Uint64 id = 0);
+    // Puts back a frame just taken off the queue, ahead of everything in the plain lane and past the
+    // capacity if need be; the priority lane orders it by its key like any push. False if closed.
+    bool pushFront(PyObject* frame, double availableAt = 0, long priority = 0, Uint64 id = 0);
+    // The next frame that's due, as a new reference, or nullptr
+    PyObject* pop();
+    // Appends up to maxFrames (0 for all) due frames to out, as new references, returning how many
+    size_t popBatch(std::vector<PyObject*>& out, size_t maxFrames = 0);
+    // Everything queued, due or not, in delivery order
+    void takeAll(std::vector<PyObject*>& out);
+    void clear();
+
+    // Blocks for up to timeoutSeconds (negative for no limit) until a frame is due, the queue closes
+    // or wake is called; returns whether a frame is due
+    bool wait(double timeoutSeconds);
+    void wake();
+    // Refuses further pushes and wakes every waiter for good
+    void close();
+
+    size_t size() const;
+    bool isPriority() const { return priority; }
+    bool isClosed() const { return closed.load(); }
+    // available_at of the head of the priority lane, infinity if there's none
+    double nextAvailable() const;
+
+    // Seconds since the epoch, the same clock as Python's time.time()
+    static double now();
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        PyObject* frame;
+    };
+    struct Entry {
+        double availableAt;
+        long priority;
+        Uint64 id;
+        Uint64 order; // Keeps equal keys first in, first out
+        PyObject* frame;
+    };
+
+    bool priority;
+    // Plain lane; each position is only reused once the cell's sequence says it's been consumed
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos{ 0 };
+    alignas(64) std::atomic<size_t> dequeuePos{ 0 };
+    // Frames put back with pushFront, handed out before the ring
+    std::mutex returnedLock;
+    std::deque<PyObject*> returned;
+    std::atomic<size_t> returnedCount{ 0 };
+
+    // Priority lane
+    mutable std::mutex heapLock;
+    std::vector<Entry> heap;
+    Uint64 pushed = 0;
+
+    std::mutex waitLock;
+    std::condition_variable ready;
+    std::atomic<int> waiters{ 0 };
+    std::atomic<Uint64> wakeups{ 0 };
+    std::atomic<bool> closed{ false };
+
+    // Min-heap on the Frame ordering
+    static bool _later(const Entry& a, const Entry& b);
+    bool _ringPush(PyObject* frame);
+    bool _ringPop(PyObject*& frame);
+    bool _returnedPop(PyObject*& frame);
+    bool _heapPop(PyObject*& frame, double dueBy);
+    bool _due(double at) const;
+    void _notify();
+};
+
+#endif
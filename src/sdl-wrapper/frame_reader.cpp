@@ -0,0 +1,101 @@
+#include "frame_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#define poll WSAPoll
+#define SOCKET_ERRNO WSAGetLastError()
+#define SOCKET_WOULD_BLOCK(err) ((err) == WSAEWOULDBLOCK)
+#define SOCKET_INTERRUPTED(err) ((err) == WSAEINTR)
+#else
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#define SOCKET_ERRNO errno
+#define SOCKET_WOULD_BLOCK(err) ((err) == EAGAIN || (err) == EWOULDBLOCK)
+#define SOCKET_INTERRUPTED(err) ((err) == EINTR)
+#endif
+
+#ifndef MSG_DONTWAIT
+#define MSG_DONTWAIT 0 // poll has already said the socket is readable, so one recv won't block
+#endif
+
+FrameReader::FrameReader(int fd, size_t capacity)
+    : socket(fd), buf(std::max(capacity, HeaderSize)) {}
+
+void FrameReader::_compact() {
+    // Frames handed out before this fill may be overwritten from here on
+    if (head == 0) return;
+    if (head != tail) std::memmove(buf.data(), buf.data() + head, tail - head);
+    tail -= head;
+    head = 0;
+}
+
+long FrameReader::fill(int timeoutMs) {
+    _compact();
+    if (tail == buf.size()) return 0;
+
+    pollfd entry{};
+    entry.fd = socket;
+    entry.events = POLLIN;
+    int ready;
+    do {
+        ready = poll(&entry, 1, timeoutMs);
+    } while (ready < 0 && SOCKET_INTERRUPTED(SOCKET_ERRNO));
+    if (ready < 0) return -2;
+    if (ready == 0) return 0;
+    return readAvailable();
+}
+
+long FrameReader::readAvailable() {
+    _compact();
+    if (tail == buf.size()) return 0;
+
+    long total = 0;
+    while (tail < buf.size()) {
+        const auto received = recv(socket, reinterpret_cast<char*>(buf.data() + tail), static_cast<int>(buf.size() - tail), MSG_DONTWAIT);
+        if (received > 0) {
+            tail += static_cast<size_t>(received);
+            total += static_cast<long>(received);
+            // Without MSG_DONTWAIT only the first recv is known not to block
+            if (MSG_DONTWAIT == 0) break;
+            continue;
+        }
+        if (received == 0) {
+            // Closed: hand over what did arrive first, the next fill reports it
+            return total > 0 ? total : -1;
+        }
+        const int err = SOCKET_ERRNO;
+        if (SOCKET_INTERRUPTED(err)) continue;
+        if (SOCKET_WOULD_BLOCK(err)) break;
+        return total > 0 ? total : -2;
+    }
+    return total;
+}
+
+bool FrameReader::drain(std::vector<Frame>& out, size_t maxFrames) {
+    size_t taken = 0;
+    while (buffered() >= HeaderSize && (maxFrames == 0 || taken < maxFrames)) {
+        const Uint8* header = buf.data() + head;
+        Uint32 fields[2];
+        for (int i = 0; i < 2; i++) {
+            const Uint8* p = header + i * 4;
+            fields[i] = static_cast<Uint32>(p[0]) | static_cast<Uint32>(p[1]) << 8 | static_cast<Uint32>(p[2]) << 16 |
+                        static_cast<Uint32>(p[3]) << 24;
+        }
+        const size_t length = fields[1];
+        if (length > buf.size() - HeaderSize) {
+            // Report it once the frames before it are out
+            tooLarge = length;
+            return taken != 0;
+        }
+        if (buffered() < HeaderSize + length) break;
+
+        out.push_back(Frame{ fields[0], header + HeaderSize, length });
+        head += HeaderSize + length;
+        taken++;
+    }
+    return true;
+}
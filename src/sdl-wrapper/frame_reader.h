@@ -0,0 +1,52 @@
+#ifndef FRAME_READER_H
+#define FRAME_READER_H
+
+#include <SDL.h>
+#include <vector>
+
+// One framed packet in a FrameReader's buffer: Packet's "<II" header (type, payload length, little
+// endian) has already been parsed off
+struct Frame {
+    Uint32 type;
+    const Uint8* data;
+    size_t size;
+};
+
+// Reads Packet frames from a socket into one fixed buffer, allocated up front and never moved, so
+// frames can be handed out in place. Bytes are appended at the tail and consumed from the head; once
+// the tail reaches the end, the unread remainder (at most one partial frame) is moved back to the
+// front, so every frame is contiguous. Frames are valid until the next fill or readAvailable.
+class FrameReader {
+public:
+    static constexpr size_t HeaderSize = 8;
+
+    // capacity bounds the largest frame, header included
+    explicit FrameReader(int fd, size_t capacity = 1 << 20);
+
+    // Waits up to timeoutMs (-1 forever, 0 not at all) for the socket to be readable, then reads
+    // whatever has arrived without blocking. Returns the bytes read, 0 on timeout, -1 once the peer has
+    // closed and -2 on a socket error (left in errno).
+    long fill(int timeoutMs);
+    // fill for a socket that's already known to be readable (or non-blocking), e.g. from an
+    // EventLoop: reads without waiting, returning the same as fill
+    long readAvailable();
+    // Appends every complete buffered frame to out, up to maxFrames (0 for all). Returns false once the
+    // next frame can never fit; any frames ahead of it are handed out by the call before.
+    bool drain(std::vector<Frame>& out, size_t maxFrames = 0);
+
+    int fd() const { return socket; }
+    size_t capacity() const { return buf.size(); }
+    size_t buffered() const { return tail - head; }
+    // Length of the frame that overflowed, for the error message
+    size_t oversized() const { return tooLarge; }
+
+private:
+    int socket;
+    std::vector<Uint8> buf;
+    size_t head = 0, tail = 0;
+    size_t tooLarge = 0;
+
+    void _compact();
+};
+
+#endif
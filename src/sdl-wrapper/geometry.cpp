@@ -0,0 +1,77 @@
+#include "geometry.h"
+#include <algorithm>
+#include <numeric>
+
+namespace {
+    inline float cross(const SDL_FPoint& a, const SDL_FPoint& b, const SDL_FPoint& c) {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    // Inclusive of the edges so points on the ear's boundary also block it
+    inline bool insideTriangle(const SDL_FPoint& p, const SDL_FPoint& a, const SDL_FPoint& b, const SDL_FPoint& c) {
+        return cross(a, b, p) >= 0.0f && cross(b, c, p) >= 0.0f && cross(c, a, p) >= 0.0f;
+    }
+}
+
+bool triangulatePolygon(const SDL_FPoint* points, size_t count, std::vector<int>& out) {
+    if (count < 3) return false;
+
+    // Work on a positively wound ring of indices
+    float area = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        const SDL_FPoint& a = points[i];
+        const SDL_FPoint& b = points[(i + 1) % count];
+        area += a.x * b.y - b.x * a.y;
+    }
+    if (area == 0.0f) return false;
+
+    std::vector<int> ring(count);
+    std::iota(ring.begin(), ring.end(), 0);
+    if (area < 0.0f) {
+        std::reverse(ring.begin(), ring.end());
+    }
+
+    // Each pass either clips an ear or drops a collinear vertex; a full lap without progress means bad input
+    size_t misses = 0;
+    size_t i = 0;
+    while (ring.size() > 3) {
+        const size_t n = ring.size();
+        const int prev = ring[(i + n - 1) % n], cur = ring[i % n], next = ring[(i + 1) % n];
+        const SDL_FPoint& a = points[prev];
+        const SDL_FPoint& b = points[cur];
+        const SDL_FPoint& c = points[next];
+        const float turn = cross(a, b, c);
+
+        bool clip = false;
+        if (turn == 0.0f) {
+            ring.erase(ring.begin() + (i % n)); // Collinear: contributes no area
+            misses = 0;
+            continue;
+        } else if (turn > 0.0f) {
+            clip = true;
+            // Only reflex vertices can sit inside a convex ear
+            for (size_t k = 0; k < n && clip; k++) {
+                const int v = ring[k];
+                if (v == prev || v == cur || v == next) continue;
+                const int vp = ring[(k + n - 1) % n], vn = ring[(k + 1) % n];
+                if (cross(points[vp], points[v], points[vn]) <= 0.0f && insideTriangle(points[v], a, b, c)) {
+                    clip = false;
+                }
+            }
+        }
+
+        if (clip) {
+            out.insert(out.end(), { prev, cur, next });
+            ring.erase(ring.begin() + (i % n));
+            misses = 0;
+        } else {
+            i++;
+            if (++misses > ring.size()) {
+                return false;
+            }
+        }
+    }
+
+    out.insert(out.end(), { ring[0], ring[1], ring[2] });
+    return true;
+}
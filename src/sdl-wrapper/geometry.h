@@ -0,0 +1,12 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <SDL.h>
+#include <vector>
+
+// Ear-clipping triangulation of a simple polygon (convex or concave, either winding).
+// Appends three indices into points per triangle to out and returns false if the outline
+// is degenerate or self-intersecting, in which case out holds whatever could be clipped.
+bool triangulatePolygon(const SDL_FPoint* points, size_t count, std::vector<int>& out);
+
+#endif
@@ -0,0 +1,188 @@
+#include "glyph_atlas.h"
+#include <algorithm>
+
+namespace {
+    constexpr int AtlasMaxWidth = 512;
+    constexpr int GlyphPadding = 1; // Keeps linear filtering from bleeding neighbours in
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    release();
+}
+
+void GlyphAtlas::release() {
+    if (texture) {
+        SDL_DestroyTexture(texture);
+        texture = nullptr;
+    }
+    if (sheet) {
+        SDL_FreeSurface(sheet);
+        sheet = nullptr;
+    }
+    owner = nullptr;
+    prepared = nullptr;
+    kerning.clear();
+}
+
+bool GlyphAtlas::build(SDL_Renderer* renderer, TTF_Font* font) {
+    if (!renderer) {
+        release();
+        return false;
+    }
+    return prepare(font) && upload(renderer);
+}
+
+bool GlyphAtlas::prepare(TTF_Font* font) {
+    release();
+    if (!font) return false;
+
+    const SDL_Color white = { 255, 255, 255, 255 };
+    SDL_Surface* surfaces[GlyphCount] = {};
+
+    // Rasterise every glyph and shelf-pack them left to right
+    int penX = 0, penY = 0, shelfHeight = 0, usedWidth = 0;
+    for (int i = 0; i < GlyphCount; i++) {
+        const Uint16 ch = static_cast<Uint16>(FirstGlyph + i);
+        int minx, maxx, miny, maxy, advance;
+        if (TTF_GlyphMetrics(font, ch, &minx, &maxx, &miny, &maxy, &advance) != 0) {
+            advance = 0;
+        }
+        glyphs[i] = { { 0, 0, 0, 0 }, advance };
+
+        surfaces[i] = TTF_RenderGlyph_Blended(font, ch, white);
+        if (!surfaces[i]) continue;
+
+        const int w = surfaces[i]->w, h = surfaces[i]->h;
+        if (penX + w > AtlasMaxWidth) {
+            penX = 0;
+            penY += shelfHeight + GlyphPadding;
+            shelfHeight = 0;
+        }
+        glyphs[i].src = { penX, penY, w, h };
+        penX += w + GlyphPadding;
+        shelfHeight = std::max(shelfHeight, h);
+        usedWidth = std::max(usedWidth, penX);
+    }
+    atlasWidth = std::max(usedWidth, 1);
+    atlasHeight = std::max(penY + shelfHeight, 1);
+    lineHeight = TTF_FontHeight(font);
+
+    sheet = SDL_CreateRGBSurfaceWithFormat(0, atlasWidth, atlasHeight, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!sheet) {
+        SDL_Log("Unable to create glyph atlas surface! SDL Error: %s\n", SDL_GetError());
+        for (SDL_Surface* s : surfaces) if (s) SDL_FreeSurface(s);
+        return false;
+    }
+    SDL_FillRect(sheet, nullptr, 0);
+
+    for (int i = 0; i < GlyphCount; i++) {
+        if (!surfaces[i]) continue;
+        SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE); // Copy alpha as-is
+        SDL_Rect dst = glyphs[i].src;
+        SDL_BlitSurface(surfaces[i], nullptr, sheet, &dst);
+        SDL_FreeSurface(surfaces[i]);
+    }
+
+    if (TTF_GetFontKerning(font)) {
+        kerning.assign(GlyphCount * GlyphCount, 0);
+        for (int a = 0; a < GlyphCount; a++) {
+            for (int b = 0; b < GlyphCount; b++) {
+                const int k = TTF_GetFontKerningSizeGlyphs(font, static_cast<Uint16>(FirstGlyph + a), static_cast<Uint16>(FirstGlyph + b));
+                kerning[a * GlyphCount + b] = static_cast<Sint8>(std::clamp(k, -128, 127));
+            }
+        }
+    }
+
+    prepared = font;
+    return true;
+}
+
+bool GlyphAtlas::upload(SDL_Renderer* renderer) {
+    if (!renderer || !sheet) return false;
+    texture = SDL_CreateTextureFromSurface(renderer, sheet);
+    SDL_FreeSurface(sheet);
+    sheet = nullptr;
+    if (!texture) {
+        SDL_Log("Unable to create glyph atlas texture! SDL Error: %s\n", SDL_GetError());
+        prepared = nullptr;
+        return false;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    owner = prepared;
+    return true;
+}
+
+bool GlyphAtlas::isBuiltFor(const TTF_Font* font) const {
+    return texture != nullptr && owner == font;
+}
+
+bool GlyphAtlas::covers(const std::string& text) const {
+    return std::all_of(text.begin(), text.end(), [](char c) {
+        const unsigned char u = static_cast<unsigned char>(c);
+        return u >= FirstGlyph && u <= LastGlyph;
+    });
+}
+
+int GlyphAtlas::_kern(unsigned char previous, unsigned char current) const {
+    if (kerning.empty() || previous == 0) return 0;
+    return kerning[(previous - FirstGlyph) * GlyphCount + (current - FirstGlyph)];
+}
+
+void GlyphAtlas::draw(SDL_Renderer* renderer, const std::string& text, int x, int y, SDL_Color color) {
+    if (!texture || text.empty()) return;
+
+    vertices.clear();
+    indices.clear();
+    vertices.reserve(text.size() * 4);
+    indices.reserve(text.size() * 6);
+
+    const float invW = 1.0f / static_cast<float>(atlasWidth);
+    const float invH = 1.0f / static_cast<float>(atlasHeight);
+
+    int penX = x;
+    unsigned char previous = 0;
+    for (char c : text) {
+        const unsigned char u = static_cast<unsigned char>(c);
+        penX += _kern(previous, u);
+        previous = u;
+
+        const Glyph& glyph = glyphs[u - FirstGlyph];
+        if (glyph.src.w > 0 && glyph.src.h > 0) {
+            const float x0 = static_cast<float>(penX), y0 = static_cast<float>(y);
+            const float x1 = x0 + glyph.src.w, y1 = y0 + glyph.src.h;
+            const float u0 = glyph.src.x * invW, v0 = glyph.src.y * invH;
+            const float u1 = (glyph.src.x + glyph.src.w) * invW, v1 = (glyph.src.y + glyph.src.h) * invH;
+
+            const int base = static_cast<int>(vertices.size());
+            vertices.push_back({ { x0, y0 }, color, { u0, v0 } });
+            vertices.push_back({ { x1, y0 }, color, { u1, v0 } });
+            vertices.push_back({ { x1, y1 }, color, { u1, v1 } });
+            vertices.push_back({ { x0, y1 }, color, { u0, v1 } });
+            indices.insert(indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+        }
+        penX += glyph.advance;
+    }
+
+    if (indices.empty()) return;
+    SDL_RenderGeometry(renderer, texture,
+                       vertices.data(), static_cast<int>(vertices.size()),
+                       indices.data(), static_cast<int>(indices.size()));
+}
+
+SDL_Rect GlyphAtlas::measure(const std::string& text) const {
+    SDL_Rect rect = { 0, 0, 0, lineHeight };
+
+    int penX = 0;
+    unsigned char previous = 0;
+    for (char c : text) {
+        const unsigned char u = static_cast<unsigned char>(c);
+        penX += _kern(previous, u);
+        previous = u;
+
+        const Glyph& glyph = glyphs[u - FirstGlyph];
+        rect.w = std::max(rect.w, penX + glyph.src.w); // The last glyph may overhang its advance
+        penX += glyph.advance;
+    }
+    rect.w = std::max(rect.w, penX);
+    return rect;
+}
@@ -0,0 +1,61 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <string>
+#include <vector>
+
+// Printable ASCII glyphs of one font rasterised once into a single texture.
+// Text is drawn as tinted quads from it, and sizes come from the cached metrics.
+class GlyphAtlas {
+public:
+    static constexpr int FirstGlyph = 32;
+    static constexpr int LastGlyph = 126;
+    static constexpr int GlyphCount = LastGlyph - FirstGlyph + 1;
+
+    GlyphAtlas() = default;
+    ~GlyphAtlas();
+
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+    bool build(SDL_Renderer* renderer, TTF_Font* font);
+    void release();
+
+    // build in two halves. prepare rasterises and packs the glyphs into a surface without touching
+    // the renderer, so it may run on a loader thread; upload then turns it into the texture.
+    bool prepare(TTF_Font* font);
+    bool upload(SDL_Renderer* renderer);
+
+    bool isBuiltFor(const TTF_Font* font) const;
+    bool isPreparedFor(const TTF_Font* font) const { return sheet != nullptr && prepared == font; }
+    // True if every character of text is in the atlas
+    bool covers(const std::string& text) const;
+
+    void draw(SDL_Renderer* renderer, const std::string& text, int x, int y, SDL_Color color);
+    SDL_Rect measure(const std::string& text) const;
+
+private:
+    struct Glyph {
+        SDL_Rect src; // Location in the atlas texture
+        int advance;
+    };
+
+    SDL_Texture* texture = nullptr;
+    SDL_Surface* sheet = nullptr; // Between prepare and upload
+    const TTF_Font* owner = nullptr;
+    const TTF_Font* prepared = nullptr;
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+    int lineHeight = 0;
+    Glyph glyphs[GlyphCount] = {};
+    std::vector<Sint8> kerning; // GlyphCount x GlyphCount, empty if the font has no kerning
+
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+
+    int _kern(unsigned char previous, unsigned char current) const;
+};
+
+#endif
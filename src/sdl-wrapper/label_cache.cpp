@@ -0,0 +1,82 @@
+#include "label_cache.h"
+#include <functional>
+
+size_t LabelKeyHash::operator()(const LabelKey& key) const {
+    size_t h = std::hash<std::string>()(key.text);
+    // boost::hash_combine style mixing of the small fields
+    const Uint64 fields[] = { key.fontId, static_cast<Uint64>(static_cast<Uint32>(key.size)), key.color };
+    for (Uint64 f : fields) {
+        h ^= std::hash<Uint64>()(f) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+LabelCache::~LabelCache() {
+    clear();
+}
+
+SDL_Texture* LabelCache::find(const LabelKey& key, int& w, int& h) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        misses++;
+        return nullptr;
+    }
+    hits++;
+    entries.splice(entries.begin(), entries, it->second);
+    w = it->second->w;
+    h = it->second->h;
+    return it->second->texture;
+}
+
+void LabelCache::insert(const LabelKey& key, SDL_Texture* texture, int w, int h) {
+    auto existing = index.find(key);
+    if (existing != index.end()) {
+        bytes -= existing->second->bytes;
+        SDL_DestroyTexture(existing->second->texture);
+        entries.erase(existing->second);
+        index.erase(existing);
+    }
+
+    const size_t size = static_cast<size_t>(w) * static_cast<size_t>(h) * 4;
+    entries.push_front({ key, texture, w, h, size });
+    index[key] = entries.begin();
+    bytes += size;
+    _evictToBudget();
+}
+
+void LabelCache::_evictToBudget() {
+    // The entry just inserted is kept even if it alone exceeds the budget
+    while (bytes > budget && entries.size() > 1) {
+        Entry& victim = entries.back();
+        bytes -= victim.bytes;
+        SDL_DestroyTexture(victim.texture);
+        index.erase(victim.key);
+        entries.pop_back();
+        evictions++;
+    }
+}
+
+void LabelCache::setBudget(size_t newBudget) {
+    budget = newBudget;
+    _evictToBudget();
+}
+
+void LabelCache::clear() {
+    for (Entry& entry : entries) {
+        SDL_DestroyTexture(entry.texture);
+    }
+    entries.clear();
+    index.clear();
+    bytes = 0;
+}
+
+LabelCacheStats LabelCache::stats() const {
+    LabelCacheStats s;
+    s.hits = hits;
+    s.misses = misses;
+    s.evictions = evictions;
+    s.bytes = bytes;
+    s.entries = entries.size();
+    s.budget = budget;
+    return s;
+}
@@ -0,0 +1,70 @@
+#ifndef LABEL_CACHE_H
+#define LABEL_CACHE_H
+
+#include <SDL.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+struct LabelKey {
+    Uint32 fontId;
+    int size;
+    Uint32 color; // Packed 0xRRGGBBAA
+    std::string text;
+
+    bool operator==(const LabelKey& other) const {
+        return fontId == other.fontId && size == other.size && color == other.color && text == other.text;
+    }
+};
+
+struct LabelKeyHash {
+    size_t operator()(const LabelKey& key) const;
+};
+
+struct LabelCacheStats {
+    Uint64 hits = 0;
+    Uint64 misses = 0;
+    Uint64 evictions = 0;
+    size_t bytes = 0;
+    size_t entries = 0;
+    size_t budget = 0;
+};
+
+// Pre-rendered text textures, evicted least recently used first once the byte budget is exceeded.
+// The cache owns its textures and destroys them on eviction.
+class LabelCache {
+public:
+    static constexpr size_t DefaultBudget = 8 * 1024 * 1024;
+
+    LabelCache() = default;
+    ~LabelCache();
+
+    LabelCache(const LabelCache&) = delete;
+    LabelCache& operator=(const LabelCache&) = delete;
+
+    // Returns nullptr on a miss. Counts towards the hit/miss stats.
+    SDL_Texture* find(const LabelKey& key, int& w, int& h);
+    void insert(const LabelKey& key, SDL_Texture* texture, int w, int h);
+
+    void setBudget(size_t bytes);
+    void clear();
+    LabelCacheStats stats() const;
+
+private:
+    struct Entry {
+        LabelKey key;
+        SDL_Texture* texture;
+        int w, h;
+        size_t bytes;
+    };
+
+    std::list<Entry> entries; // Most recently used at the front
+    std::unordered_map<LabelKey, std::list<Entry>::iterator, LabelKeyHash> index;
+    size_t budget = DefaultBudget;
+    size_t bytes = 0;
+    Uint64 hits = 0, misses = 0, evictions = 0;
+
+    void _evictToBudget();
+};
+
+#endif
@@ -0,0 +1,342 @@
+#include "match_record.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    constexpr Uint8 Magic[4] = { 'Y', '1', '1', 'R' };
+    constexpr Uint8 Version = 1;
+
+    enum class RecordKind : Uint8 {
+        Card = 1,       // name; ids count up from 0 in the order they appear
+        Deploy = 2,     // tick, card id, spec
+        Checkpoint = 3, // tick, BattleSim::checksum
+        End = 4         // tick, winner, tower hitpoints
+    };
+
+    bool readInt(ByteReader& in, int& out) {
+        Sint64 value;
+        if (!in.readZigzag(value)) return false;
+        out = static_cast<int>(value);
+        return true;
+    }
+
+    bool readUint(ByteReader& in, Uint32& out) {
+        Uint64 value;
+        if (!in.readVarint(value)) return false;
+        out = static_cast<Uint32>(value);
+        return true;
+    }
+}
+
+BattleUnitSpec ReplayDeploy::spec() const {
+    BattleUnitSpec s;
+    s.x = x;
+    s.y = y;
+    s.owner = owner;
+    s.hitpoints = hitpoints;
+    s.damage = damage;
+    s.range = range;
+    s.attackSeconds = attackSeconds;
+    s.moveSeconds = moveSeconds;
+    s.layer = layer;
+    s.targets = targets;
+    s.mobile = mobile != 0;
+    return s;
+}
+
+MatchRecorder::MatchRecorder(Uint64 checkpointTicks) : checkpointTicks(std::max<Uint64>(checkpointTicks, 1)) {}
+
+bool MatchRecorder::open(const std::string& path, const BattleSim& sim) {
+    file.close();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        SDL_Log("Unable to open %s to record the match!\n", path.c_str());
+        return false;
+    }
+    cardIds.clear();
+    lastCheckpoint = sim.tick();
+    written = 0;
+
+    const TileGrid& grid = sim.grid();
+    out.clear();
+    out.writeBytes(Magic, sizeof(Magic));
+    out.writeByte(Version);
+    out.writeVarint(static_cast<Uint64>(grid.width()));
+    out.writeVarint(static_cast<Uint64>(grid.height()));
+    out.writeVarint(static_cast<Uint64>(sim.tickRate()));
+    out.writeBytes(grid.data(), static_cast<size_t>(grid.width()) * grid.height());
+    out.writeVarint(sim.towerCount());
+    for (size_t t = 0; t < sim.towerCount(); t++) {
+        const BattleTower tower = sim.tower(static_cast<int>(t));
+        out.writeZigzag(tower.x);
+        out.writeZigzag(tower.y);
+        out.writeByte(static_cast<Uint8>(tower.owner));
+        out.writeByte(static_cast<Uint8>(tower.kind));
+        out.writeZigzag(tower.hitpoints);
+    }
+    _flush();
+    return static_cast<bool>(file);
+}
+
+void MatchRecorder::_flush() {
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    file.flush();
+    written += out.size();
+    out.clear();
+}
+
+void MatchRecorder::deploy(Uint64 tick, const std::string& card, const BattleUnitSpec& spec) {
+    if (!isOpen()) return;
+
+    auto found = cardIds.find(card);
+    if (found == cardIds.end()) {
+        found = cardIds.emplace(card, static_cast<Uint32>(cardIds.size())).first;
+        out.writeByte(static_cast<Uint8>(RecordKind::Card));
+        out.writeString(card.data(), card.size());
+    }
+
+    out.writeByte(static_cast<Uint8>(RecordKind::Deploy));
+    out.writeVarint(tick);
+    out.writeVarint(found->second);
+    out.writeZigzag(spec.x);
+    out.writeZigzag(spec.y);
+    out.writeByte(static_cast<Uint8>(spec.owner));
+    out.writeZigzag(spec.hitpoints);
+    out.writeZigzag(spec.damage);
+    out.writeFloat(spec.range);
+    out.writeFloat(spec.attackSeconds);
+    out.writeFloat(spec.moveSeconds);
+    out.writeVarint(spec.layer);
+    out.writeVarint(spec.targets);
+    out.writeByte(spec.mobile ? 1 : 0);
+    _flush();
+}
+
+void MatchRecorder::checkpoint(const BattleSim& sim) {
+    if (!isOpen() || sim.tick() < lastCheckpoint + checkpointTicks) return;
+    lastCheckpoint = sim.tick();
+    out.writeByte(static_cast<Uint8>(RecordKind::Checkpoint));
+    out.writeVarint(sim.tick());
+    out.writeFixed32(sim.checksum());
+    _flush();
+}
+
+void MatchRecorder::finish(const BattleSim& sim) {
+    if (!isOpen()) return;
+    out.writeByte(static_cast<Uint8>(RecordKind::End));
+    out.writeVarint(sim.tick());
+    out.writeZigzag(sim.winner());
+    out.writeVarint(sim.towerCount());
+    for (size_t t = 0; t < sim.towerCount(); t++) {
+        out.writeZigzag(sim.towerHitpoints(static_cast<int>(t)));
+    }
+    _flush();
+    file.close();
+}
+
+void MatchReplay::_unload() {
+    current.reset();
+    snapshots.clear();
+    nextDeploy = 0;
+    arenaW = arenaH = 0;
+    tiles.clear();
+    towers.clear();
+    cardNames.clear();
+    deployList.clear();
+    checkpoints.clear();
+    ended = false;
+    endAt = 0;
+    endWinner = -1;
+    endTowers.clear();
+}
+
+bool MatchReplay::load(const std::string& path) {
+    // Whatever was loaded goes even if this load fails
+    _unload();
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        SDL_Log("Unable to open replay %s!\n", path.c_str());
+        return false;
+    }
+    const std::vector<Uint8> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ByteReader in(bytes.data(), bytes.size());
+
+    const Uint8* magic;
+    Uint8 version;
+    Uint32 w, h, tickRate, towerCount;
+    const Uint8* grid;
+    if (!in.readBytes(sizeof(Magic), magic) || !std::equal(Magic, Magic + sizeof(Magic), magic)
+        || !in.readByte(version) || version != Version
+        || !readUint(in, w) || !readUint(in, h) || !readUint(in, tickRate)
+        || w == 0 || h == 0 || !in.readBytes(static_cast<size_t>(w) * h, grid)
+        || !readUint(in, towerCount)) {
+        SDL_Log("%s is not a replay, or is from another version!\n", path.c_str());
+        return false;
+    }
+
+    std::vector<BattleTower> loadedTowers;
+    for (Uint32 t = 0; t < towerCount; t++) {
+        BattleTower tower;
+        Uint8 side, kind;
+        if (!readInt(in, tower.x) || !readInt(in, tower.y) || !in.readByte(side) || !in.readByte(kind)
+            || !readInt(in, tower.hitpoints)) {
+            SDL_Log("Replay %s has a truncated header!\n", path.c_str());
+            return false;
+        }
+        tower.owner = side;
+        tower.kind = static_cast<TowerKind>(kind);
+        loadedTowers.push_back(tower);
+    }
+
+    arenaW = static_cast<int>(w);
+    arenaH = static_cast<int>(h);
+    rate = static_cast<int>(tickRate);
+    tiles.assign(grid, grid + static_cast<size_t>(w) * h);
+    towers = std::move(loadedTowers);
+
+    // Records are read whole or not at all, so a partly written last one just ends the replay
+    Uint8 kind;
+    while (!ended && in.readByte(kind)) {
+        if (kind == static_cast<Uint8>(RecordKind::Card)) {
+            const char* name;
+            size_t size;
+            if (!in.readString(name, size)) break;
+            cardNames.emplace_back(name, size);
+        } else if (kind == static_cast<Uint8>(RecordKind::Deploy)) {
+            ReplayDeploy d;
+            Uint32 card;
+            Uint8 side, mobile;
+            if (!in.readVarint(d.tick) || !readUint(in, card) || !readInt(in, d.x) || !readInt(in, d.y)
+                || !in.readByte(side) || !readInt(in, d.hitpoints) || !readInt(in, d.damage)
+                || !in.readFloat(d.range) || !in.readFloat(d.attackSeconds) || !in.readFloat(d.moveSeconds)
+                || !readUint(in, d.layer) || !readUint(in, d.targets) || !in.readByte(mobile)) {
+                break;
+            }
+            d.card = card < cardNames.size() ? static_cast<Sint32>(card) : -1;
+            d.owner = side;
+            d.mobile = mobile;
+            deployList.push_back(d);
+        } else if (kind == static_cast<Uint8>(RecordKind::Checkpoint)) {
+            Checkpoint c;
+            if (!in.readVarint(c.tick) || !in.readFixed32(c.checksum)) break;
+            checkpoints.push_back(c);
+        } else if (kind == static_cast<Uint8>(RecordKind::End)) {
+            Uint64 tick;
+            int winner;
+            Uint32 count;
+            if (!in.readVarint(tick) || !readInt(in, winner) || !readUint(in, count)) break;
+            std::vector<int> hitpoints(count);
+            bool complete = true;
+            for (int& hp : hitpoints) {
+                complete = complete && readInt(in, hp);
+            }
+            if (!complete) break;
+            endAt = tick;
+            endWinner = winner;
+            endTowers = std::move(hitpoints);
+            ended = true;
+        } else {
+            SDL_Log("Replay %s has an unknown record %u, ignoring the rest\n", path.c_str(), kind);
+            break;
+        }
+    }
+
+    reset();
+    return true;
+}
+
+void MatchReplay::setDeploys(std::vector<ReplayDeploy> deploys) {
+    std::stable_sort(deploys.begin(), deploys.end(), [](const ReplayDeploy& a, const ReplayDeploy& b) {
+        return a.tick < b.tick;
+    });
+    deployList = std::move(deploys);
+    // The checkpoints were taken with the recorded deploys
+    reset();
+}
+
+Uint64 MatchReplay::endTick() const {
+    if (ended) return endAt;
+    return deployList.empty() ? 0 : deployList.back().tick;
+}
+
+void MatchReplay::setSnapshotInterval(Uint64 ticks) {
+    snapshotTicks = ticks;
+    snapshots.clear();
+}
+
+void MatchReplay::reset() {
+    if (arenaW == 0) return;
+    current = std::make_unique<BattleSim>(arenaW, arenaH, rate);
+    current->setTiles(tiles.data(), tiles.size());
+    for (const BattleTower& tower : towers) {
+        current->addTower(tower.x, tower.y, tower.owner, tower.kind, tower.hitpoints);
+    }
+    nextDeploy = 0;
+    snapshots.clear();
+}
+
+void MatchReplay::_step() {
+    // Recorded deploys happened before the step that left their tick
+    while (nextDeploy < deployList.size() && deployList[nextDeploy].tick <= current->tick()) {
+        current->spawn(deployList[nextDeploy].spec());
+        nextDeploy++;
+    }
+    current->step();
+
+    const Uint64 now = current->tick();
+    if (snapshotTicks != 0 && now % snapshotTicks == 0 && (snapshots.empty() || snapshots.back().sim.tick() < now)) {
+        snapshots.push_back({ *current, nextDeploy });
+    }
+}
+
+bool MatchReplay::seek(Uint64 tick) {
+    if (!current) return false;
+
+    // The latest snapshot at or before tick, if it's closer than where the replay already is
+    auto after = std::upper_bound(snapshots.begin(), snapshots.end(), tick, [](Uint64 t, const Snapshot& s) {
+        return t < s.sim.tick();
+    });
+    if (after != snapshots.begin()) {
+        const Snapshot& closest = *std::prev(after);
+        if (tick < current->tick() || closest.sim.tick() > current->tick()) {
+            *current = closest.sim;
+            nextDeploy = closest.nextDeploy;
+        }
+    } else if (tick < current->tick()) {
+        std::vector<Snapshot> kept = std::move(snapshots);
+        reset();
+        snapshots = std::move(kept);
+    }
+
+    while (current->tick() < tick) {
+        _step();
+    }
+    return true;
+}
+
+Uint64 MatchReplay::advance(Uint64 ticks) {
+    if (!current) return 0;
+    Uint64 stepped = 0;
+    while (stepped < ticks && current->winner() == -1) {
+        _step();
+        stepped++;
+    }
+    return stepped;
+}
+
+int MatchReplay::run(Uint64 maxTicks) {
+    advance(maxTicks);
+    return current ? current->winner() : -1;
+}
+
+Sint64 MatchReplay::firstDivergence() {
+    if (!seek(0)) return -2;
+    for (const Checkpoint& checkpoint : checkpoints) {
+        seek(checkpoint.tick);
+        if (current->checksum() != checkpoint.checksum) {
+            return static_cast<Sint64>(checkpoint.tick);
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,135 @@
+#ifndef MATCH_RECORD_H
+#define MATCH_RECORD_H
+
+#include "battle.h"
+#include "codec.h"
+#include <SDL.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One recorded deploy, laid out for a NumPy structured array. It's spawned before the step that
+// takes the simulation past tick.
+struct ReplayDeploy {
+    Uint64 tick;
+    Sint32 card; // Index into MatchReplay::cards
+    Sint32 x, y;
+    Sint32 owner;
+    Sint32 hitpoints;
+    Sint32 damage;
+    float range;
+    float attackSeconds;
+    float moveSeconds;
+    Uint32 layer;
+    Uint32 targets;
+    Uint8 mobile;
+
+    BattleUnitSpec spec() const;
+};
+
+// Appends a match to a replay file while it's played. The file starts with the arena (tiles, towers
+// and tick rate), followed by one record per card name first seen, deploy, checkpoint and the end of
+// the match, varint-packed with ByteWriter. Every record is flushed as it's written, so a server that
+// dies mid-match leaves a replay that's readable up to its last deploy.
+class MatchRecorder {
+public:
+    // Checkpoints are written at most this often; see checkpoint
+    explicit MatchRecorder(Uint64 checkpointTicks = 100);
+
+    // Writes the header from sim, which must already have its tiles and towers
+    bool open(const std::string& path, const BattleSim& sim);
+    bool isOpen() const { return file.is_open(); }
+    void deploy(Uint64 tick, const std::string& card, const BattleUnitSpec& spec);
+    // Records sim's checksum if checkpointTicks have passed since the last one, to find desyncs on replay
+    void checkpoint(const BattleSim& sim);
+    // Records the final tick, winner and tower hitpoints, then closes the file. Safe to call twice.
+    void finish(const BattleSim& sim);
+
+    size_t bytesWritten() const { return written; }
+
+private:
+    std::ofstream file;
+    ByteWriter out;
+    std::unordered_map<std::string, Uint32> cardIds;
+    Uint64 checkpointTicks;
+    Uint64 lastCheckpoint = 0;
+    size_t written = 0;
+
+    void _flush();
+};
+
+// Re-simulates a recorded match on its own BattleSim, as fast as it can step. Every snapshotTicks a
+// copy of the simulation is kept, so seeking backwards restores the closest earlier copy and steps on
+// from there. The deploys can be edited (setDeploys) to play a match out under balance changes.
+// Until a load succeeds there's no simulation: stepping fails and sim() must not be called.
+class MatchReplay {
+public:
+    // Returns false, with an SDL_Log, if the file is missing or isn't a replay, and leaves nothing
+    // loaded. A truncated last record is dropped rather than failing the load.
+    bool load(const std::string& path);
+    bool isLoaded() const { return current != nullptr; }
+
+    int width() const { return arenaW; }
+    int height() const { return arenaH; }
+    int tickRate() const { return rate; }
+    const std::vector<std::string>& cards() const { return cardNames; }
+    const std::vector<ReplayDeploy>& deploys() const { return deployList; }
+    // Replaces the deploys (sorted by tick, keeping their order within one) and rewinds to tick 0
+    void setDeploys(std::vector<ReplayDeploy> deploys);
+
+    // The recorded last tick, or the last deploy's if the recording was cut short
+    Uint64 endTick() const;
+    // The recorded winner, -1 if the match was undecided or the recording was cut short
+    int recordedWinner() const { return endWinner; }
+    const std::vector<int>& recordedTowerHitpoints() const { return endTowers; }
+
+    void setSnapshotInterval(Uint64 ticks);
+    // Back to tick 0, dropping every snapshot. Does nothing if no replay is loaded.
+    void reset();
+    // False if no replay is loaded
+    bool seek(Uint64 tick);
+    // Steps up to ticks times; returns how many it stepped, fewer once a side has won or if nothing is loaded
+    Uint64 advance(Uint64 ticks);
+    // Steps until a side wins or maxTicks have passed and returns the winner, or -1
+    int run(Uint64 maxTicks);
+    // Replays from the start through every checkpoint; returns the first tick whose checksum doesn't
+    // match the recording, -1 if they all do, or -2 if no replay is loaded
+    Sint64 firstDivergence();
+
+    // Only while isLoaded
+    const BattleSim& sim() const { return *current; }
+    Uint64 tick() const { return current ? current->tick() : 0; }
+
+private:
+    struct Snapshot {
+        BattleSim sim;
+        size_t nextDeploy;
+    };
+    struct Checkpoint {
+        Uint64 tick;
+        Uint32 checksum;
+    };
+
+    int arenaW = 0, arenaH = 0, rate = 20;
+    std::vector<Uint8> tiles;
+    std::vector<BattleTower> towers;
+    std::vector<std::string> cardNames;
+    std::vector<ReplayDeploy> deployList;
+    std::vector<Checkpoint> checkpoints;
+    Uint64 endAt = 0;
+    bool ended = false;
+    int endWinner = -1;
+    std::vector<int> endTowers;
+
+    std::unique_ptr<BattleSim> current;
+    size_t nextDeploy = 0;
+    Uint64 snapshotTicks = 200;
+    std::vector<Snapshot> snapshots; // Ascending by tick
+
+    void _step();
+    void _unload();
+};
+
+#endif
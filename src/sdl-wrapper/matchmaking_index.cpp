@@ -0,0 +1,106 @@
+#include "matchmaking_index.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+MatchmakingIndex::MatchmakingIndex(int baseDifference, double widenPerSecond, int maxDifference)
+    : baseDifference(std::max(baseDifference, 0)), widenPerSecond(std::max(widenPerSecond, 0.0)),
+      maxDifference(std::max(maxDifference, this->baseDifference)) {}
+
+int MatchmakingIndex::band(double waited) const {
+    const double widened = baseDifference + std::floor(widenPerSecond * std::max(waited, 0.0));
+    return static_cast<int>(std::min(widened, static_cast<double>(maxDifference)));
+}
+
+int MatchmakingIndex::add(int trophies, double now) {
+    std::lock_guard<std::mutex> guard(lock);
+    const int id = nextId++;
+    const Uint64 order = nextOrder++;
+    entries[id] = { trophies, now, order };
+    byTrophies.insert({ trophies, order, id });
+    byAge[order] = id;
+    return id;
+}
+
+void MatchmakingIndex::_erase(int id) {
+    auto found = entries.find(id);
+    if (found == entries.end()) return;
+    byTrophies.erase({ found->second.trophies, found->second.order, id });
+    byAge.erase(found->second.order);
+    entries.erase(found);
+}
+
+bool MatchmakingIndex::remove(int id) {
+    std::lock_guard<std::mutex> guard(lock);
+    const bool found = entries.count(id) != 0;
+    _erase(id);
+    return found;
+}
+
+bool MatchmakingIndex::contains(int id) {
+    std::lock_guard<std::mutex> guard(lock);
+    return entries.count(id) != 0;
+}
+
+size_t MatchmakingIndex::size() {
+    std::lock_guard<std::mutex> guard(lock);
+    return entries.size();
+}
+
+int MatchmakingIndex::_nearest(const Entry& entry, int limit) const {
+    // The oldest player at the first trophy count at or above entry's, skipping entry itself
+    const auto firstAtOrAbove = byTrophies.lower_bound({ entry.trophies, 0, 0 });
+    auto above = firstAtOrAbove;
+    if (above != byTrophies.end() && std::get<1>(*above) == entry.order) {
+        ++above;
+    }
+
+    // The oldest player at the first trophy count below, which is the first key with that count
+    auto below = byTrophies.end();
+    if (firstAtOrAbove != byTrophies.begin()) {
+        below = byTrophies.lower_bound({ std::get<0>(*std::prev(firstAtOrAbove)), 0, 0 });
+    }
+
+    const long long aboveGap = above != byTrophies.end()
+        ? static_cast<long long>(std::get<0>(*above)) - entry.trophies : -1;
+    const long long belowGap = below != byTrophies.end()
+        ? static_cast<long long>(entry.trophies) - std::get<0>(*below) : -1;
+
+    auto best = byTrophies.end();
+    if (aboveGap >= 0 && aboveGap <= limit) best = above;
+    if (belowGap >= 0 && belowGap <= limit
+        && (best == byTrophies.end() || belowGap < aboveGap
+            || (belowGap == aboveGap && std::get<1>(*below) < std::get<1>(*above)))) {
+        best = below;
+    }
+    return best != byTrophies.end() ? std::get<2>(*best) : -1;
+}
+
+int MatchmakingIndex::bestOpponent(int id, double now) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto found = entries.find(id);
+    if (found == entries.end()) return -1;
+    return _nearest(found->second, band(now - found->second.since));
+}
+
+std::vector<std::pair<int, int>> MatchmakingIndex::pairAll(double now) {
+    std::lock_guard<std::mutex> guard(lock);
+    std::vector<std::pair<int, int>> pairs;
+
+    auto it = byAge.begin();
+    while (it != byAge.end()) {
+        const int id = it->second;
+        const Entry& entry = entries.at(id);
+        const int opponent = _nearest(entry, band(now - entry.since));
+        if (opponent == -1) {
+            ++it;
+            continue;
+        }
+        pairs.push_back({ id, opponent });
+        // Erasing other entries leaves it valid
+        _erase(opponent);
+        ++it;
+        _erase(id);
+    }
+    return pairs;
+}
@@ -0,0 +1,61 @@
+#ifndef MATCHMAKING_INDEX_H
+#define MATCHMAKING_INDEX_H
+
+#include <SDL.h>
+#include <map>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// The matchmaking queue, kept sorted by trophies so the closest opponent is a lookup either side of a
+// player rather than a scan of everyone waiting. A player accepts opponents within a trophy band that
+// starts at baseDifference and widens by widenPerSecond for every second waited, up to maxDifference.
+// pairAll takes the longest-waiting player first; everyone still unpaired after them has waited less
+// and so has a narrower band, so two players are compatible once the gap is within the older one's
+// band. Times are whatever clock the caller passes in, in seconds. Thread safe.
+class MatchmakingIndex {
+public:
+    MatchmakingIndex(int baseDifference = 100, double widenPerSecond = 10.0, int maxDifference = 1000);
+
+    // Queues a player who started waiting at now and returns their id
+    int add(int trophies, double now);
+    bool remove(int id);
+    bool contains(int id);
+    size_t size();
+
+    // The closest queued player within id's band, the longer-waiting one on a tie; -1 if there's none
+    int bestOpponent(int id, double now);
+    // Pairs everyone it can, oldest first, and removes them from the queue. Each pair is (older, younger).
+    std::vector<std::pair<int, int>> pairAll(double now);
+
+    // The trophy band of a player who has waited this long
+    int band(double waited) const;
+
+private:
+    struct Entry {
+        int trophies;
+        double since;
+        Uint64 order;
+    };
+    // Trophies, then arrival order, then id
+    using Key = std::tuple<int, Uint64, int>;
+
+    int baseDifference;
+    double widenPerSecond;
+    int maxDifference;
+
+    std::mutex lock;
+    int nextId = 0;
+    Uint64 nextOrder = 0;
+    std::unordered_map<int, Entry> entries;
+    std::set<Key> byTrophies;
+    std::map<Uint64, int> byAge; // Arrival order to id, oldest first
+
+    int _nearest(const Entry& entry, int limit) const;
+    void _erase(int id);
+};
+
+#endif
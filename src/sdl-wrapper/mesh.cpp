@@ -0,0 +1,157 @@
+#include "mesh.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Keeps clipped vertices strictly in front of the eye so the divide stays finite
+    constexpr float NearEpsilon = 1e-5f;
+}
+
+void MeshRasterizer::_transform(const float* vertices, size_t count, const float* m) {
+    clip.resize(count);
+
+    // Hoisting the matrix into locals keeps the loop free of aliasing reloads so it vectorises
+    const float m00 = m[0], m01 = m[1], m02 = m[2], m03 = m[3];
+    const float m10 = m[4], m11 = m[5], m12 = m[6], m13 = m[7];
+    const float m20 = m[8], m21 = m[9], m22 = m[10], m23 = m[11];
+    const float m30 = m[12], m31 = m[13], m32 = m[14], m33 = m[15];
+
+    ClipVertex* dst = clip.data();
+    for (size_t i = 0; i < count; i++) {
+        const float x = vertices[3 * i], y = vertices[3 * i + 1], z = vertices[3 * i + 2];
+        dst[i].x = m00 * x + m01 * y + m02 * z + m03;
+        dst[i].y = m10 * x + m11 * y + m12 * z + m13;
+        dst[i].z = m20 * x + m21 * y + m22 * z + m23;
+        dst[i].w = m30 * x + m31 * y + m32 * z + m33;
+    }
+}
+
+void MeshRasterizer::_emitTriangle(SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_Color color) {
+    out.push_back({ a, color, { 0.0f, 0.0f } });
+    out.push_back({ b, color, { 0.0f, 0.0f } });
+    out.push_back({ c, color, { 0.0f, 0.0f } });
+}
+
+void MeshRasterizer::_emitEdge(SDL_FPoint a, SDL_FPoint b, float halfWidth, SDL_Color color) {
+    const float dx = b.x - a.x, dy = b.y - a.y;
+    const float length = std::sqrt(dx * dx + dy * dy);
+    if (length <= 0.0f) return;
+
+    // A thin quad along the edge, split into two triangles
+    const float nx = -dy / length * halfWidth, ny = dx / length * halfWidth;
+    const SDL_FPoint p0 = { a.x + nx, a.y + ny }, p1 = { b.x + nx, b.y + ny };
+    const SDL_FPoint p2 = { b.x - nx, b.y - ny }, p3 = { a.x - nx, a.y - ny };
+    _emitTriangle(p0, p1, p2, color);
+    _emitTriangle(p0, p2, p3, color);
+}
+
+void MeshRasterizer::build(const float* vertices, size_t vertexCount,
+                           const int* indices, size_t triangleCount,
+                           const float* mvp, float viewportWidth, float viewportHeight,
+                           SDL_Color color, MeshMode mode, CullMode cull, float lineWidth) {
+    out.clear();
+    faces.clear();
+    edges.clear();
+    culled = 0;
+    clipped = 0;
+
+    _transform(vertices, vertexCount, mvp);
+
+    const float halfW = viewportWidth * 0.5f, halfH = viewportHeight * 0.5f;
+    auto project = [&](const ClipVertex& v) -> SDL_FPoint {
+        const float invW = 1.0f / v.w;
+        return { (v.x * invW + 1.0f) * halfW, (1.0f - v.y * invW) * halfH };
+    };
+
+    for (size_t t = 0; t < triangleCount; t++) {
+        const int i0 = indices[3 * t], i1 = indices[3 * t + 1], i2 = indices[3 * t + 2];
+        if (i0 < 0 || i1 < 0 || i2 < 0 ||
+            static_cast<size_t>(i0) >= vertexCount || static_cast<size_t>(i1) >= vertexCount || static_cast<size_t>(i2) >= vertexCount) {
+            continue;
+        }
+        const ClipVertex tri[3] = { clip[i0], clip[i1], clip[i2] };
+
+        // Trivially reject triangles wholly outside one frustum plane
+        auto allOutside = [&](auto outside) {
+            return outside(tri[0]) && outside(tri[1]) && outside(tri[2]);
+        };
+        if (allOutside([](const ClipVertex& v) { return v.x < -v.w; }) ||
+            allOutside([](const ClipVertex& v) { return v.x > v.w; }) ||
+            allOutside([](const ClipVertex& v) { return v.y < -v.w; }) ||
+            allOutside([](const ClipVertex& v) { return v.y > v.w; }) ||
+            allOutside([](const ClipVertex& v) { return v.z > v.w; }) ||
+            allOutside([](const ClipVertex& v) { return v.z + v.w < 0.0f || v.w < NearEpsilon; })) {
+            clipped++;
+            continue;
+        }
+
+        // Sutherland-Hodgman against the near plane (z + w >= 0); one plane turns 3 vertices into at most 4
+        ClipVertex poly[4];
+        int n = 0;
+        for (int i = 0; i < 3; i++) {
+            const ClipVertex& a = tri[i];
+            const ClipVertex& b = tri[(i + 1) % 3];
+            const float da = a.z + a.w, db = b.z + b.w;
+            const bool aIn = da >= 0.0f && a.w >= NearEpsilon;
+            const bool bIn = db >= 0.0f && b.w >= NearEpsilon;
+            if (aIn) poly[n++] = a;
+            if (aIn != bIn) {
+                const float s = da / (da - db);
+                ClipVertex v = { a.x + (b.x - a.x) * s, a.y + (b.y - a.y) * s, a.z + (b.z - a.z) * s, a.w + (b.w - a.w) * s };
+                v.w = std::max(v.w, NearEpsilon);
+                poly[n++] = v;
+            }
+        }
+        if (n < 3) {
+            clipped++;
+            continue;
+        }
+
+        SDL_FPoint screen[4];
+        float depth = 0.0f;
+        for (int i = 0; i < n; i++) {
+            screen[i] = project(poly[i]);
+            depth += poly[i].w;
+        }
+        depth /= static_cast<float>(n);
+
+        // Shoelace area in screen space. The y flip turns counter-clockwise NDC into negative area.
+        float area = 0.0f;
+        for (int i = 0; i < n; i++) {
+            const SDL_FPoint& a = screen[i];
+            const SDL_FPoint& b = screen[(i + 1) % n];
+            area += a.x * b.y - b.x * a.y;
+        }
+        const bool frontFacing = area < 0.0f;
+        if ((cull == CullMode::Back && !frontFacing) || (cull == CullMode::Front && frontFacing)) {
+            culled++;
+            continue;
+        }
+
+        if (mode == MeshMode::Filled) {
+            for (int i = 1; i + 1 < n; i++) {
+                faces.push_back({ { screen[0], screen[i], screen[i + 1] }, depth });
+            }
+        } else {
+            for (int i = 0; i < n; i++) {
+                edges.push_back(screen[i]);
+                edges.push_back(screen[(i + 1) % n]);
+            }
+        }
+    }
+
+    if (mode == MeshMode::Filled) {
+        // Painter's algorithm: farthest (largest w) first
+        std::sort(faces.begin(), faces.end(), [](const Face& a, const Face& b) { return a.depth > b.depth; });
+        out.reserve(faces.size() * 3);
+        for (const Face& face : faces) {
+            _emitTriangle(face.p[0], face.p[1], face.p[2], color);
+        }
+    } else {
+        const float halfWidth = std::max(lineWidth, 1.0f) * 0.5f;
+        out.reserve(edges.size() * 3);
+        for (size_t i = 0; i + 1 < edges.size(); i += 2) {
+            _emitEdge(edges[i], edges[i + 1], halfWidth, color);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <SDL.h>
+#include <vector>
+
+enum class MeshMode {
+    Wireframe,
+    Filled
+};
+
+// Which faces to skip. Front faces are counter-clockwise in normalised device coordinates.
+enum class CullMode {
+    None,
+    Back,
+    Front
+};
+
+// Turns an indexed triangle mesh into a flat list of screen-space triangles for SDL_RenderGeometry.
+// Vertices are transformed in one pass, triangles are clipped against the near plane, culled by
+// winding, and filled faces are sorted back to front since SDL has no depth buffer.
+class MeshRasterizer {
+public:
+    // vertices: count x (x, y, z) floats, indices: triangleCount x 3 ints, mvp: row-major 4x4 applied as mvp * v
+    void build(const float* vertices, size_t vertexCount,
+               const int* indices, size_t triangleCount,
+               const float* mvp, float viewportWidth, float viewportHeight,
+               SDL_Color color, MeshMode mode, CullMode cull, float lineWidth);
+
+    const std::vector<SDL_Vertex>& output() const { return out; }
+    size_t culledCount() const { return culled; }
+    size_t clippedCount() const { return clipped; }
+
+private:
+    struct ClipVertex {
+        float x, y, z, w;
+    };
+    struct Face {
+        SDL_FPoint p[3];
+        float depth;
+    };
+
+    std::vector<ClipVertex> clip;
+    std::vector<Face> faces;
+    std::vector<SDL_FPoint> edges; // Pairs of endpoints
+    std::vector<SDL_Vertex> out;
+    size_t culled = 0;
+    size_t clipped = 0;
+
+    void _transform(const float* vertices, size_t count, const float* mvp);
+    void _emitTriangle(SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_Color color);
+    void _emitEdge(SDL_FPoint a, SDL_FPoint b, float halfWidth, SDL_Color color);
+};
+
+#endif
@@ -0,0 +1,687 @@
+#include "packet_codec.h"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace {
+    bool typeError(const char* expected, PyObject* value) {
+        PyErr_Format(PyExc_TypeError, "Expected %s, got %s", expected, Py_TYPE(value)->tp_name);
+        return false;
+    }
+
+    PyObject* truncated() {
+        PyErr_SetString(PyExc_ValueError, "Truncated packet");
+        return nullptr;
+    }
+
+    std::string_view spanBytes(const Snapshot& snapshot, const Snapshot::Span& span) {
+        return std::string_view(reinterpret_cast<const char*>(snapshot.bytes.data()) + span.begin, span.end - span.begin);
+    }
+}
+
+PacketCodec::PacketCodec() {
+    PyObject* types = PyImport_ImportModule("types");
+    if (types) {
+        namespaceType = PyObject_GetAttrString(types, "SimpleNamespace");
+        Py_DECREF(types);
+    }
+}
+
+PacketCodec::~PacketCodec() {
+    for (Named& entry : named) {
+        for (PyObject* name : entry.fieldNames) Py_DECREF(name);
+        for (PyObject* value : entry.values) Py_DECREF(value);
+        Py_XDECREF(entry.lookup);
+    }
+    Py_XDECREF(namespaceType);
+}
+
+int PacketCodec::_named(const std::string& name) {
+    // Referencing a name reserves it, so structs can be defined in any order
+    auto it = namedIds.find(name);
+    if (it != namedIds.end()) return it->second;
+    named.emplace_back();
+    named.back().name = name;
+    namedIds.emplace(name, static_cast<int>(named.size() - 1));
+    return static_cast<int>(named.size() - 1);
+}
+
+bool PacketCodec::isDefined(const std::string& name) const {
+    auto it = namedIds.find(name);
+    return it != namedIds.end() && named[it->second].defined;
+}
+
+int PacketCodec::_parse(const char*& spec) {
+    Type type;
+    switch (*spec++) {
+    case 'b': type.kind = Kind::Bool; break;
+    case 'i': type.kind = Kind::Int; break;
+    case 'f': type.kind = Kind::Float; break;
+    case 's': type.kind = Kind::String; break;
+    case '?':
+    case '[': {
+        const bool list = spec[-1] == '[';
+        type.kind = list ? Kind::List : Kind::Optional;
+        const int item = _parse(spec);
+        if (item == -1) return -1;
+        if (list && *spec++ != ']') {
+            PyErr_SetString(PyExc_ValueError, "Unterminated list in type spec");
+            return -1;
+        }
+        type.items.push_back(item);
+        break;
+    }
+    case '(':
+        type.kind = Kind::Tuple;
+        while (*spec != ')') {
+            if (*spec == '\0') {
+                PyErr_SetString(PyExc_ValueError, "Unterminated tuple in type spec");
+                return -1;
+            }
+            const int item = _parse(spec);
+            if (item == -1) return -1;
+            type.items.push_back(item);
+        }
+        spec++;
+        break;
+    case '<': {
+        const char* close = spec;
+        while (*close != '>' && *close != '\0') close++;
+        if (*close != '>' || close == spec) {
+            PyErr_SetString(PyExc_ValueError, "Bad type name in type spec");
+            return -1;
+        }
+        type.kind = Kind::Named;
+        type.ref = _named(std::string(spec, close));
+        spec = close + 1;
+        break;
+    }
+    default:
+        PyErr_Format(PyExc_ValueError, "Unknown type spec character '%c'", spec[-1]);
+        return -1;
+    }
+    types.push_back(std::move(type));
+    return static_cast<int>(types.size() - 1);
+}
+
+bool PacketCodec::defineEnum(const std::string& name, PyObject* members) {
+    if (isDefined(name)) {
+        PyErr_Format(PyExc_ValueError, "%s is already defined", name.c_str());
+        return false;
+    }
+    PyObject* sequence = PySequence_Fast(members, "Enum members must be a sequence");
+    if (!sequence) return false;
+
+    PyObject* lookup = PyDict_New();
+    std::vector<PyObject*> values;
+    bool ok = lookup != nullptr;
+    for (Py_ssize_t i = 0; ok && i < PySequence_Fast_GET_SIZE(sequence); i++) {
+        PyObject* member = PySequence_Fast_GET_ITEM(sequence, i);
+        PyObject* value = PyObject_GetAttrString(member, "value");
+        PyObject* index = PyLong_FromSsize_t(i);
+        ok = value && index && PyDict_SetItem(lookup, member, index) == 0 && PyDict_SetItem(lookup, value, index) == 0;
+        Py_XDECREF(index);
+        if (value) values.push_back(value);
+    }
+    Py_DECREF(sequence);
+    if (!ok) {
+        Py_XDECREF(lookup);
+        for (PyObject* value : values) Py_DECREF(value);
+        return false;
+    }
+
+    Named& entry = named[_named(name)];
+    entry.defined = true;
+    entry.isEnum = true;
+    entry.lookup = lookup;
+    entry.values = std::move(values);
+    return true;
+}
+
+bool PacketCodec::defineStruct(const std::string& name, const std::vector<std::pair<std::string, std::string>>& fields) {
+    if (isDefined(name)) {
+        PyErr_Format(PyExc_ValueError, "%s is already defined", name.c_str());
+        return false;
+    }
+    std::vector<int> fieldTypes;
+    for (const auto& [field, spec] : fields) {
+        const char* cursor = spec.c_str();
+        const int type = _parse(cursor);
+        if (type == -1) return false;
+        if (*cursor != '\0') {
+            PyErr_Format(PyExc_ValueError, "Trailing characters in type spec '%s' of %s.%s", spec.c_str(), name.c_str(), field.c_str());
+            return false;
+        }
+        fieldTypes.push_back(type);
+    }
+
+    std::vector<PyObject*> fieldNames;
+    for (const auto& field : fields) {
+        fieldNames.push_back(PyUnicode_InternFromString(field.first.c_str()));
+        if (!fieldNames.back()) {
+            fieldNames.pop_back();
+            for (PyObject* fieldName : fieldNames) Py_DECREF(fieldName);
+            return false;
+        }
+    }
+
+    Named& entry = named[_named(name)];
+    entry.defined = true;
+    entry.fieldNames = std::move(fieldNames);
+    entry.fieldTypes = std::move(fieldTypes);
+    for (size_t f = 0; f < fields.size(); f++) {
+        if (fields[f].first == "id") entry.keyField = static_cast<int>(f);
+    }
+    return true;
+}
+
+bool PacketCodec::bind(int packetType, const std::string& root) {
+    auto it = namedIds.find(root);
+    if (it == namedIds.end() || !named[it->second].defined || named[it->second].isEnum) {
+        PyErr_Format(PyExc_ValueError, "%s is not a defined struct", root.c_str());
+        return false;
+    }
+    Type type;
+    type.kind = Kind::Named;
+    type.ref = it->second;
+    types.push_back(std::move(type));
+    roots[packetType] = static_cast<int>(types.size() - 1);
+    return true;
+}
+
+int PacketCodec::_root(int packetType) {
+    auto root = roots.find(packetType);
+    if (root == roots.end()) {
+        PyErr_Format(PyExc_ValueError, "No schema bound for packet type %d", packetType);
+        return -1;
+    }
+    return root->second;
+}
+
+const PacketCodec::Named* PacketCodec::_resolve(const Type& type) {
+    const Named& entry = named[type.ref];
+    if (!entry.defined) {
+        PyErr_Format(PyExc_ValueError, "%s is referenced but never defined", entry.name.c_str());
+        return nullptr;
+    }
+    return &entry;
+}
+
+const PacketCodec::Named* PacketCodec::_keyedItem(const Type& type) const {
+    if (type.kind != Kind::List) return nullptr;
+    const Type& item = types[type.items[0]];
+    if (item.kind != Kind::Named) return nullptr;
+    const Named& entry = named[item.ref];
+    return entry.defined && !entry.isEnum && entry.keyField != -1 ? &entry : nullptr;
+}
+
+bool PacketCodec::_encode(int typeId, PyObject* value, ByteWriter& out, Span* span) {
+    if (!span) return _encodeValue(typeId, value, out, nullptr);
+    span->begin = out.size();
+    span->children.clear();
+    const bool ok = _encodeValue(typeId, value, out, span);
+    span->end = out.size();
+    return ok;
+}
+
+bool PacketCodec::_encodeValue(int typeId, PyObject* value, ByteWriter& out, Span* span) {
+    // Spans are only kept below the values a delta can look inside: struct fields, an optional's
+    // value and a keyed list's items
+    const Type& type = types[typeId];
+    switch (type.kind) {
+    case Kind::Bool: {
+        // True, False or the ints 0 and 1, which JSON round trips can leave in place of a bool
+        if (!PyLong_Check(value)) return typeError("bool", value);
+        const long number = PyLong_AsLong(value);
+        if (number == -1 && PyErr_Occurred()) return false;
+        if (number != 0 && number != 1) {
+            PyErr_Format(PyExc_ValueError, "Expected a bool, got %R", value);
+            return false;
+        }
+        out.writeByte(static_cast<Uint8>(number));
+        return true;
+    }
+    case Kind::Int: {
+        if (!PyLong_Check(value)) return typeError("int", value);
+        const long long number = PyLong_AsLongLong(value);
+        if (number == -1 && PyErr_Occurred()) return false;
+        out.writeZigzag(number);
+        return true;
+    }
+    case Kind::Float: {
+        // Ints are accepted too: card stats like attack_speed are sometimes written as whole numbers
+        if (!PyFloat_Check(value) && !PyLong_Check(value)) return typeError("float", value);
+        const double number = PyFloat_AsDouble(value);
+        if (number == -1.0 && PyErr_Occurred()) return false;
+        out.writeDouble(number);
+        return true;
+    }
+    case Kind::String: {
+        if (!PyUnicode_Check(value)) return typeError("str", value);
+        Py_ssize_t size;
+        const char* text = PyUnicode_AsUTF8AndSize(value, &size);
+        if (!text) return false;
+        out.writeString(text, static_cast<size_t>(size));
+        return true;
+    }
+    case Kind::Optional:
+        if (value == Py_None) {
+            out.writeByte(0);
+            return true;
+        }
+        out.writeByte(1);
+        if (span) span->children.emplace_back();
+        return _encode(type.items[0], value, out, span ? &span->children.back() : nullptr);
+    case Kind::List:
+    case Kind::Tuple: {
+        // A str is a sequence too, but never what a list field means
+        if (PyUnicode_Check(value) || PyBytes_Check(value)) return typeError("sequence", value);
+        PyObject* sequence = PySequence_Fast(value, "Expected a sequence");
+        if (!sequence) return false;
+        const Py_ssize_t size = PySequence_Fast_GET_SIZE(sequence);
+        if (type.kind == Kind::Tuple && size != static_cast<Py_ssize_t>(type.items.size())) {
+            Py_DECREF(sequence);
+            PyErr_Format(PyExc_ValueError, "Expected %zu items, got %zd", type.items.size(), size);
+            return false;
+        }
+        if (type.kind == Kind::List) out.writeVarint(static_cast<Uint64>(size));
+        const bool keyed = span && _keyedItem(type);
+        if (keyed) span->children.resize(static_cast<size_t>(size));
+        bool ok = true;
+        for (Py_ssize_t i = 0; ok && i < size; i++) {
+            const int item = type.kind == Kind::List ? type.items[0] : type.items[i];
+            ok = _encode(item, PySequence_Fast_GET_ITEM(sequence, i), out, keyed ? &span->children[i] : nullptr);
+        }
+        Py_DECREF(sequence);
+        return ok;
+    }
+    case Kind::Named: {
+        const Named* entry = _resolve(type);
+        if (!entry) return false;
+        if (entry->isEnum) {
+            PyObject* index = PyDict_GetItemWithError(entry->lookup, value);
+            if (!index) {
+                if (!PyErr_Occurred()) PyErr_Format(PyExc_ValueError, "%R is not a member of %s", value, entry->name.c_str());
+                return false;
+            }
+            out.writeVarint(static_cast<Uint64>(PyLong_AsSsize_t(index)));
+            return true;
+        }
+
+        if (Py_EnterRecursiveCall(" while encoding a packet")) return false;
+        if (span) span->children.resize(entry->fieldNames.size());
+        bool ok = true;
+        for (size_t f = 0; ok && f < entry->fieldNames.size(); f++) {
+            PyObject* field = PyObject_GetAttr(value, entry->fieldNames[f]);
+            ok = field && _encode(entry->fieldTypes[f], field, out, span ? &span->children[f] : nullptr);
+            Py_XDECREF(field);
+        }
+        Py_LeaveRecursiveCall();
+        return ok;
+    }
+    }
+    return false;
+}
+
+PyObject* PacketCodec::_decode(int typeId, ByteReader& in) {
+    const Type& type = types[typeId];
+    switch (type.kind) {
+    case Kind::Bool: {
+        Uint8 byte;
+        if (!in.readByte(byte)) return truncated();
+        if (byte > 1) {
+            PyErr_Format(PyExc_ValueError, "Invalid bool byte %u", static_cast<unsigned>(byte));
+            return nullptr;
+        }
+        return PyBool_FromLong(byte);
+    }
+    case Kind::Int: {
+        Sint64 number;
+        if (!in.readZigzag(number)) return truncated();
+        return PyLong_FromLongLong(number);
+    }
+    case Kind::Float: {
+        double number;
+        if (!in.readDouble(number)) return truncated();
+        return PyFloat_FromDouble(number);
+    }
+    case Kind::String: {
+        const char* text;
+        size_t size;
+        if (!in.readString(text, size)) return truncated();
+        return PyUnicode_DecodeUTF8(text, static_cast<Py_ssize_t>(size), "strict");
+    }
+    case Kind::Optional: {
+        Uint8 present;
+        if (!in.readByte(present)) return truncated();
+        if (!present) Py_RETURN_NONE;
+        return _decode(type.items[0], in);
+    }
+    case Kind::List:
+    case Kind::Tuple: {
+        Uint64 count = type.items.size();
+        if (type.kind == Kind::List) {
+            // Every item takes at least one byte, which bounds a corrupt count before allocating
+            if (!in.readVarint(count) || count > in.remaining()) return truncated();
+        }
+        const Py_ssize_t size = static_cast<Py_ssize_t>(count);
+        PyObject* result = type.kind == Kind::List ? PyList_New(size) : PyTuple_New(size);
+        if (!result) return nullptr;
+        for (Py_ssize_t i = 0; i < size; i++) {
+            PyObject* item = _decode(type.kind == Kind::List ? type.items[0] : type.items[i], in);
+            if (!item) {
+                Py_DECREF(result);
+                return nullptr;
+            }
+            if (type.kind == Kind::List) {
+                PyList_SET_ITEM(result, i, item);
+            } else {
+                PyTuple_SET_ITEM(result, i, item);
+            }
+        }
+        return result;
+    }
+    case Kind::Named: {
+        const Named* entry = _resolve(type);
+        if (!entry) return nullptr;
+        if (entry->isEnum) {
+            Uint64 index;
+            if (!in.readVarint(index)) return truncated();
+            if (index >= entry->values.size()) {
+                PyErr_Format(PyExc_ValueError, "Bad %s index %llu", entry->name.c_str(), static_cast<unsigned long long>(index));
+                return nullptr;
+            }
+            PyObject* value = entry->values[index];
+            Py_INCREF(value);
+            return value;
+        }
+
+        if (!namespaceType) {
+            PyErr_SetString(PyExc_RuntimeError, "types.SimpleNamespace is unavailable");
+            return nullptr;
+        }
+        if (Py_EnterRecursiveCall(" while decoding a packet")) return nullptr;
+        PyObject* result = PyObject_CallNoArgs(namespaceType);
+        for (size_t f = 0; result && f < entry->fieldNames.size(); f++) {
+            PyObject* field = _decode(entry->fieldTypes[f], in);
+            if (!field || PyObject_SetAttr(result, entry->fieldNames[f], field) != 0) {
+                Py_CLEAR(result);
+            }
+            Py_XDECREF(field);
+        }
+        Py_LeaveRecursiveCall();
+        return result;
+    }
+    }
+    return nullptr;
+}
+
+PyObject* PacketCodec::encode(int packetType, PyObject* value) {
+    const int root = _root(packetType);
+    if (root == -1) return nullptr;
+    // Per thread because getattr can run Python code, which may let another thread encode meanwhile
+    thread_local ByteWriter out;
+    out.clear();
+    out.writeByte(Marker);
+    if (!_encode(root, value, out)) return nullptr;
+    return PyBytes_FromStringAndSize(reinterpret_cast<const char*>(out.data()), static_cast<Py_ssize_t>(out.size()));
+}
+
+PyObject* PacketCodec::decode(int packetType, const Uint8* data, size_t size) {
+    const int root = _root(packetType);
+    if (root == -1) return nullptr;
+    ByteReader in(data, size);
+    Uint8 marker;
+    if (!in.readByte(marker) || marker != Marker) {
+        PyErr_SetString(PyExc_ValueError, "Not a binary packet");
+        return nullptr;
+    }
+    PyObject* result = _decode(root, in);
+    if (result && in.remaining() != 0) {
+        Py_DECREF(result);
+        PyErr_SetString(PyExc_ValueError, "Trailing bytes after packet");
+        return nullptr;
+    }
+    return result;
+}
+
+bool PacketCodec::snapshot(int packetType, PyObject* value, Snapshot& out) {
+    const int root = _root(packetType);
+    if (root == -1) return false;
+    out.bytes.clear();
+    return _encode(root, value, out.bytes, &out.root);
+}
+
+PyObject* PacketCodec::decodeValue(int packetType, ByteReader& in) {
+    const int root = _root(packetType);
+    return root == -1 ? nullptr : _decode(root, in);
+}
+
+bool PacketCodec::writeDelta(int packetType, const Snapshot& base, const Snapshot& current, ByteWriter& out) {
+    const int root = _root(packetType);
+    if (root == -1) return false;
+    _delta(root, base, base.root, current, current.root, out);
+    return true;
+}
+
+void PacketCodec::_delta(int typeId, const Snapshot& base, const Span& from, const Snapshot& current, const Span& to,
+                         ByteWriter& out) {
+    const Type& type = types[typeId];
+    if (type.kind == Kind::Optional) {
+        // 0 is now None, 1 a full value (the base was None) and 2 a delta against the base's value
+        if (to.children.empty()) {
+            out.writeByte(0);
+        } else if (from.children.empty()) {
+            out.writeByte(1);
+            const std::string_view value = spanBytes(current, to.children[0]);
+            out.writeBytes(value.data(), value.size());
+        } else {
+            out.writeByte(2);
+            _delta(type.items[0], base, from.children[0], current, to.children[0], out);
+        }
+        return;
+    }
+
+    if (type.kind == Kind::List && _keyedItem(type)) {
+        if (_keyedDelta(typeId, base, from, current, to, out)) return;
+        out.writeByte(0);
+        const std::string_view value = spanBytes(current, to);
+        out.writeBytes(value.data(), value.size());
+        return;
+    }
+
+    if (type.kind == Kind::Named && !named[type.ref].isEnum) {
+        const Named& entry = named[type.ref];
+        const size_t count = entry.fieldTypes.size();
+        std::vector<Uint8> changed((count + 7) / 8, 0);
+        for (size_t f = 0; f < count; f++) {
+            if (spanBytes(base, from.children[f]) != spanBytes(current, to.children[f])) {
+                changed[f / 8] |= static_cast<Uint8>(1 << (f % 8));
+            }
+        }
+        out.writeBytes(changed.data(), changed.size());
+        for (size_t f = 0; f < count; f++) {
+            if (changed[f / 8] & (1 << (f % 8))) {
+                _delta(entry.fieldTypes[f], base, from.children[f], current, to.children[f], out);
+            }
+        }
+        return;
+    }
+
+    const std::string_view value = spanBytes(current, to);
+    out.writeBytes(value.data(), value.size());
+}
+
+bool PacketCodec::_keyedDelta(int typeId, const Snapshot& base, const Span& from, const Snapshot& current,
+                              const Span& to, ByteWriter& out) {
+    const int itemType = types[typeId].items[0];
+    const int keyField = _keyedItem(types[typeId])->keyField;
+    std::unordered_map<std::string_view, size_t> baseIndex;
+    for (size_t i = 0; i < from.children.size(); i++) {
+        if (!baseIndex.emplace(spanBytes(base, from.children[i].children[keyField]), i).second) return false;
+    }
+
+    // The applied list keeps surviving items in base order and appends new ones, so anything else
+    // (a reorder, a repeated key) is sent in full instead
+    std::vector<size_t> matched(to.children.size(), SIZE_MAX);
+    std::vector<Uint8> kept(from.children.size(), 0);
+    size_t lastKept = 0, added = 0;
+    for (size_t i = 0; i < to.children.size(); i++) {
+        auto it = baseIndex.find(spanBytes(current, to.children[i].children[keyField]));
+        if (it == baseIndex.end()) {
+            added++;
+            continue;
+        }
+        if (added != 0 || kept[it->second] || (lastKept != 0 && it->second < lastKept)) return false;
+        kept[it->second] = 1;
+        lastKept = it->second + 1;
+        matched[i] = it->second;
+    }
+
+    out.writeByte(1);
+    out.writeVarint(static_cast<Uint64>(std::count(kept.begin(), kept.end(), 0)));
+    for (size_t i = 0; i < kept.size(); i++) {
+        if (!kept[i]) out.writeVarint(i);
+    }
+
+    size_t changed = 0;
+    for (size_t i = 0; i < to.children.size(); i++) {
+        changed += matched[i] != SIZE_MAX && spanBytes(base, from.children[matched[i]]) != spanBytes(current, to.children[i]);
+    }
+    out.writeVarint(changed);
+    for (size_t i = 0; i < to.children.size(); i++) {
+        if (matched[i] == SIZE_MAX) continue;
+        const Span& was = from.children[matched[i]];
+        if (spanBytes(base, was) == spanBytes(current, to.children[i])) continue;
+        out.writeVarint(matched[i]);
+        _delta(itemType, base, was, current, to.children[i], out);
+    }
+
+    out.writeVarint(added);
+    for (size_t i = 0; i < to.children.size(); i++) {
+        if (matched[i] != SIZE_MAX) continue;
+        const std::string_view item = spanBytes(current, to.children[i]);
+        out.writeBytes(item.data(), item.size());
+    }
+    return true;
+}
+
+PyObject* PacketCodec::applyDelta(int packetType, PyObject* base, ByteReader& in) {
+    const int root = _root(packetType);
+    return root == -1 ? nullptr : _apply(root, base, in);
+}
+
+PyObject* PacketCodec::_apply(int typeId, PyObject* base, ByteReader& in) {
+    const Type& type = types[typeId];
+    if (type.kind == Kind::Optional) {
+        Uint8 mode;
+        if (!in.readByte(mode)) return truncated();
+        if (mode == 0) Py_RETURN_NONE;
+        if (mode == 1) return _decode(type.items[0], in);
+        if (mode != 2 || base == Py_None) {
+            PyErr_SetString(PyExc_ValueError, "Bad optional in delta");
+            return nullptr;
+        }
+        return _apply(type.items[0], base, in);
+    }
+
+    if (type.kind == Kind::List && _keyedItem(type)) return _applyKeyed(typeId, base, in);
+
+    if (type.kind == Kind::Named && !named[type.ref].isEnum) {
+        const Named* entry = _resolve(type);
+        if (!entry) return nullptr;
+        const size_t count = entry->fieldTypes.size();
+        const Uint8* changed;
+        if (!in.readBytes((count + 7) / 8, changed)) return truncated();
+
+        if (!namespaceType) {
+            PyErr_SetString(PyExc_RuntimeError, "types.SimpleNamespace is unavailable");
+            return nullptr;
+        }
+        if (Py_EnterRecursiveCall(" while applying a delta")) return nullptr;
+        PyObject* result = PyObject_CallNoArgs(namespaceType);
+        for (size_t f = 0; result && f < count; f++) {
+            // Unchanged fields share the base's objects
+            PyObject* field = PyObject_GetAttr(base, entry->fieldNames[f]);
+            if (field && (changed[f / 8] & (1 << (f % 8)))) {
+                PyObject* applied = _apply(entry->fieldTypes[f], field, in);
+                Py_DECREF(field);
+                field = applied;
+            }
+            if (!field || PyObject_SetAttr(result, entry->fieldNames[f], field) != 0) {
+                Py_CLEAR(result);
+            }
+            Py_XDECREF(field);
+        }
+        Py_LeaveRecursiveCall();
+        return result;
+    }
+
+    return _decode(typeId, in);
+}
+
+PyObject* PacketCodec::_applyKeyed(int typeId, PyObject* base, ByteReader& in) {
+    Uint8 mode;
+    if (!in.readByte(mode)) return truncated();
+    if (mode == 0) return _decode(typeId, in);
+    if (mode != 1 || !PyList_Check(base)) {
+        PyErr_SetString(PyExc_ValueError, "Bad keyed list in delta");
+        return nullptr;
+    }
+
+    const int itemType = types[typeId].items[0];
+    const size_t size = static_cast<size_t>(PyList_GET_SIZE(base));
+    // Owned replacements for changed items; removed ones are marked with Py_None
+    std::vector<PyObject*> replaced(size, nullptr);
+    auto release = [&replaced]() {
+        for (PyObject* item : replaced) {
+            if (item != Py_None) Py_XDECREF(item);
+        }
+    };
+
+    Uint64 count, index;
+    if (!in.readVarint(count) || count > size) return truncated();
+    for (Uint64 i = 0; i < count; i++) {
+        if (!in.readVarint(index) || index >= size || replaced[index]) {
+            release();
+            PyErr_SetString(PyExc_ValueError, "Bad removed item in delta");
+            return nullptr;
+        }
+        replaced[index] = Py_None;
+    }
+
+    if (!in.readVarint(count) || count > size) {
+        release();
+        return truncated();
+    }
+    for (Uint64 i = 0; i < count; i++) {
+        if (!in.readVarint(index) || index >= size || replaced[index]) {
+            release();
+            PyErr_SetString(PyExc_ValueError, "Bad changed item in delta");
+            return nullptr;
+        }
+        replaced[index] = _apply(itemType, PyList_GET_ITEM(base, index), in);
+        if (!replaced[index]) {
+            release();
+            return nullptr;
+        }
+    }
+
+    Uint64 added;
+    if (!in.readVarint(added) || added > in.remaining()) {
+        release();
+        return truncated();
+    }
+    PyObject* result = PyList_New(0);
+    for (size_t i = 0; result && i < size; i++) {
+        PyObject* item = replaced[i] ? replaced[i] : PyList_GET_ITEM(base, i);
+        if (item != Py_None && PyList_Append(result, item) != 0) Py_CLEAR(result);
+    }
+    release();
+    for (Uint64 i = 0; result && i < added; i++) {
+        PyObject* item = _decode(itemType, in);
+        if (!item || PyList_Append(result, item) != 0) Py_CLEAR(result);
+        Py_XDECREF(item);
+    }
+    return result;
+}
@@ -0,0 +1,113 @@
+#ifndef PACKET_CODEC_H
+#define PACKET_CODEC_H
+
+#include <Python.h>
+#include "codec.h"
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// An encoded value with the byte span of every struct field, optional value and keyed list item beneath
+// it, so a later state can be diffed against it without any Python objects
+struct Snapshot {
+    struct Span {
+        size_t begin = 0, end = 0;
+        std::vector<Span> children;
+    };
+
+    ByteWriter bytes;
+    Span root;
+};
+
+// Schema-driven binary encoding of packet payloads, walking Python objects directly so neither side
+// builds the intermediate dicts and JSON text that Packet.from_struct used to. Schemas are registered
+// once from Python's type hints; each field's type is a short spec:
+//   b bool, i int (zigzag varint), f float (fixed 8 bytes), s str (length-prefixed UTF-8),
+//   ?T optional, [T] list, (T T ...) fixed tuple, <Name> a named struct or enum.
+// Structs encode their fields in order with no names or tags. Encoding reads fields with getattr, so
+// dataclasses, plain objects and SimpleNamespaces all work; decoding builds SimpleNamespaces with
+// enums as their raw values, the same shape the JSON object_hook produced.
+//
+// A list of structs with an "id" field is keyed: deltas (see writeDelta) address its items by position
+// in the base and carry only the items that changed, were removed or were added.
+//
+// Methods returning bool or PyObject* report failure as false / nullptr with a Python exception set,
+// and all of them must be called with the GIL held.
+class PacketCodec {
+public:
+    // First byte of every binary payload; it can never start the ASCII text of a JSON one
+    static constexpr Uint8 Marker = 0xB1;
+
+    PacketCodec();
+    ~PacketCodec();
+
+    PacketCodec(const PacketCodec&) = delete;
+    PacketCodec& operator=(const PacketCodec&) = delete;
+
+    // members are the enum's members; they and their values both encode as the member's index
+    bool defineEnum(const std::string& name, PyObject* members);
+    bool defineStruct(const std::string& name, const std::vector<std::pair<std::string, std::string>>& fields);
+    bool isDefined(const std::string& name) const;
+    // Encodes packets of packetType with the named struct as the root
+    bool bind(int packetType, const std::string& root);
+    bool supports(int packetType) const { return roots.count(packetType) != 0; }
+
+    // A new bytes object, starting with Marker
+    PyObject* encode(int packetType, PyObject* value);
+    PyObject* decode(int packetType, const Uint8* data, size_t size);
+
+    // Encodes value without the marker, recording spans for writeDelta
+    bool snapshot(int packetType, PyObject* value, Snapshot& out);
+    // Appends what changed from base to current: per struct a bitmap of changed fields followed by
+    // their deltas, per keyed list the removed, changed and added items, and anything else in full
+    bool writeDelta(int packetType, const Snapshot& base, const Snapshot& current, ByteWriter& out);
+    // A new state from base (as decoded or applied before) and a delta; unchanged values are shared
+    PyObject* applyDelta(int packetType, PyObject* base, ByteReader& in);
+    // The root value alone, as snapshot wrote it
+    PyObject* decodeValue(int packetType, ByteReader& in);
+
+private:
+    using Span = Snapshot::Span;
+
+    enum class Kind : Uint8 { Bool, Int, Float, String, Optional, List, Tuple, Named };
+
+    struct Type {
+        Kind kind;
+        int ref = -1;           // Index into named for Named
+        std::vector<int> items; // Element types for Optional, List and Tuple
+    };
+
+    struct Named {
+        std::string name;
+        bool defined = false;
+        bool isEnum = false;
+        std::vector<PyObject*> fieldNames; // Interned
+        std::vector<int> fieldTypes;
+        int keyField = -1;                 // The "id" field, which keys lists of this struct
+        PyObject* lookup = nullptr;        // Member or value -> index
+        std::vector<PyObject*> values;     // Index -> value
+    };
+
+    std::vector<Type> types;
+    std::vector<Named> named;
+    std::unordered_map<std::string, int> namedIds;
+    std::unordered_map<int, int> roots; // Packet type -> type
+    PyObject* namespaceType = nullptr;
+
+    int _named(const std::string& name);
+    int _parse(const char*& spec);
+    int _root(int packetType);
+    const Named* _resolve(const Type& type);
+    const Named* _keyedItem(const Type& type) const;
+    bool _encode(int type, PyObject* value, ByteWriter& out, Span* span = nullptr);
+    bool _encodeValue(int type, PyObject* value, ByteWriter& out, Span* span);
+    PyObject* _decode(int type, ByteReader& in);
+    void _delta(int type, const Snapshot& base, const Span& from, const Snapshot& current, const Span& to, ByteWriter& out);
+    bool _keyedDelta(int type, const Snapshot& base, const Span& from, const Snapshot& current, const Span& to,
+                     ByteWriter& out);
+    PyObject* _apply(int type, PyObject* base, ByteReader& in);
+    PyObject* _applyKeyed(int type, PyObject* base, ByteReader& in);
+};
+
+#endif
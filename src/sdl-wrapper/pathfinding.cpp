@@ -0,0 +1,250 @@
+#include "pathfinding.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+namespace {
+    // Left, right, up, down, matching arena.py
+    constexpr int DirX[4] = { -1, 1, 0, 0 };
+    constexpr int DirY[4] = { 0, 0, -1, 1 };
+
+    // std heap functions build a max-heap, so "less" means popped later
+    struct PopsLater {
+        template <typename Node>
+        bool operator()(const Node& a, const Node& b) const {
+            if (a.f != b.f) return a.f > b.f;
+            if (a.x != b.x) return a.x > b.x;
+            return a.y > b.y;
+        }
+    };
+}
+
+TileGrid::TileGrid(int width, int height)
+    : w(std::max(width, 0)), h(std::max(height, 0)), tiles(static_cast<size_t>(w) * h, TileEmpty) {}
+
+bool TileGrid::setTiles(const Uint8* src, size_t count) {
+    if (count != tiles.size() || std::memcmp(src, tiles.data(), count) == 0) {
+        return false;
+    }
+    std::memcpy(tiles.data(), src, count);
+    rev++;
+    return true;
+}
+
+FlowField::FlowField(int goalX, int goalY) : gx(goalX), gy(goalY) {}
+
+bool FlowField::update(const TileGrid& grid) {
+    if (built && revision == grid.revision()) {
+        return false;
+    }
+    _build(grid);
+    revision = grid.revision();
+    built = true;
+    return true;
+}
+
+void FlowField::_build(const TileGrid& grid) {
+    const int w = grid.width(), h = grid.height();
+    const size_t cells = static_cast<size_t>(w) * h;
+    dist.assign(cells, -1);
+    stepCount.assign(cells, -1);
+    nextCell.assign(cells, -1);
+    order.clear();
+    heap.clear();
+
+    if (!grid.inBounds(gx, gy) || TileGrid::isObstacle(grid.at(gx, gy))) {
+        return;
+    }
+
+    // Reverse Dijkstra: stepping from u onto v costs moveCost(v), so v's cost is added when relaxing u from v
+    const int goal = gy * w + gx;
+    dist[goal] = 0;
+    heap.push_back({ 0, goal });
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+        const auto [d, cell] = heap.back();
+        heap.pop_back();
+        if (d > dist[cell]) continue;
+        order.push_back(cell);
+
+        const int x = cell % w, y = cell / w;
+        const int enter = TileGrid::moveCost(grid.at(cell));
+        for (int k = 0; k < 4; k++) {
+            const int nx = x + DirX[k], ny = y + DirY[k];
+            if (!grid.inBounds(nx, ny)) continue;
+            const int neighbour = ny * w + nx;
+            if (TileGrid::isObstacle(grid.at(neighbour))) continue;
+            const int candidate = d + enter;
+            if (dist[neighbour] == -1 || candidate < dist[neighbour]) {
+                dist[neighbour] = candidate;
+                heap.push_back({ candidate, neighbour });
+                std::push_heap(heap.begin(), heap.end(), std::greater<>());
+            }
+        }
+    }
+
+    // Pick next pointers once costs are final so ties always resolve left, right, up, down
+    stepCount[goal] = 0;
+    for (size_t i = 1; i < order.size(); i++) {
+        const int cell = order[i];
+        const int x = cell % w, y = cell / w;
+        for (int k = 0; k < 4; k++) {
+            const int nx = x + DirX[k], ny = y + DirY[k];
+            if (!grid.inBounds(nx, ny)) continue;
+            const int neighbour = ny * w + nx;
+            if (dist[neighbour] != -1 && dist[neighbour] + TileGrid::moveCost(grid.at(neighbour)) == dist[cell]) {
+                nextCell[cell] = neighbour;
+                stepCount[cell] = stepCount[neighbour] + 1; // Settled earlier, so already set
+                break;
+            }
+        }
+    }
+}
+
+GridPathfinder::GridPathfinder(int width, int height) : tiles(width, height) {
+    const size_t cells = static_cast<size_t>(tiles.width()) * tiles.height();
+    gScore.resize(cells);
+    parent.resize(cells);
+    stamp.resize(cells, 0);
+    // Each cell can be pushed once per improvement; four per cell covers the common case without regrowth
+    open.reserve(cells * 4);
+}
+
+void GridPathfinder::_beginSearch() {
+    if (++generation == 0) {
+        // Wrapped around: stamps from 2^32 searches ago would otherwise read as current
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 1;
+    }
+    open.clear();
+    expanded = 0;
+}
+
+bool GridPathfinder::findPath(int startX, int startY, int goalX, int goalY, std::vector<int>& out) {
+    out.clear();
+    if (!tiles.inBounds(startX, startY) || !tiles.inBounds(goalX, goalY) ||
+        TileGrid::isObstacle(tiles.at(startX, startY)) || TileGrid::isObstacle(tiles.at(goalX, goalY))) {
+        return false;
+    }
+
+    _beginSearch();
+    const int w = tiles.width();
+    auto heuristic = [&](int x, int y) { return 2 * (std::abs(x - goalX) + std::abs(y - goalY)); };
+
+    const int startCell = startY * w + startX;
+    const int goalCell = goalY * w + goalX;
+    gScore[startCell] = 0;
+    parent[startCell] = -1;
+    stamp[startCell] = generation;
+    open.push_back({ heuristic(startX, startY), startX, startY, 0 });
+
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), PopsLater());
+        const OpenNode current = open.back();
+        open.pop_back();
+
+        const int cell = current.y * w + current.x;
+        // A cheaper route to this cell was queued after this entry; expanding it again would change nothing
+        if (current.g > gScore[cell]) continue;
+        expanded++;
+
+        if (cell == goalCell) {
+            for (int c = goalCell; c != -1; c = parent[c]) {
+                out.push_back(c % w);
+                out.push_back(c / w);
+            }
+            // Reverse pairwise so the path runs start -> goal
+            const size_t steps = out.size() / 2;
+            for (size_t i = 0; i < steps / 2; i++) {
+                std::swap(out[2 * i], out[2 * (steps - 1 - i)]);
+                std::swap(out[2 * i + 1], out[2 * (steps - 1 - i) + 1]);
+            }
+            return true;
+        }
+
+        for (int d = 0; d < 4; d++) {
+            const int nx = current.x + DirX[d], ny = current.y + DirY[d];
+            if (!tiles.inBounds(nx, ny)) continue;
+            const int next = ny * w + nx;
+            const Uint8 tile = tiles.at(next);
+            if (TileGrid::isObstacle(tile)) continue;
+
+            const int tentative = current.g + TileGrid::moveCost(tile);
+            if (stamp[next] != generation || tentative < gScore[next]) {
+                stamp[next] = generation;
+                gScore[next] = tentative;
+                parent[next] = cell;
+                open.push_back({ tentative + heuristic(nx, ny), nx, ny, tentative });
+                std::push_heap(open.begin(), open.end(), PopsLater());
+            }
+        }
+    }
+
+    return false;
+}
+
+GridPathfinder::GridPathfinder(const GridPathfinder& other)
+    : tiles(other.tiles), gScore(other.gScore), parent(other.parent), stamp(other.stamp), open(other.open),
+      generation(other.generation), expanded(other.expanded) {
+    fields.reserve(other.fields.size());
+    for (const auto& field : other.fields) {
+        fields.push_back(std::make_unique<FlowField>(*field));
+    }
+}
+
+GridPathfinder& GridPathfinder::operator=(const GridPathfinder& other) {
+    if (this != &other) {
+        GridPathfinder copy(other);
+        std::swap(tiles, copy.tiles);
+        std::swap(gScore, copy.gScore);
+        std::swap(parent, copy.parent);
+        std::swap(stamp, copy.stamp);
+        std::swap(open, copy.open);
+        std::swap(generation, copy.generation);
+        std::swap(expanded, copy.expanded);
+        std::swap(fields, copy.fields);
+    }
+    return *this;
+}
+
+int GridPathfinder::flowField(int goalX, int goalY) {
+    if (!tiles.inBounds(goalX, goalY)) {
+        return -1;
+    }
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (fields[i]->goalX() == goalX && fields[i]->goalY() == goalY) {
+            return static_cast<int>(i);
+        }
+    }
+    fields.push_back(std::make_unique<FlowField>(goalX, goalY));
+    return static_cast<int>(fields.size() - 1);
+}
+
+const FlowField* GridPathfinder::flow(int id) {
+    if (id < 0 || static_cast<size_t>(id) >= fields.size()) {
+        return nullptr;
+    }
+    // Lazy: only fields that are actually queried pay for a rebuild after the grid changes
+    fields[id]->update(tiles);
+    return fields[id].get();
+}
+
+bool GridPathfinder::flowPath(int id, int startX, int startY, std::vector<int>& out) {
+    out.clear();
+    const FlowField* field = flow(id);
+    if (!field || !tiles.inBounds(startX, startY)) {
+        return false;
+    }
+    const int w = tiles.width();
+    int cell = startY * w + startX;
+    if (field->cost(cell) == -1) {
+        return false;
+    }
+    out.reserve(static_cast<size_t>(field->steps(cell) + 1) * 2);
+    for (; cell != -1; cell = field->next(cell)) {
+        out.push_back(cell % w);
+        out.push_back(cell / w);
+    }
+    return true;
+}
@@ -0,0 +1,121 @@
+#ifndef PATHFINDING_H
+#define PATHFINDING_H
+
+#include <SDL.h>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Mirrors arena.TileType
+enum ArenaTile : Uint8 {
+    TileEmpty = 0,
+    TileRiver = 1,
+    TileBridge = 2,
+    TileCrownTower = 3,
+    TileKingTower = 4
+};
+
+// Flat row-major copy of Arena.tiles. The revision only moves when the contents actually change,
+// so anything derived from the grid can tell when it has gone stale.
+class TileGrid {
+public:
+    TileGrid(int width, int height);
+
+    // count must be width * height; returns true if any tile differed
+    bool setTiles(const Uint8* tiles, size_t count);
+
+    int width() const { return w; }
+    int height() const { return h; }
+    Uint64 revision() const { return rev; }
+    bool inBounds(int x, int y) const { return x >= 0 && y >= 0 && x < w && y < h; }
+    Uint8 at(int x, int y) const { return tiles[static_cast<size_t>(y) * w + x]; }
+    Uint8 at(int cell) const { return tiles[cell]; }
+    const Uint8* data() const { return tiles.data(); }
+
+    // Rivers and tower footprints block movement
+    static bool isObstacle(Uint8 tile) { return tile == TileRiver || tile == TileCrownTower || tile == TileKingTower; }
+    // Costs are doubled so the bridge's 0.5 stays an integer: empty = 2, bridge = 1
+    static int moveCost(Uint8 tile) { return tile == TileEmpty ? 2 : 1; }
+
+private:
+    int w, h;
+    Uint64 rev = 0;
+    std::vector<Uint8> tiles;
+};
+
+// Distance field toward one goal tile: for every tile, the cost and number of moves to reach the goal
+// and which neighbour to step onto next. Built by a reverse Dijkstra from the goal, after which steering
+// any number of units toward it is a lookup per unit instead of a search.
+class FlowField {
+public:
+    FlowField(int goalX, int goalY);
+
+    // Rebuilds against grid if it has changed since the last build; returns true if it rebuilt
+    bool update(const TileGrid& grid);
+
+    int goalX() const { return gx; }
+    int goalY() const { return gy; }
+    Uint64 builtRevision() const { return revision; }
+
+    // Cell index of the next tile toward the goal, -1 at the goal itself or if unreachable
+    int next(int cell) const { return nextCell[cell]; }
+    // Doubled cost (see TileGrid::moveCost) and move count to the goal, -1 if unreachable
+    int cost(int cell) const { return dist[cell]; }
+    int steps(int cell) const { return stepCount[cell]; }
+
+private:
+    int gx, gy;
+    Uint64 revision = 0;
+    bool built = false;
+    std::vector<int> dist;
+    std::vector<int> stepCount;
+    std::vector<int> nextCell;
+    std::vector<int> order; // Cells in settle order, so each cell's next is handled before it
+    std::vector<std::pair<int, int>> heap;
+
+    void _build(const TileGrid& grid);
+};
+
+// A* over a TileGrid with 4-way movement and a Manhattan heuristic. Every buffer is sized once for
+// the grid and reused; a generation stamp stands in for clearing the per-cell state between searches.
+// Ties are broken on (f, x, y) the way arena.py's heap of (f, (x, y)) does, so both return the same path.
+class GridPathfinder {
+public:
+    GridPathfinder(int width, int height);
+    // Copies clone the flow fields, so a copied BattleSim steps independently of the original
+    GridPathfinder(const GridPathfinder& other);
+    GridPathfinder& operator=(const GridPathfinder& other);
+
+    TileGrid& grid() { return tiles; }
+    const TileGrid& grid() const { return tiles; }
+
+    // Replaces out with start..goal inclusive as (x, y) pairs; leaves it empty and returns false if unreachable
+    bool findPath(int startX, int startY, int goalX, int goalY, std::vector<int>& out);
+
+    size_t lastExpanded() const { return expanded; }
+
+    // Returns the id of the flow field toward (goalX, goalY), creating it on first use; -1 if out of bounds
+    int flowField(int goalX, int goalY);
+    // The field brought up to date with the current grid, or nullptr for an unknown id
+    const FlowField* flow(int id);
+    // Same output convention as findPath, walking the field's next pointers instead of searching
+    bool flowPath(int id, int startX, int startY, std::vector<int>& out);
+
+private:
+    struct OpenNode {
+        int f, x, y, g;
+    };
+
+    TileGrid tiles;
+    std::vector<int> gScore;
+    std::vector<int> parent;
+    std::vector<Uint32> stamp; // A cell's gScore/parent are only valid when stamp == generation
+    std::vector<OpenNode> open;
+    Uint32 generation = 0;
+    size_t expanded = 0;
+    std::vector<std::unique_ptr<FlowField>> fields;
+
+    void _beginSearch();
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include "scheduler.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    for (size_t i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 1; i < threads; i++) {
+        workers.emplace_back(&WorkStealingPool::_worker, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+bool WorkStealingPool::_runOne(size_t self) {
+    size_t item = 0;
+    bool found = false;
+    {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.items.empty()) {
+            item = own.items.front();
+            own.items.pop_front();
+            found = true;
+        }
+    }
+    // Steal from the opposite end to the owner so the two rarely contend for the same item
+    for (size_t offset = 1; !found && offset < queues.size(); offset++) {
+        Queue& victim = *queues[(self + offset) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.items.empty()) {
+            item = victim.items.back();
+            victim.items.pop_back();
+            found = true;
+            steals++;
+        }
+    }
+    if (!found) return false;
+
+    (*task)(item);
+    if (remaining.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> guard(lock);
+        done.notify_all();
+    }
+    return true;
+}
+
+void WorkStealingPool::_worker(size_t self) {
+    Uint64 seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&] { return stopping || batch != seen; });
+            if (stopping) return;
+            seen = batch;
+        }
+        while (_runOne(self)) {}
+    }
+}
+
+void WorkStealingPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+    if (queues.size() == 1 || count == 1) {
+        for (size_t i = 0; i < count; i++) fn(i);
+        return;
+    }
+
+    steals = 0;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        task = &fn;
+        remaining = count;
+    }
+    // Published before any item is queued: a worker still scanning after the last batch may steal one
+    for (size_t i = 0; i < count; i++) {
+        Queue& queue = *queues[i % queues.size()];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.items.push_back(i);
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        batch++;
+    }
+    wake.notify_all();
+
+    while (_runOne(0)) {}
+
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [&] { return remaining.load() == 0; });
+    task = nullptr;
+}
+
+MatchScheduler::MatchScheduler(int tickRate, size_t threads)
+    : rate(std::max(tickRate, 1)),
+      interval(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate))),
+      pool(threads) {}
+
+bool MatchScheduler::add(const std::shared_ptr<BattleSim>& match) {
+    if (!match || match->tickRate() != rate) return false;
+    std::lock_guard<std::mutex> guard(matchesLock);
+    if (std::find(matches.begin(), matches.end(), match) != matches.end()) return false;
+    matches.push_back(match);
+    return true;
+}
+
+bool MatchScheduler::remove(const std::shared_ptr<BattleSim>& match) {
+    std::lock_guard<std::mutex> guard(matchesLock);
+    auto it = std::find(matches.begin(), matches.end(), match);
+    if (it == matches.end()) return false;
+    matches.erase(it);
+    return true;
+}
+
+size_t MatchScheduler::size() {
+    std::lock_guard<std::mutex> guard(matchesLock);
+    return matches.size();
+}
+
+void MatchScheduler::stepAll() {
+    const Clock::time_point start = Clock::now();
+    {
+        std::lock_guard<std::mutex> guard(matchesLock);
+        pool.parallelFor(matches.size(), [this](size_t i) { matches[i]->step(); });
+    }
+    lastStep = std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int MatchScheduler::waitAndStep(int maxCatchUp) {
+    if (!started) {
+        nextTick = Clock::now();
+        started = true;
+    }
+    nextTick += interval;
+    std::this_thread::sleep_until(nextTick);
+
+    // Sleep can overshoot, and a slow step can push later ticks past due
+    const Clock::time_point now = Clock::now();
+    int due = 1 + static_cast<int>((now - nextTick) / interval);
+    if (due > maxCatchUp) {
+        due = std::max(maxCatchUp, 1);
+        nextTick = now;
+    } else {
+        nextTick += interval * (due - 1);
+    }
+
+    for (int i = 0; i < due; i++) {
+        stepAll();
+    }
+    return due;
+}
@@ -0,0 +1,89 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "battle.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads for fork-join batches. Each batch is dealt round-robin into per-thread
+// queues; a thread drains its own queue from the front and steals from the back of the others once
+// it runs dry, so one slow match doesn't leave the rest of the pool idle.
+class WorkStealingPool {
+public:
+    // 0 uses one thread per core; the calling thread also works, so threads - 1 are spawned
+    explicit WorkStealingPool(size_t threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Runs task(i) for every i in [0, count) and returns once all of them have finished
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+    size_t threadCount() const { return queues.size(); }
+    size_t lastSteals() const { return steals.load(); }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<size_t> items;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues; // Index 0 belongs to the calling thread
+    std::mutex lock;
+    std::condition_variable wake, done;
+    const std::function<void(size_t)>* task = nullptr;
+    std::atomic<size_t> remaining{ 0 };
+    std::atomic<size_t> steals{ 0 };
+    Uint64 batch = 0;
+    bool stopping = false;
+
+    bool _runOne(size_t self);
+    void _worker(size_t self);
+};
+
+// Owns every running match and steps them all on one fixed timeline over a WorkStealingPool.
+// Python drives it from a single thread: waitAndStep sleeps to the next tick and steps everything
+// (without the GIL in the bindings), after which the caller syncs each match in one pass.
+class MatchScheduler {
+public:
+    MatchScheduler(int tickRate, size_t threads = 0);
+
+    // Matches must share the scheduler's tick rate; returns false otherwise or if already added
+    bool add(const std::shared_ptr<BattleSim>& match);
+    bool remove(const std::shared_ptr<BattleSim>& match);
+    size_t size();
+
+    // Sleeps until the next tick is due and steps every match once per tick that has come due, up to
+    // maxCatchUp; further missed ticks are dropped. Returns the ticks stepped.
+    int waitAndStep(int maxCatchUp = 4);
+    // Steps every match once immediately
+    void stepAll();
+
+    int tickRate() const { return rate; }
+    size_t threadCount() const { return pool.threadCount(); }
+    // Wall time of the last stepAll, for spotting a server that can't keep up
+    double lastStepSeconds() const { return lastStep; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    int rate;
+    Clock::duration interval;
+    Clock::time_point nextTick;
+    bool started = false;
+    WorkStealingPool pool;
+    std::mutex matchesLock; // Held while stepping so matches can be removed from other threads
+    std::vector<std::shared_ptr<BattleSim>> matches;
+    double lastStep = 0.0;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "spatial.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+SpatialGrid::SpatialGrid(int width, int height, int cellSize)
+    : w(std::max(width, 1)), h(std::max(height, 1)), cell(std::max(cellSize, 1)) {
+    cols = (w + cell - 1) / cell;
+    rows = (h + cell - 1) / cell;
+    cellStart.assign(static_cast<size_t>(cols) * rows + 1, 0);
+}
+
+int SpatialGrid::_cellOf(int x, int y) const {
+    // Units off the edge share the border cells
+    const int cx = std::clamp(x, 0, w - 1) / cell;
+    const int cy = std::clamp(y, 0, h - 1) / cell;
+    return cy * cols + cx;
+}
+
+void SpatialGrid::clear() {
+    units.clear();
+    dirty = true;
+}
+
+void SpatialGrid::insert(int id, int x, int y, int team, Uint32 layers) {
+    units.push_back({ id, x, y, team, layers });
+    dirty = true;
+}
+
+void SpatialGrid::build(const int* data, size_t count) {
+    units.clear();
+    for (size_t i = 0; i < count; i++) {
+        const int* row = data + 4 * i;
+        units.push_back({ static_cast<int>(i), row[0], row[1], row[2], static_cast<Uint32>(row[3]) });
+    }
+    dirty = true;
+}
+
+void SpatialGrid::_finalize() {
+    if (!dirty) return;
+    dirty = false;
+
+    // Counting sort by cell; stable, so each bucket keeps insertion order
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    for (const Unit& unit : units) {
+        cellStart[_cellOf(unit.x, unit.y) + 1]++;
+    }
+    for (size_t i = 1; i < cellStart.size(); i++) {
+        cellStart[i] += cellStart[i - 1];
+    }
+    bucketed.resize(units.size());
+    std::vector<int>& cursor = scratch;
+    cursor.assign(cellStart.begin(), cellStart.end() - 1);
+    for (const Unit& unit : units) {
+        bucketed[cursor[_cellOf(unit.x, unit.y)]++] = unit;
+    }
+}
+
+int SpatialGrid::nearest(int x, int y, int excludeTeam, Uint32 layerMask, int maxDistance) {
+    _finalize();
+    if (bucketed.empty()) return -1;
+
+    const int home = _cellOf(x, y);
+    const int hx = home % cols, hy = home / cols;
+    int best = -1, bestDistance = INT_MAX;
+
+    auto scan = [&](int cx, int cy) {
+        const int c = cy * cols + cx;
+        for (int i = cellStart[c]; i < cellStart[c + 1]; i++) {
+            const Unit& unit = bucketed[i];
+            if (!_accepts(unit, excludeTeam, layerMask)) continue;
+            const int d = std::abs(unit.x - x) + std::abs(unit.y - y);
+            if (maxDistance >= 0 && d > maxDistance) continue;
+            if (d < bestDistance || (d == bestDistance && unit.id < best)) {
+                best = unit.id;
+                bestDistance = d;
+            }
+        }
+    };
+
+    // Expand square rings of cells; everything in ring k is at least (k - 1) * cell + 1 tiles away
+    const int maxRing = std::max(cols, rows);
+    for (int k = 0; k <= maxRing; k++) {
+        if (k > 0) {
+            const int lowerBound = (k - 1) * cell + 1;
+            // Strictly less, so an equally distant unit with a lower id further out still gets seen
+            if (best != -1 && bestDistance < lowerBound) break;
+            if (maxDistance >= 0 && lowerBound > maxDistance) break;
+        }
+        const int x0 = std::max(hx - k, 0), x1 = std::min(hx + k, cols - 1);
+        const int y0 = std::max(hy - k, 0), y1 = std::min(hy + k, rows - 1);
+        for (int cy = y0; cy <= y1; cy++) {
+            const bool edgeRow = cy == hy - k || cy == hy + k;
+            for (int cx = x0; cx <= x1; cx++) {
+                if (edgeRow || cx == hx - k || cx == hx + k) {
+                    scan(cx, cy);
+                }
+            }
+        }
+    }
+    return best;
+}
+
+void SpatialGrid::queryRadius(int x, int y, int radius, int excludeTeam, Uint32 layerMask, std::vector<int>& out) {
+    out.clear();
+    _finalize();
+    if (bucketed.empty() || radius < 0) return;
+
+    const int first = _cellOf(x - radius, y - radius), last = _cellOf(x + radius, y + radius);
+    const int x0 = first % cols, y0 = first / cols, x1 = last % cols, y1 = last / cols;
+    for (int cy = y0; cy <= y1; cy++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            const int c = cy * cols + cx;
+            for (int i = cellStart[c]; i < cellStart[c + 1]; i++) {
+                const Unit& unit = bucketed[i];
+                if (_accepts(unit, excludeTeam, layerMask) && std::abs(unit.x - x) + std::abs(unit.y - y) <= radius) {
+                    out.push_back(unit.id);
+                }
+            }
+        }
+    }
+    std::sort(out.begin(), out.end());
+}
@@ -0,0 +1,48 @@
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include <SDL.h>
+#include <vector>
+
+// Uniform bucket grid over the arena for unit proximity queries. Units are inserted once per tick and
+// bucketed with a counting sort into one flat array, so a query only walks the cells it overlaps.
+// Distances are Manhattan in tiles, the metric Arena.get_target already ranks targets by.
+class SpatialGrid {
+public:
+    SpatialGrid(int width, int height, int cellSize = 4);
+
+    void clear();
+    // team is matched against a query's excludeTeam, layers against its layer mask
+    void insert(int id, int x, int y, int team, Uint32 layers);
+    // Replaces the contents with count rows of (x, y, team, layers); each unit's id is its row index
+    void build(const int* rows, size_t count);
+
+    // Closest unit not on excludeTeam (-1 excludes none) sharing a bit with layerMask, within maxDistance
+    // (-1 for unlimited). Ties go to the lowest id; returns -1 if nothing qualifies.
+    int nearest(int x, int y, int excludeTeam, Uint32 layerMask, int maxDistance);
+    // Replaces out with the ids of every qualifying unit within radius, in ascending order
+    void queryRadius(int x, int y, int radius, int excludeTeam, Uint32 layerMask, std::vector<int>& out);
+
+    size_t size() const { return units.size(); }
+
+private:
+    struct Unit {
+        int id, x, y, team;
+        Uint32 layers;
+    };
+
+    int w, h, cell, cols, rows;
+    std::vector<Unit> units;    // Insertion order
+    std::vector<Unit> bucketed; // Grouped by cell
+    std::vector<int> cellStart; // cols * rows + 1 offsets into bucketed
+    std::vector<int> scratch;   // Write cursors while bucketing
+    bool dirty = false;
+
+    int _cellOf(int x, int y) const;
+    void _finalize();
+    static bool _accepts(const Unit& unit, int excludeTeam, Uint32 layerMask) {
+        return unit.team != excludeTeam && (unit.layers & layerMask) != 0;
+    }
+};
+
+#endif
@@ -0,0 +1,166 @@
+#include "sprite_atlas.h"
+#include <algorithm>
+
+namespace {
+    constexpr int SpritePadding = 1; // Keeps linear filtering from bleeding neighbours in
+}
+
+SpriteAtlas::~SpriteAtlas() {
+    release();
+}
+
+void SpriteAtlas::release() {
+    for (Page& page : pages) {
+        if (page.texture) SDL_DestroyTexture(page.texture);
+    }
+    pages.clear();
+    sprites.clear();
+}
+
+bool SpriteAtlas::_place(Page& page, int w, int h, SDL_Rect& out) {
+    if (!page.texture || w > page.width) return false;
+    // Only commit to a new shelf if the sprite fits on it, so a miss leaves room for smaller ones
+    int x = page.penX, y = page.penY, shelf = page.shelfHeight;
+    if (x + w > page.width) {
+        x = 0;
+        y += shelf + SpritePadding;
+        shelf = 0;
+    }
+    if (y + h > page.height) return false;
+    out = { x, y, w, h };
+    page.penX = x + w + SpritePadding;
+    page.penY = y;
+    page.shelfHeight = std::max(shelf, h);
+    return true;
+}
+
+int SpriteAtlas::_openPage(SDL_Renderer* renderer, int w, int h) {
+    SDL_RendererInfo info;
+    int maxW = 0, maxH = 0;
+    if (SDL_GetRendererInfo(renderer, &info) == 0) {
+        maxW = info.max_texture_width;
+        maxH = info.max_texture_height;
+    }
+    int width = std::max(PageSize, w), height = std::max(PageSize, h);
+    if (maxW > 0) width = std::min(width, maxW);
+    if (maxH > 0) height = std::min(height, maxH);
+    if (w > width || h > height) {
+        SDL_Log("Sprite of %dx%d is larger than the renderer's %dx%d texture limit\n", w, h, width, height);
+        return -1;
+    }
+
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, width, height);
+    if (!texture) {
+        SDL_Log("Unable to create sprite atlas page! SDL Error: %s\n", SDL_GetError());
+        return -1;
+    }
+    // Static textures start undefined, and the padding between sprites must stay transparent
+    const std::vector<Uint8> blank(static_cast<size_t>(width) * height * 4, 0);
+    SDL_UpdateTexture(texture, nullptr, blank.data(), width * 4);
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    Page page;
+    page.texture = texture;
+    page.width = width;
+    page.height = height;
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (pages[i].texture == nullptr) {
+            pages[i] = page;
+            return static_cast<int>(i);
+        }
+    }
+    pages.push_back(page);
+    return static_cast<int>(pages.size() - 1);
+}
+
+int SpriteAtlas::add(SDL_Renderer* renderer, const Uint8* rgba, int w, int h, int pitch) {
+    if (!renderer || !rgba || w <= 0 || h <= 0 || pitch < w * 4) return -1;
+
+    // First fit over the open pages, so sprites loaded together tend to share one
+    int pageIndex = -1;
+    SDL_Rect src;
+    for (size_t i = 0; i < pages.size() && pageIndex < 0; i++) {
+        if (_place(pages[i], w, h, src)) pageIndex = static_cast<int>(i);
+    }
+    if (pageIndex < 0) {
+        pageIndex = _openPage(renderer, w, h);
+        if (pageIndex < 0 || !_place(pages[pageIndex], w, h, src)) return -1;
+    }
+
+    Page& page = pages[pageIndex];
+    if (SDL_UpdateTexture(page.texture, &src, rgba, pitch) != 0) {
+        SDL_Log("Unable to upload sprite to atlas page %d! SDL Error: %s\n", pageIndex, SDL_GetError());
+        return -1;
+    }
+    page.live++;
+
+    for (size_t i = 0; i < sprites.size(); i++) {
+        if (sprites[i].page < 0) {
+            sprites[i] = { pageIndex, src };
+            return static_cast<int>(i);
+        }
+    }
+    sprites.push_back({ pageIndex, src });
+    return static_cast<int>(sprites.size() - 1);
+}
+
+int SpriteAtlas::add(SDL_Renderer* renderer, SDL_Surface* surface) {
+    if (!surface) return -1;
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (!converted) {
+        SDL_Log("Unable to convert sprite surface! SDL Error: %s\n", SDL_GetError());
+        return -1;
+    }
+    SDL_LockSurface(converted);
+    const int id = add(renderer, static_cast<const Uint8*>(converted->pixels), converted->w, converted->h, converted->pitch);
+    SDL_UnlockSurface(converted);
+    SDL_FreeSurface(converted);
+    return id;
+}
+
+void SpriteAtlas::remove(int id) {
+    if (id < 0 || id >= static_cast<int>(sprites.size()) || sprites[id].page < 0) return;
+    Page& page = pages[sprites[id].page];
+    sprites[id] = Sprite();
+    // Shelves can't give back single rects, so a page is only reclaimed once it's empty
+    if (--page.live == 0) {
+        SDL_DestroyTexture(page.texture);
+        page = Page();
+    }
+}
+
+bool SpriteAtlas::lookup(int id, int* page, SDL_Rect* src) const {
+    if (id < 0 || id >= static_cast<int>(sprites.size()) || sprites[id].page < 0) return false;
+    *page = sprites[id].page;
+    *src = sprites[id].src;
+    return true;
+}
+
+bool SpriteAtlas::getSize(int id, int* w, int* h) const {
+    int page;
+    SDL_Rect src;
+    if (!lookup(id, &page, &src)) return false;
+    *w = src.w;
+    *h = src.h;
+    return true;
+}
+
+SDL_Texture* SpriteAtlas::pageTexture(int page) const {
+    return page >= 0 && page < static_cast<int>(pages.size()) ? pages[page].texture : nullptr;
+}
+
+int SpriteAtlas::pageWidth(int page) const {
+    return page >= 0 && page < static_cast<int>(pages.size()) ? pages[page].width : 0;
+}
+
+int SpriteAtlas::pageHeight(int page) const {
+    return page >= 0 && page < static_cast<int>(pages.size()) ? pages[page].height : 0;
+}
+
+size_t SpriteAtlas::pageCount() const {
+    return static_cast<size_t>(std::count_if(pages.begin(), pages.end(), [](const Page& page) { return page.texture != nullptr; }));
+}
+
+size_t SpriteAtlas::spriteCount() const {
+    return static_cast<size_t>(std::count_if(sprites.begin(), sprites.end(), [](const Sprite& sprite) { return sprite.page >= 0; }));
+}
@@ -0,0 +1,56 @@
+#ifndef SPRITE_ATLAS_H
+#define SPRITE_ATLAS_H
+
+#include <SDL.h>
+#include <vector>
+
+// Loaded images shelf-packed into shared RGBA pages, so sprites from the same page can be drawn
+// together with one texture bound. Sprites are addressed by integer id (-1 on failure); a page's
+// texture is destroyed once every sprite on it has been removed and the space is reused.
+class SpriteAtlas {
+public:
+    static constexpr int PageSize = 1024;
+
+    SpriteAtlas() = default;
+    ~SpriteAtlas();
+
+    SpriteAtlas(const SpriteAtlas&) = delete;
+    SpriteAtlas& operator=(const SpriteAtlas&) = delete;
+
+    // Copies w x h RGBA32 pixels (pitch bytes per row) into a page with room, opening one if needed
+    int add(SDL_Renderer* renderer, const Uint8* rgba, int w, int h, int pitch);
+    // Any surface format; the surface stays owned by the caller
+    int add(SDL_Renderer* renderer, SDL_Surface* surface);
+    void remove(int id);
+    void release();
+
+    bool getSize(int id, int* w, int* h) const;
+    // The page texture and pixel rect of a sprite, false if there's no such sprite
+    bool lookup(int id, int* page, SDL_Rect* src) const;
+    SDL_Texture* pageTexture(int page) const;
+    int pageWidth(int page) const;
+    int pageHeight(int page) const;
+    size_t pageCount() const;
+    size_t spriteCount() const;
+
+private:
+    struct Page {
+        SDL_Texture* texture = nullptr;
+        int width = 0, height = 0;
+        int penX = 0, penY = 0, shelfHeight = 0;
+        int live = 0;
+    };
+    struct Sprite {
+        int page = -1; // -1 for a freed slot
+        SDL_Rect src{ 0, 0, 0, 0 };
+    };
+
+    std::vector<Page> pages; // Indexed by page number, released pages have a null texture
+    std::vector<Sprite> sprites;
+
+    bool _place(Page& page, int w, int h, SDL_Rect& out);
+    // A page of at least w x h, PageSize where that fits; -1 if the renderer can't make one that big
+    int _openPage(SDL_Renderer* renderer, int w, int h);
+};
+
+#endif
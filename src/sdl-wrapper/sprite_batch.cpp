@@ -0,0 +1,84 @@
+#include "sprite_batch.h"
+#include "sprite_atlas.h"
+#include <algorithm>
+
+void SpriteBatch::submit(const int* rows, size_t count) {
+    instances.reserve(instances.size() + count);
+    for (size_t i = 0; i < count; i++) {
+        const int* row = rows + i * RowWidth;
+        auto channel = [](int v) { return static_cast<Uint8>(std::clamp(v, 0, 255)); };
+        instances.push_back({ row[0], { row[1], row[2], row[3], row[4] },
+                              { channel(row[5]), channel(row[6]), channel(row[7]), channel(row[8]) }, row[9] });
+    }
+}
+
+void SpriteBatch::clear() {
+    instances.clear();
+}
+
+void SpriteBatch::flush(SDL_Renderer* renderer, const SpriteAtlas& atlas) {
+    lastStats = SpriteBatchStats();
+    if (!renderer || instances.empty()) {
+        instances.clear();
+        return;
+    }
+
+    // Sprites are looked up now rather than at submit, so one freed in between is just skipped
+    keys.clear();
+    keys.reserve(instances.size());
+    for (size_t i = 0; i < instances.size(); i++) {
+        DrawKey key{ instances[i].layer, -1, static_cast<Uint32>(i), { 0, 0, 0, 0 } };
+        if (!atlas.lookup(instances[i].sprite, &key.page, &key.src)) {
+            lastStats.skipped++;
+            continue;
+        }
+        keys.push_back(key);
+    }
+    std::sort(keys.begin(), keys.end(), [](const DrawKey& a, const DrawKey& b) {
+        if (a.layer != b.layer) return a.layer < b.layer;
+        if (a.page != b.page) return a.page < b.page;
+        return a.index < b.index;
+    });
+
+    size_t begin = 0;
+    for (size_t i = 1; i <= keys.size(); i++) {
+        if (i == keys.size() || keys[i].layer != keys[begin].layer || keys[i].page != keys[begin].page) {
+            _drawRun(renderer, atlas, begin, i);
+            begin = i;
+        }
+    }
+    lastStats.instances = keys.size();
+    instances.clear();
+}
+
+void SpriteBatch::_drawRun(SDL_Renderer* renderer, const SpriteAtlas& atlas, size_t begin, size_t end) {
+    const int page = keys[begin].page;
+    SDL_Texture* texture = atlas.pageTexture(page);
+    const float invW = 1.0f / static_cast<float>(atlas.pageWidth(page));
+    const float invH = 1.0f / static_cast<float>(atlas.pageHeight(page));
+
+    vertices.clear();
+    indices.clear();
+    vertices.reserve((end - begin) * 4);
+    indices.reserve((end - begin) * 6);
+    for (size_t i = begin; i < end; i++) {
+        const DrawKey& key = keys[i];
+        const Instance& instance = instances[key.index];
+        const float x0 = static_cast<float>(instance.dst.x), y0 = static_cast<float>(instance.dst.y);
+        const float x1 = x0 + static_cast<float>(instance.dst.w > 0 ? instance.dst.w : key.src.w);
+        const float y1 = y0 + static_cast<float>(instance.dst.h > 0 ? instance.dst.h : key.src.h);
+        const float u0 = key.src.x * invW, v0 = key.src.y * invH;
+        const float u1 = (key.src.x + key.src.w) * invW, v1 = (key.src.y + key.src.h) * invH;
+
+        const int base = static_cast<int>(vertices.size());
+        vertices.push_back({ { x0, y0 }, instance.tint, { u0, v0 } });
+        vertices.push_back({ { x1, y0 }, instance.tint, { u1, v0 } });
+        vertices.push_back({ { x1, y1 }, instance.tint, { u1, v1 } });
+        vertices.push_back({ { x0, y1 }, instance.tint, { u0, v1 } });
+        const int quad[6] = { base, base + 1, base + 2, base, base + 2, base + 3 };
+        indices.insert(indices.end(), quad, quad + 6);
+    }
+    SDL_RenderGeometry(renderer, texture, vertices.data(), static_cast<int>(vertices.size()),
+                       indices.data(), static_cast<int>(indices.size()));
+    lastStats.drawCalls++;
+}
@@ -0,0 +1,54 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include <SDL.h>
+#include <vector>
+
+class SpriteAtlas;
+
+struct SpriteBatchStats {
+    size_t instances = 0; // Drawn by the last flush
+    size_t drawCalls = 0; // SDL_RenderGeometry calls, one per run of the same layer and page
+    size_t skipped = 0;   // Instances whose sprite had been freed
+};
+
+// Sprite instances queued for one frame and drawn as textured quads. On flush they're ordered by
+// (layer, atlas page, submission order) and each run on one page goes out as a single
+// SDL_RenderGeometry call. Lower layers draw first; within a layer instances are grouped by page,
+// so sprites that must overlap in a particular order belong in different layers.
+class SpriteBatch {
+public:
+    static constexpr size_t RowWidth = 10;
+
+    // Rows of (sprite, x, y, w, h, r, g, b, a, layer); w or h <= 0 uses the sprite's own size
+    void submit(const int* rows, size_t count);
+    void clear();
+    void flush(SDL_Renderer* renderer, const SpriteAtlas& atlas);
+
+    size_t size() const { return instances.size(); }
+    const SpriteBatchStats& stats() const { return lastStats; }
+
+private:
+    struct Instance {
+        int sprite;
+        SDL_Rect dst;
+        SDL_Color tint;
+        int layer;
+    };
+    struct DrawKey {
+        int layer;
+        int page;
+        Uint32 index; // Into instances, keeps submission order inside a run
+        SDL_Rect src;
+    };
+
+    std::vector<Instance> instances;
+    std::vector<DrawKey> keys;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+    SpriteBatchStats lastStats;
+
+    void _drawRun(SDL_Renderer* renderer, const SpriteAtlas& atlas, size_t begin, size_t end);
+};
+
+#endif
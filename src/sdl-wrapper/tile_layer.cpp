@@ -0,0 +1,174 @@
+#include "tile_layer.h"
+#include "wrapper.h"
+#include <algorithm>
+
+TileLayer::TileLayer(SDLWrapper& sdl, int columns, int rows, int cellSize)
+    : sdl(sdl), columns(std::max(columns, 1)), rows(std::max(rows, 1)), cellSize(std::max(cellSize, 1)),
+      targetResets(sdl.getTargetResets()), deviceResets(sdl.getDeviceResets()),
+      tiles(static_cast<size_t>(this->columns) * this->rows, 0), shades(this->rows, 0),
+      palette{ SDL_Color{ 0, 0, 0, 255 } }, marked(tiles.size(), 0) {}
+
+TileLayer::~TileLayer() {
+    if (target) SDL_DestroyTexture(target);
+}
+
+void TileLayer::_mark(int cell) {
+    if (allDirty || marked[cell]) return;
+    marked[cell] = 1;
+    dirty.push_back(cell);
+}
+
+void TileLayer::_markAll() {
+    allDirty = true;
+    dirty.clear();
+    std::fill(marked.begin(), marked.end(), 0);
+}
+
+void TileLayer::setPalette(const Uint8* rgb, size_t count) {
+    palette.clear();
+    for (size_t i = 0; i < count; i++) {
+        palette.push_back(SDL_Color{ rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2], 255 });
+    }
+    if (palette.empty()) palette.push_back(SDL_Color{ 0, 0, 0, 255 });
+    _markAll();
+}
+
+void TileLayer::setOutline(bool enabled, Uint8 r, Uint8 g, Uint8 b) {
+    outline = enabled;
+    outlineColor = SDL_Color{ r, g, b, 255 };
+    _markAll();
+}
+
+size_t TileLayer::setTiles(const int* values, size_t count) {
+    count = std::min(count, tiles.size());
+    size_t changed = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (tiles[i] == values[i]) continue;
+        tiles[i] = values[i];
+        _mark(static_cast<int>(i));
+        changed++;
+    }
+    return changed;
+}
+
+bool TileLayer::setTile(int x, int y, int value) {
+    if (x < 0 || y < 0 || x >= columns || y >= rows) return false;
+    const int cell = y * columns + x;
+    if (tiles[cell] != value) {
+        tiles[cell] = value;
+        _mark(cell);
+    }
+    return true;
+}
+
+size_t TileLayer::setRowShades(const int* values, size_t count) {
+    count = std::min(count, shades.size());
+    size_t changed = 0;
+    for (size_t row = 0; row < count; row++) {
+        if (shades[row] == values[row]) continue;
+        shades[row] = values[row];
+        for (int x = 0; x < columns; x++) {
+            _mark(static_cast<int>(row) * columns + x);
+        }
+        changed++;
+    }
+    return changed;
+}
+
+void TileLayer::invalidate() {
+    _markAll();
+}
+
+SDL_Color TileLayer::_color(int cell) const {
+    const int index = std::clamp(tiles[cell], 0, static_cast<int>(palette.size()) - 1);
+    SDL_Color color = palette[index];
+    const int shade = shades[cell / columns];
+    if (shade != 0) {
+        color.r = static_cast<Uint8>(std::clamp(color.r - shade, 0, 255));
+        color.g = static_cast<Uint8>(std::clamp(color.g - shade, 0, 255));
+        color.b = static_cast<Uint8>(std::clamp(color.b - shade, 0, 255));
+    }
+    return color;
+}
+
+void TileLayer::_rasterise(SDL_Renderer* renderer, int cell, int x, int y) {
+    const SDL_Rect rect{ x + (cell % columns) * cellSize, y + (cell / columns) * cellSize, cellSize, cellSize };
+    const SDL_Color color = _color(cell);
+    SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 255);
+    SDL_RenderFillRect(renderer, &rect);
+    if (outline) {
+        SDL_SetRenderDrawColor(renderer, outlineColor.r, outlineColor.g, outlineColor.b, 255);
+        SDL_RenderDrawRect(renderer, &rect);
+    }
+}
+
+void TileLayer::_rasteriseAll(SDL_Renderer* renderer, int x, int y) {
+    for (int cell = 0; cell < static_cast<int>(tiles.size()); cell++) {
+        _rasterise(renderer, cell, x, y);
+    }
+    rasterised = tiles.size();
+}
+
+void TileLayer::draw(int x, int y) {
+    SDL_Renderer* renderer = sdl.getRenderer();
+    if (!renderer) return;
+    const int width = columns * cellSize, height = rows * cellSize;
+
+    if (deviceResets != sdl.getDeviceResets()) {
+        // The texture is gone with the device; the new one may support render targets again
+        deviceResets = sdl.getDeviceResets();
+        if (target) SDL_DestroyTexture(target);
+        target = nullptr;
+        targetFailed = false;
+    }
+    if (targetResets != sdl.getTargetResets()) {
+        targetResets = sdl.getTargetResets();
+        _markAll();
+    }
+    if (!target && !targetFailed) {
+        target = sdl.createTexture(width, height);
+        targetFailed = target == nullptr;
+        // Every cell is opaque, so the copy needn't blend
+        if (target) SDL_SetTextureBlendMode(target, SDL_BLENDMODE_NONE);
+        allDirty = true;
+    }
+    if (target && (allDirty || !dirty.empty())) {
+        SDL_Texture* previous = SDL_GetRenderTarget(renderer);
+        // Switching targets drops the clip rect, e.g. the one limiting a partial redraw
+        SDL_Rect clip;
+        SDL_RenderGetClipRect(renderer, &clip);
+        const bool clipped = SDL_RenderIsClipEnabled(renderer) == SDL_TRUE;
+        if (SDL_SetRenderTarget(renderer, target) != 0) {
+            SDL_DestroyTexture(target);
+            target = nullptr;
+            targetFailed = true;
+        } else {
+            if (allDirty) {
+                _rasteriseAll(renderer, 0, 0);
+            } else {
+                for (int cell : dirty) {
+                    _rasterise(renderer, cell, 0, 0);
+                    marked[cell] = 0;
+                }
+                rasterised = dirty.size();
+            }
+            SDL_SetRenderTarget(renderer, previous);
+            SDL_RenderSetClipRect(renderer, clipped ? &clip : nullptr);
+        }
+    } else {
+        rasterised = 0;
+    }
+
+    if (target) {
+        const SDL_Rect dst{ x, y, width, height };
+        SDL_RenderCopy(renderer, target, nullptr, &dst);
+    } else {
+        // Nothing is retained, so the whole grid goes straight to the screen every time
+        _rasteriseAll(renderer, x, y);
+        std::fill(marked.begin(), marked.end(), 0);
+    }
+    // _rasterise sets the draw colour itself
+    if (rasterised) sdl.invalidateDrawColor();
+    dirty.clear();
+    allDirty = false;
+}
@@ -0,0 +1,70 @@
+#ifndef TILE_LAYER_H
+#define TILE_LAYER_H
+
+#include <SDL.h>
+#include <vector>
+
+class SDLWrapper;
+
+// A grid of palette-indexed cells kept rasterised in a render target texture. Setting tiles only marks
+// the cells whose colour actually changed; draw re-rasterises those into the texture and then copies the
+// whole layer with one SDL_RenderCopy. Without render target support every cell is drawn straight to the
+// screen each time instead. draw notices render resets through the wrapper, re-rasterising everything and,
+// after a device reset, recreating the texture.
+class TileLayer {
+public:
+    TileLayer(SDLWrapper& sdl, int columns, int rows, int cellSize);
+    ~TileLayer();
+
+    TileLayer(const TileLayer&) = delete;
+    TileLayer& operator=(const TileLayer&) = delete;
+
+    // count packed (r, g, b) entries; tile value i uses entry i, clamped into the palette
+    void setPalette(const Uint8* rgb, size_t count);
+    // The 1px border drawn inside every cell
+    void setOutline(bool enabled, Uint8 r, Uint8 g, Uint8 b);
+    // Row-major tile values, at most columns * rows; returns how many cells changed
+    size_t setTiles(const int* values, size_t count);
+    bool setTile(int x, int y, int value);
+    // Per row amounts taken off every channel (clamped at 0), e.g. to dim the opponent's half.
+    // Returns how many rows changed
+    size_t setRowShades(const int* shades, size_t count);
+    // Re-rasterises everything at the next draw
+    void invalidate();
+
+    void draw(int x, int y);
+
+    int getColumns() const { return columns; }
+    int getRows() const { return rows; }
+    int getCellSize() const { return cellSize; }
+    // Cells waiting for the next draw, and how many the last draw rasterised
+    size_t dirtyCount() const { return allDirty ? tiles.size() : dirty.size(); }
+    size_t lastRasterised() const { return rasterised; }
+    bool isRetained() const { return target != nullptr; }
+
+private:
+    SDLWrapper& sdl;
+    int columns, rows, cellSize;
+    SDL_Texture* target = nullptr;
+    bool targetFailed = false;
+    Uint32 targetResets, deviceResets; // The wrapper's counts as of the last draw
+
+    std::vector<int> tiles;
+    std::vector<int> shades; // Per row
+    std::vector<SDL_Color> palette;
+    bool outline = true;
+    SDL_Color outlineColor{ 255, 255, 255, 255 };
+
+    std::vector<int> dirty; // Cell indices, each at most once
+    std::vector<Uint8> marked;
+    bool allDirty = true;
+    size_t rasterised = 0;
+
+    void _mark(int cell);
+    void _markAll();
+    SDL_Color _color(int cell) const;
+    void _rasterise(SDL_Renderer* renderer, int cell, int x, int y);
+    void _rasteriseAll(SDL_Renderer* renderer, int x, int y);
+};
+
+#endif
@@ -0,0 +1,1352 @@
+#include "wrapper.h"
+#include "SDL_stdinc.h"
+#include <algorithm> // For batch sorting
+#include <memory>
+#include <mutex>
+#include <cmath> // For circle drawing
+#include <SDL.h>
+#include <SDL_ttf.h> // For text rendering
+#include <SDL_image.h> // For image loading (if you use it)
+#include <string>
+#include <vector>
+
+namespace {
+    // SDL_ttf keeps every face on one FreeType library, and opening or closing faces isn't thread safe
+    std::mutex fontFaces;
+}
+
+SDLWrapper::SDLWrapper(int width, int height, const std::string& title) :
+    width(width), height(height), title(title) {}
+
+SDLWrapper::~SDLWrapper() {
+    assetLoader.reset(); // Joins the loader thread and frees anything it decoded
+    frameEncoder.reset(); // Writes out any frames still queued
+    setPartialRedraw(false);
+    fonts.clear(); // Atlas, label and framebuffer textures belong to the renderer
+    for (size_t i = 0; i < framebuffers.size(); i++) {
+        freeFramebuffer(static_cast<int>(i));
+    }
+    for (size_t i = 0; i < textures.size(); i++) {
+        closeTexture(static_cast<int>(i));
+    }
+    spriteBatch.clear();
+    spriteAtlas.release();
+    labelCache.clear();
+    if (renderer) {
+        SDL_DestroyRenderer(renderer);
+    }
+    if (window) {
+        SDL_DestroyWindow(window);
+    }
+    if (headlessTarget) {
+        SDL_FreeSurface(headlessTarget);
+    }
+    TTF_Quit();
+    if (headless) {
+        // Other headless wrappers in the process may still be rendering
+        SDL_QuitSubSystem(SDL_INIT_EVENTS);
+    } else {
+        SDL_Quit();
+    }
+}
+
+bool SDLWrapper::initialize(bool headless) {
+    this->headless = headless;
+    // Events still work headless, they just never come from a window
+    if (SDL_Init(headless ? SDL_INIT_EVENTS : SDL_INIT_VIDEO) < 0) {
+        SDL_Log("SDL could not initialize! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+
+    if (TTF_Init() < 0) {
+        SDL_Log("TTF could not initialize! TTF Error: %s\n", TTF_GetError());
+        return false;
+    }
+
+    initialized = true;
+    return true;
+}
+
+void SDLWrapper::createWindow() {
+    if (!initialized) return;
+
+    window = SDL_CreateWindow(title.c_str(), SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, SDL_WINDOW_SHOWN);
+    if (window == nullptr) {
+        SDL_Log("Window could not be created! SDL Error: %s\n", SDL_GetError());
+    }
+}
+
+void SDLWrapper::createRenderer(RendererMode mode, bool vsync, bool targetTexture) {
+    if (!window) return;
+
+    Uint32 extra = 0;
+    if (vsync) extra |= SDL_RENDERER_PRESENTVSYNC;
+    if (targetTexture) extra |= SDL_RENDERER_TARGETTEXTURE;
+
+    if (mode == RendererMode::Accelerated) {
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | extra);
+        if (renderer == nullptr) {
+            SDL_Log("Accelerated renderer unavailable, falling back to software! SDL Error: %s\n", SDL_GetError());
+        }
+    }
+    if (renderer == nullptr) {
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE | extra);
+    }
+    if (renderer == nullptr) {
+        SDL_Log("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
+        return;
+    }
+
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0) {
+        rendererFlags = info.flags;
+    }
+}
+
+bool SDLWrapper::createHeadlessRenderer() {
+    if (!initialized || renderer || window) return false;
+
+    headlessTarget = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    if (headlessTarget == nullptr) {
+        SDL_Log("Headless surface could not be created! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+    renderer = SDL_CreateSoftwareRenderer(headlessTarget);
+    if (renderer == nullptr) {
+        SDL_Log("Headless renderer could not be created! SDL Error: %s\n", SDL_GetError());
+        SDL_FreeSurface(headlessTarget);
+        headlessTarget = nullptr;
+        return false;
+    }
+
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info) == 0) {
+        rendererFlags = info.flags;
+    }
+    return true;
+}
+
+bool SDLWrapper::isHeadless() const {
+    return headlessTarget != nullptr;
+}
+
+bool SDLWrapper::isAccelerated() const {
+    return (rendererFlags & SDL_RENDERER_ACCELERATED) != 0;
+}
+
+bool SDLWrapper::isVsyncEnabled() const {
+    return (rendererFlags & SDL_RENDERER_PRESENTVSYNC) != 0;
+}
+
+
+void SDLWrapper::clearScreen(Uint8 r, Uint8 g, Uint8 b) {
+    ProfileScope scope(profiler, ProfileCounter::Clear);
+    _setDrawColor(r, g, b, 255);
+    if (inFrame) {
+        // SDL_RenderClear ignores the clip rect, and the rest of the canvas is still good
+        const SDL_Rect rect = damage.frameDamage();
+        SDL_RenderFillRect(renderer, &rect);
+        return;
+    }
+    SDL_RenderClear(renderer);
+}
+
+void SDLWrapper::updateScreen() {
+    {
+        ProfileScope scope(profiler, ProfileCounter::Present);
+        if (partialRedraw && canvas) {
+            _endFrame();
+            SDL_RenderCopy(renderer, canvas, nullptr, nullptr);
+        }
+        SDL_RenderPresent(renderer);
+    }
+    profiler.endFrame();
+}
+
+void SDLWrapper::setProfiling(bool enabled, bool trace) {
+    profiler.setEnabled(enabled, trace);
+}
+
+SDL_Surface* SDLWrapper::captureFrame() {
+    if (!renderer) return nullptr;
+
+    int w = width, h = height;
+    SDL_GetRendererOutputSize(renderer, &w, &h);
+    SDL_Surface* frame = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_RGBA32);
+    if (frame == nullptr) {
+        SDL_Log("Unable to allocate a frame capture! SDL Error: %s\n", SDL_GetError());
+        return nullptr;
+    }
+    if (SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_RGBA32, frame->pixels, frame->pitch) != 0) {
+        SDL_Log("Unable to read back the frame! SDL Error: %s\n", SDL_GetError());
+        SDL_FreeSurface(frame);
+        return nullptr;
+    }
+    return frame;
+}
+
+bool SDLWrapper::saveFramePng(const std::string& path) {
+    SDL_Surface* frame = captureFrame();
+    if (frame == nullptr) return false;
+    if (!frameEncoder) {
+        frameEncoder = std::make_unique<FrameEncoder>();
+    }
+    frameEncoder->savePng(frame, path);
+    return true;
+}
+
+void SDLWrapper::waitForEncodes() {
+    if (frameEncoder) frameEncoder->wait();
+}
+
+size_t SDLWrapper::getPendingEncodes() const {
+    return frameEncoder ? frameEncoder->pending() : 0;
+}
+
+size_t SDLWrapper::getFailedEncodes() const {
+    return frameEncoder ? frameEncoder->failures() : 0;
+}
+
+void SDLWrapper::_setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+    const Uint32 color = (Uint32(r) << 24) | (Uint32(g) << 16) | (Uint32(b) << 8) | a;
+    if (!drawColorKnown || color != drawColor) {
+        profiler.count(ProfileCounter::ColorChange);
+        drawColor = color;
+        drawColorKnown = true;
+    }
+    SDL_SetRenderDrawColor(renderer, r, g, b, a);
+}
+
+bool SDLWrapper::setPartialRedraw(bool enabled) {
+    if (!enabled) {
+        _endFrame();
+        if (canvas) {
+            SDL_DestroyTexture(canvas);
+            canvas = nullptr;
+        }
+        partialRedraw = false;
+        damage.reset();
+        return true;
+    }
+    if (!renderer || !(rendererFlags & SDL_RENDERER_TARGETTEXTURE)) return false;
+    partialRedraw = true;
+    damage.invalidateAll();
+    return true;
+}
+
+bool SDLWrapper::isPartialRedraw() const {
+    return partialRedraw;
+}
+
+bool SDLWrapper::track(Uint64 key, Uint64 signature, int x, int y, int w, int h) {
+    return partialRedraw && damage.track(key, signature, SDL_Rect{ x, y, w, h });
+}
+
+void SDLWrapper::invalidateRect(int x, int y, int w, int h) {
+    damage.invalidate(SDL_Rect{ x, y, w, h });
+}
+
+void SDLWrapper::invalidateAll() {
+    damage.invalidateAll();
+}
+
+bool SDLWrapper::beginFrame() {
+    if (!partialRedraw) return true;
+    _endFrame();
+
+    int outputW = width, outputH = height;
+    SDL_GetRendererOutputSize(renderer, &outputW, &outputH);
+    if (canvasLost.exchange(false) || outputW != canvasW || outputH != canvasH) {
+        if (canvas) {
+            SDL_DestroyTexture(canvas);
+            canvas = nullptr;
+        }
+    }
+    if (!canvas) {
+        canvas = createTexture(outputW, outputH);
+        if (!canvas) {
+            SDL_Log("Unable to create the partial redraw canvas! SDL Error: %s\n", SDL_GetError());
+            setPartialRedraw(false);
+            return true;
+        }
+        SDL_SetTextureBlendMode(canvas, SDL_BLENDMODE_NONE);
+        canvasW = outputW;
+        canvasH = outputH;
+        damage.invalidateAll();
+    }
+
+    SDL_Rect clip;
+    if (!damage.beginFrame(canvasW, canvasH, clip)) return false;
+    SDL_SetRenderTarget(renderer, canvas);
+    SDL_RenderSetClipRect(renderer, &clip);
+    inFrame = true;
+    return true;
+}
+
+void SDLWrapper::_endFrame() {
+    if (!inFrame) return;
+    SDL_RenderSetClipRect(renderer, nullptr);
+    SDL_SetRenderTarget(renderer, nullptr);
+    inFrame = false;
+}
+
+bool SDLWrapper::isDirty(int x, int y, int w, int h) const {
+    return !inFrame || damage.isDamaged(SDL_Rect{ x, y, w, h });
+}
+
+SDL_Rect SDLWrapper::getFrameDamage() const {
+    if (!partialRedraw) return SDL_Rect{ 0, 0, width, height };
+    return inFrame ? damage.frameDamage() : SDL_Rect{ 0, 0, 0, 0 };
+}
+
+void SDLWrapper::drawRect(int x, int y, int w, int h, Uint8 r, Uint8 g, Uint8 b) {
+    ProfileScope scope(profiler, ProfileCounter::DrawRect);
+    _setDrawColor(r, g, b, 255);
+    SDL_Rect rect = { x, y, w, h };
+    SDL_RenderDrawRect(renderer, &rect);
+}
+
+void SDLWrapper::drawLine(int x1, int y1, int x2, int y2, Uint8 r, Uint8 g, Uint8 b) {
+    ProfileScope scope(profiler, ProfileCounter::Line);
+    _setDrawColor(r, g, b, 255);
+    SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
+}
+
+void SDLWrapper::drawPoint(int x, int y, Uint8 r, Uint8 g, Uint8 b) {
+    ProfileScope scope(profiler, ProfileCounter::Point);
+    _setDrawColor(r, g, b, 255);
+    SDL_RenderDrawPoint(renderer, x, y);
+}
+
+void SDLWrapper::drawCircle(int centerX, int centerY, int radius, Uint8 r, Uint8 g, Uint8 b) {
+    ProfileScope scope(profiler, ProfileCounter::Circle);
+    if (radius < 0) return;
+
+    // Midpoint circle: walk one octant and mirror each step into the other seven
+    circlePoints.clear();
+    circlePoints.reserve(8 * (radius + 1));
+
+    int x = radius;
+    int y = 0;
+    int err = 1 - radius;
+    while (x >= y) {
+        circlePoints.push_back({ centerX + x, centerY + y });
+        circlePoints.push_back({ centerX + y, centerY + x });
+        circlePoints.push_back({ centerX - y, centerY + x });
+        circlePoints.push_back({ centerX - x, centerY + y });
+        circlePoints.push_back({ centerX - x, centerY - y });
+        circlePoints.push_back({ centerX - y, centerY - x });
+        circlePoints.push_back({ centerX + y, centerY - x });
+        circlePoints.push_back({ centerX + x, centerY - y });
+
+        y++;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+
+    _setDrawColor(r, g, b, 255);
+    SDL_RenderDrawPoints(renderer, circlePoints.data(), static_cast<int>(circlePoints.size()));
+}
+
+void SDLWrapper::drawCircleAA(int centerX, int centerY, float radius, Uint8 r, Uint8 g, Uint8 b) {
+    ProfileScope scope(profiler, ProfileCounter::Circle);
+    if (radius <= 0.0f) return;
+
+    // Wu's circle: each column of an octant splits its coverage between the two pixels
+    // straddling the true edge. Every pixel is queued as a quad with a per-vertex alpha
+    // so the whole outline is one SDL_RenderGeometry call.
+    circleVertices.clear();
+    circleIndices.clear();
+
+    const SDL_Color color = { r, g, b, 255 };
+    const float rr = radius * radius;
+    const int end = static_cast<int>(std::ceil(radius / std::sqrt(2.0f)));
+
+    for (int x = 0; x <= end; x++) {
+        const float edge = std::sqrt(std::max(0.0f, rr - static_cast<float>(x * x)));
+        const int y = static_cast<int>(std::floor(edge));
+        if (y < x) break;
+        const float frac = edge - static_cast<float>(y);
+
+        for (int i = 0; i < 2; i++) {
+            const int yy = y + i;
+            const float coverage = i == 0 ? 1.0f - frac : frac;
+            _pushCoveragePixel(centerX + x, centerY + yy, color, coverage);
+            _pushCoveragePixel(centerX - x, centerY + yy, color, coverage);
+            _pushCoveragePixel(centerX + x, centerY - yy, color, coverage);
+            _pushCoveragePixel(centerX - x, centerY - yy, color, coverage);
+            _pushCoveragePixel(centerX + yy, centerY + x, color, coverage);
+            _pushCoveragePixel(centerX - yy, centerY + x, color, coverage);
+            _pushCoveragePixel(centerX + yy, centerY - x, color, coverage);
+            _pushCoveragePixel(centerX - yy, centerY - x, color, coverage);
+        }
+    }
+
+    if (circleIndices.empty()) return;
+
+    _renderBlended(circleVertices.data(), static_cast<int>(circleVertices.size()),
+                   circleIndices.data(), static_cast<int>(circleIndices.size()));
+}
+
+void SDLWrapper::_pushCoveragePixel(int x, int y, SDL_Color color, float coverage) {
+    if (coverage <= 0.0f) return;
+
+    color.a = static_cast<Uint8>(std::min(coverage, 1.0f) * 255.0f + 0.5f);
+    const int base = static_cast<int>(circleVertices.size());
+    const float fx = static_cast<float>(x);
+    const float fy = static_cast<float>(y);
+
+    circleVertices.push_back({ { fx, fy }, color, { 0.0f, 0.0f } });
+    circleVertices.push_back({ { fx + 1.0f, fy }, color, { 0.0f, 0.0f } });
+    circleVertices.push_back({ { fx + 1.0f, fy + 1.0f }, color, { 0.0f, 0.0f } });
+    circleVertices.push_back({ { fx, fy + 1.0f }, color, { 0.0f, 0.0f } });
+
+    circleIndices.insert(circleIndices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+}
+
+void SDLWrapper::fillCircle(int centerX, int centerY, int radius, Uint8 r, Uint8 g, Uint8 b, CircleFillMode mode) {
+    ProfileScope scope(profiler, ProfileCounter::Circle);
+    if (mode == CircleFillMode::PerPixel) {
+        for (int y = -radius; y <= radius; y++) {
+            for (int x = -radius; x <= radius; x++) {
+                if (x * x + y * y <= radius * radius) {
+                    drawPoint(centerX + x, centerY + y, r, g, b);
+                }
+            }
+        }
+        return;
+    }
+
+    if (radius < 0) return;
+
+    // One span per row covering exactly the pixels with x * x + y * y <= radius * radius.
+    // The half width only shrinks as y grows, so walking it down keeps this O(radius).
+    circleSpans.clear();
+    circleSpans.reserve(2 * radius + 1);
+
+    int halfWidth = radius;
+    for (int y = 0; y <= radius; y++) {
+        while (halfWidth * halfWidth + y * y > radius * radius) {
+            halfWidth--;
+        }
+        circleSpans.push_back({ centerX - halfWidth, centerY + y, 2 * halfWidth + 1, 1 });
+        if (y != 0) {
+            circleSpans.push_back({ centerX - halfWidth, centerY - y, 2 * halfWidth + 1, 1 });
+        }
+    }
+
+    _setDrawColor(r, g, b, 255);
+    SDL_RenderFillRects(renderer, circleSpans.data(), static_cast<int>(circleSpans.size()));
+}
+
+void SDLWrapper::drawPolygon(const std::vector<std::pair<int, int>>& points, Uint8 r, Uint8 g, Uint8 b) {
+    ProfileScope scope(profiler, ProfileCounter::Polygon);
+    if (points.size() < 2) return;
+
+    std::vector<SDL_Point> outline;
+    outline.reserve(points.size() + 1);
+    for (const auto& p : points) {
+        outline.push_back({ p.first, p.second });
+    }
+    outline.push_back(outline.front()); // Close the polygon
+
+    _setDrawColor(r, g, b, 255);
+    SDL_RenderDrawLines(renderer, outline.data(), static_cast<int>(outline.size()));
+}
+
+void SDLWrapper::fillPolygon(const std::vector<std::pair<int, int>>& points, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+    ProfileScope scope(profiler, ProfileCounter::Polygon);
+    if (points.size() < 3) return;
+
+    polygonPoints.clear();
+    for (const auto& p : points) {
+        polygonPoints.push_back({ static_cast<float>(p.first), static_cast<float>(p.second) });
+    }
+
+    polygonIndices.clear();
+    if (!triangulatePolygon(polygonPoints.data(), polygonPoints.size(), polygonIndices)) {
+        SDL_Log("fillPolygon: outline is degenerate or self-intersecting, filling what could be triangulated\n");
+    }
+    if (polygonIndices.empty()) return;
+
+    const SDL_Color color = { r, g, b, a };
+    geometryVertices.clear();
+    for (const SDL_FPoint& p : polygonPoints) {
+        geometryVertices.push_back({ p, color, { 0.0f, 0.0f } });
+    }
+    _renderBlended(geometryVertices.data(), static_cast<int>(geometryVertices.size()),
+                   polygonIndices.data(), static_cast<int>(polygonIndices.size()));
+}
+
+void SDLWrapper::drawGeometry(const float* xy, size_t vertexCount, const Uint8* rgba, const int* indices, size_t indexCount) {
+    ProfileScope scope(profiler, ProfileCounter::Geometry);
+    if (vertexCount == 0) return;
+
+    geometryVertices.resize(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++) {
+        SDL_Vertex& v = geometryVertices[i];
+        v.position = { xy[2 * i], xy[2 * i + 1] };
+        v.color = rgba ? SDL_Color{ rgba[4 * i], rgba[4 * i + 1], rgba[4 * i + 2], rgba[4 * i + 3] } : SDL_Color{ 255, 255, 255, 255 };
+        v.tex_coord = { 0.0f, 0.0f };
+    }
+    _renderBlended(geometryVertices.data(), static_cast<int>(vertexCount),
+                   indices, indices ? static_cast<int>(indexCount) : 0);
+}
+
+void SDLWrapper::_renderBlended(const SDL_Vertex* vertices, int vertexCount, const int* indices, int indexCount) {
+    SDL_BlendMode previous;
+    SDL_GetRenderDrawBlendMode(renderer, &previous);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_RenderGeometry(renderer, nullptr, vertices, vertexCount, indices, indexCount);
+    SDL_SetRenderDrawBlendMode(renderer, previous);
+    // Geometry goes around _setDrawColor, so don't trust the cached colour past it
+    invalidateDrawColor();
+}
+
+void SDLWrapper::fillRect(int x, int y, int w, int h, Uint8 r, Uint8 g, Uint8 b) {
+    ProfileScope scope(profiler, ProfileCounter::FillRect);
+    _setDrawColor(r, g, b, 255);
+    SDL_Rect rect = { x, y, w, h };
+    SDL_RenderFillRect(renderer, &rect);
+}
+
+
+void SDLWrapper::drawMesh(const float* vertices, size_t vertexCount, const int* indices, size_t triangleCount,
+                          const float* mvp, Uint8 r, Uint8 g, Uint8 b,
+                          MeshMode mode, CullMode cull, float lineWidth) {
+    ProfileScope scope(profiler, ProfileCounter::Mesh);
+    int outputW = width, outputH = height;
+    if (renderer) {
+        SDL_GetRendererOutputSize(renderer, &outputW, &outputH);
+    }
+
+    const SDL_Color color = { r, g, b, 255 };
+    meshRasterizer.build(vertices, vertexCount, indices, triangleCount, mvp,
+                         static_cast<float>(outputW), static_cast<float>(outputH),
+                         color, mode, cull, lineWidth);
+
+    const std::vector<SDL_Vertex>& out = meshRasterizer.output();
+    if (out.empty()) return;
+    SDL_RenderGeometry(renderer, nullptr, out.data(), static_cast<int>(out.size()), nullptr, 0);
+}
+
+void SDLWrapper::beginBatch() {
+    batch.clear();
+    spriteBatch.clear();
+}
+
+void SDLWrapper::submitRects(const int* rows, size_t count, bool sortByColor) {
+    _submitBatch(BatchPrimitive::FillRect, rows, count, sortByColor);
+}
+
+void SDLWrapper::submitOutlines(const int* rows, size_t count, bool sortByColor) {
+    _submitBatch(BatchPrimitive::DrawRect, rows, count, sortByColor);
+}
+
+void SDLWrapper::submitLines(const int* rows, size_t count, bool sortByColor) {
+    _submitBatch(BatchPrimitive::Line, rows, count, sortByColor);
+}
+
+void SDLWrapper::_submitBatch(BatchPrimitive kind, const int* rows, size_t count, bool sortByColor) {
+    size_t start = batch.size();
+    batch.reserve(start + count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const int* row = rows + i * 7;
+        Uint32 color = (Uint32(Uint8(row[4])) << 16) | (Uint32(Uint8(row[5])) << 8) | Uint32(Uint8(row[6]));
+        batch.push_back({ kind, color, { row[0], row[1], row[2], row[3] } });
+    }
+
+    // Only reorder inside one submission: the caller promises those primitives don't overlap,
+    // while separate submissions keep their painter's order.
+    if (sortByColor) {
+        std::stable_sort(batch.begin() + start, batch.end(), [](const BatchCommand& a, const BatchCommand& b) {
+            return a.color < b.color;
+        });
+    }
+}
+
+void SDLWrapper::flush() {
+    ProfileScope scope(profiler, ProfileCounter::BatchFlush);
+    size_t i = 0;
+    while (i < batch.size()) {
+        BatchPrimitive kind = batch[i].kind;
+        Uint32 color = batch[i].color;
+
+        size_t end = i;
+        while (end < batch.size() && batch[end].kind == kind && batch[end].color == color) {
+            ++end;
+        }
+
+        _setDrawColor((color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF, 255);
+        profiler.count(ProfileCounter::BatchCommand);
+
+        if (kind == BatchPrimitive::Line) {
+            for (size_t j = i; j < end; ++j) {
+                const SDL_Rect& l = batch[j].rect;
+                SDL_RenderDrawLine(renderer, l.x, l.y, l.w, l.h);
+            }
+        } else {
+            batchRects.clear();
+            for (size_t j = i; j < end; ++j) {
+                batchRects.push_back(batch[j].rect);
+            }
+
+            if (kind == BatchPrimitive::FillRect) {
+                SDL_RenderFillRects(renderer, batchRects.data(), static_cast<int>(batchRects.size()));
+            } else {
+                SDL_RenderDrawRects(renderer, batchRects.data(), static_cast<int>(batchRects.size()));
+            }
+        }
+
+        i = end;
+    }
+
+    batch.clear();
+    spriteBatch.flush(renderer, spriteAtlas);
+    invalidateDrawColor();
+    const SpriteBatchStats& sprites = spriteBatch.stats();
+    profiler.count(ProfileCounter::SpriteInstance, static_cast<Uint32>(sprites.instances));
+    profiler.count(ProfileCounter::SpriteDrawCall, static_cast<Uint32>(sprites.drawCalls));
+}
+
+
+SDL_Texture* SDLWrapper::loadTexture(const std::string& path) {
+    SDL_Texture* texture = nullptr;
+    SDL_Surface* loadedSurface = IMG_Load(path.c_str()); // Requires SDL_image
+    if (loadedSurface == nullptr) {
+        SDL_Log("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+    } else {
+        texture = SDL_CreateTextureFromSurface(renderer, loadedSurface);
+        if (texture == nullptr) {
+            SDL_Log("Unable to create texture from %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+        } else {
+            profiler.count(ProfileCounter::TextureUpload);
+        }
+        SDL_FreeSurface(loadedSurface);
+    }
+    return texture;
+}
+
+SDL_Texture* SDLWrapper::createTextureFromSurface(SDL_Surface* surface) {
+    return SDL_CreateTextureFromSurface(renderer, surface);
+}
+
+SDL_Texture* SDLWrapper::createTexture(int width, int height) {
+    return SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+}
+
+void SDLWrapper::freeTexture(SDL_Texture* texture) {
+    if (texture) {
+        SDL_DestroyTexture(texture);
+    }
+}
+
+void SDLWrapper::setTextureBlendMode(SDL_Texture* texture, SDL_BlendMode blendMode) {
+    SDL_SetTextureBlendMode(texture, blendMode);
+}
+
+void SDLWrapper::setTextureAlphaMod(SDL_Texture* texture, Uint8 alpha) {
+    SDL_SetTextureAlphaMod(texture, alpha);
+}
+
+void SDLWrapper::setTextureColorMod(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b) {
+    SDL_SetTextureColorMod(texture, r, g, b);
+}
+
+void SDLWrapper::drawTexture(SDL_Texture* texture, int x, int y) {
+    ProfileScope scope(profiler, ProfileCounter::Texture);
+    SDL_Rect dstRect = { x, y, 0, 0 };
+    SDL_QueryTexture(texture, nullptr, nullptr, &dstRect.w, &dstRect.h); // Get texture dimensions
+    SDL_RenderCopy(renderer, texture, nullptr, &dstRect);
+}
+
+void SDLWrapper::drawTexture(SDL_Texture* texture, SDL_Rect* srcRect, SDL_Rect* dstRect) {
+    ProfileScope scope(profiler, ProfileCounter::Texture);
+    SDL_RenderCopy(renderer, texture, srcRect, dstRect);
+}
+
+int SDLWrapper::createFramebuffer(int w, int h) {
+    if (!renderer || w <= 0 || h <= 0) return -1;
+
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, w, h);
+    if (texture == nullptr) {
+        SDL_Log("Unable to create framebuffer texture! SDL Error: %s\n", SDL_GetError());
+        return -1;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    // Reuse a freed slot so long-running callers don't grow the table
+    for (size_t i = 0; i < framebuffers.size(); i++) {
+        if (framebuffers[i].texture == nullptr) {
+            framebuffers[i] = { texture, w, h, false };
+            return static_cast<int>(i);
+        }
+    }
+    framebuffers.push_back({ texture, w, h, false });
+    return static_cast<int>(framebuffers.size() - 1);
+}
+
+SDLWrapper::Framebuffer* SDLWrapper::_framebuffer(int id) {
+    if (id < 0 || id >= static_cast<int>(framebuffers.size()) || framebuffers[id].texture == nullptr) {
+        return nullptr;
+    }
+    return &framebuffers[id];
+}
+
+bool SDLWrapper::lockFramebuffer(int id, void** pixels, int* pitch) {
+    Framebuffer* fb = _framebuffer(id);
+    if (!fb) return false;
+    if (fb->locked) {
+        SDL_UnlockTexture(fb->texture);
+        fb->locked = false;
+    }
+    if (SDL_LockTexture(fb->texture, nullptr, pixels, pitch) != 0) {
+        SDL_Log("Unable to lock framebuffer %d! SDL Error: %s\n", id, SDL_GetError());
+        return false;
+    }
+    fb->locked = true;
+    return true;
+}
+
+void SDLWrapper::unlockFramebuffer(int id) {
+    Framebuffer* fb = _framebuffer(id);
+    if (fb && fb->locked) {
+        SDL_UnlockTexture(fb->texture);
+        fb->locked = false;
+        profiler.count(ProfileCounter::TextureUpload);
+    }
+}
+
+void SDLWrapper::drawFramebuffer(int id, int x, int y, int w, int h) {
+    ProfileScope scope(profiler, ProfileCounter::Texture);
+    Framebuffer* fb = _framebuffer(id);
+    if (!fb) {
+        SDL_Log("Cannot draw framebuffer %d: no such framebuffer!\n", id);
+        return;
+    }
+    unlockFramebuffer(id); // Uploads any pending writes
+    SDL_Rect dstRect = { x, y, w < 0 ? fb->w : w, h < 0 ? fb->h : h };
+    SDL_RenderCopy(renderer, fb->texture, nullptr, &dstRect);
+}
+
+void SDLWrapper::freeFramebuffer(int id) {
+    Framebuffer* fb = _framebuffer(id);
+    if (!fb) return;
+    unlockFramebuffer(id);
+    SDL_DestroyTexture(fb->texture);
+    *fb = Framebuffer();
+}
+
+bool SDLWrapper::getFramebufferSize(int id, int* w, int* h) {
+    Framebuffer* fb = _framebuffer(id);
+    if (!fb) return false;
+    *w = fb->w;
+    *h = fb->h;
+    return true;
+}
+
+int SDLWrapper::openTexture(const std::string& path) {
+    SDL_Texture* texture = loadTexture(path);
+    return texture ? _addTexture(texture) : -1;
+}
+
+int SDLWrapper::_addTexture(SDL_Texture* texture) {
+    TextureEntry entry{ texture, 0, 0 };
+    SDL_QueryTexture(texture, nullptr, nullptr, &entry.w, &entry.h);
+
+    for (size_t i = 0; i < textures.size(); i++) {
+        if (textures[i].texture == nullptr) {
+            textures[i] = entry;
+            return static_cast<int>(i);
+        }
+    }
+    textures.push_back(entry);
+    return static_cast<int>(textures.size() - 1);
+}
+
+SDLWrapper::TextureEntry* SDLWrapper::_texture(int id) {
+    if (id < 0 || id >= static_cast<int>(textures.size()) || textures[id].texture == nullptr) {
+        return nullptr;
+    }
+    return &textures[id];
+}
+
+void SDLWrapper::closeTexture(int id) {
+    TextureEntry* entry = _texture(id);
+    if (!entry) return;
+    SDL_DestroyTexture(entry->texture);
+    *entry = TextureEntry();
+}
+
+bool SDLWrapper::getTextureSize(int id, int* w, int* h) {
+    TextureEntry* entry = _texture(id);
+    if (!entry) return false;
+    *w = entry->w;
+    *h = entry->h;
+    return true;
+}
+
+void SDLWrapper::drawTexture(int id, int x, int y, int w, int h) {
+    ProfileScope scope(profiler, ProfileCounter::Texture);
+    TextureEntry* entry = _texture(id);
+    if (!entry) {
+        SDL_Log("Cannot draw texture %d: no such texture!\n", id);
+        return;
+    }
+    SDL_Rect dstRect = { x, y, w < 0 ? entry->w : w, h < 0 ? entry->h : h };
+    SDL_RenderCopy(renderer, entry->texture, nullptr, &dstRect);
+}
+
+void SDLWrapper::drawTextureRegion(int id, const SDL_Rect& src, const SDL_Rect& dst) {
+    ProfileScope scope(profiler, ProfileCounter::Texture);
+    TextureEntry* entry = _texture(id);
+    if (!entry) {
+        SDL_Log("Cannot draw texture %d: no such texture!\n", id);
+        return;
+    }
+    SDL_RenderCopy(renderer, entry->texture, &src, &dst);
+}
+
+void SDLWrapper::setTextureBlendMode(int id, SDL_BlendMode blendMode) {
+    if (TextureEntry* entry = _texture(id)) SDL_SetTextureBlendMode(entry->texture, blendMode);
+}
+
+void SDLWrapper::setTextureAlphaMod(int id, Uint8 alpha) {
+    if (TextureEntry* entry = _texture(id)) SDL_SetTextureAlphaMod(entry->texture, alpha);
+}
+
+void SDLWrapper::setTextureColorMod(int id, Uint8 r, Uint8 g, Uint8 b) {
+    if (TextureEntry* entry = _texture(id)) SDL_SetTextureColorMod(entry->texture, r, g, b);
+}
+
+int SDLWrapper::loadSprite(const std::string& path) {
+    SDL_Surface* surface = IMG_Load(path.c_str());
+    if (surface == nullptr) {
+        SDL_Log("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+        return -1;
+    }
+    const int id = spriteAtlas.add(renderer, surface);
+    SDL_FreeSurface(surface);
+    if (id >= 0) profiler.count(ProfileCounter::TextureUpload);
+    return id;
+}
+
+int SDLWrapper::createSprite(const Uint8* rgba, int w, int h) {
+    const int id = spriteAtlas.add(renderer, rgba, w, h, w * 4);
+    if (id >= 0) profiler.count(ProfileCounter::TextureUpload);
+    return id;
+}
+
+void SDLWrapper::freeSprite(int id) {
+    spriteAtlas.remove(id);
+}
+
+bool SDLWrapper::getSpriteSize(int id, int* w, int* h) const {
+    return spriteAtlas.getSize(id, w, h);
+}
+
+size_t SDLWrapper::getSpritePageCount() const {
+    return spriteAtlas.pageCount();
+}
+
+void SDLWrapper::submitSprites(const int* rows, size_t count) {
+    spriteBatch.submit(rows, count);
+}
+
+SpriteBatchStats SDLWrapper::getSpriteStats() const {
+    return spriteBatch.stats();
+}
+
+AssetLoader& SDLWrapper::_assets() {
+    if (!assetLoader) {
+        assetLoader = std::make_unique<AssetLoader>();
+    }
+    return *assetLoader;
+}
+
+int SDLWrapper::loadTextureAsync(const std::string& path) {
+    return _assets().request([this, path]() -> AssetLoader::Upload {
+        SDL_Surface* loaded = IMG_Load(path.c_str());
+        if (loaded == nullptr) {
+            SDL_Log("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+            return nullptr;
+        }
+        // std::function needs a copyable closure, and the surface must be freed even if never uploaded
+        std::shared_ptr<SDL_Surface> surface(loaded, SDL_FreeSurface);
+        return [this, surface, path]() {
+            SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface.get());
+            if (texture == nullptr) {
+                SDL_Log("Unable to create texture from %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+                return -1;
+            }
+            profiler.count(ProfileCounter::TextureUpload);
+            return _addTexture(texture);
+        };
+    });
+}
+
+int SDLWrapper::loadSpriteAsync(const std::string& path) {
+    return _assets().request([this, path]() -> AssetLoader::Upload {
+        SDL_Surface* loaded = IMG_Load(path.c_str());
+        if (loaded == nullptr) {
+            SDL_Log("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+            return nullptr;
+        }
+        // Converted here too, so the render thread only copies pixels into the atlas page
+        SDL_Surface* converted = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_FreeSurface(loaded);
+        if (converted == nullptr) {
+            SDL_Log("Unable to convert sprite %s! SDL Error: %s\n", path.c_str(), SDL_GetError());
+            return nullptr;
+        }
+        std::shared_ptr<SDL_Surface> surface(converted, SDL_FreeSurface);
+        return [this, surface]() {
+            const int id = spriteAtlas.add(renderer, static_cast<const Uint8*>(surface->pixels), surface->w, surface->h, surface->pitch);
+            if (id >= 0) profiler.count(ProfileCounter::TextureUpload);
+            return id;
+        };
+    });
+}
+
+int SDLWrapper::openFontAsync(const std::string& path, int size) {
+    auto existing = fontIds.find({ path, size });
+    if (existing != fontIds.end()) {
+        return _assets().resolved(existing->second);
+    }
+
+    return _assets().request([this, path, size]() -> AssetLoader::Upload {
+        TTF_Font* opened;
+        {
+            std::lock_guard<std::mutex> guard(fontFaces);
+            opened = TTF_OpenFont(path.c_str(), size);
+        }
+        if (opened == nullptr) {
+            SDL_Log("Failed to load font '%s' (size %d)! TTF Error: %s\n", path.c_str(), size, TTF_GetError());
+            return nullptr;
+        }
+        auto entry = std::make_shared<std::unique_ptr<FontEntry>>(std::make_unique<FontEntry>());
+        (*entry)->path = path;
+        (*entry)->size = size;
+        (*entry)->font = opened;
+        (*entry)->atlas.prepare(opened); // The slow part of opening a font
+
+        return [this, entry]() {
+            FontEntry& font = **entry;
+            // Opened synchronously while this one was decoding; the spare closes with the closure
+            auto existing = fontIds.find({ font.path, font.size });
+            if (existing != fontIds.end()) {
+                return existing->second;
+            }
+            if (renderer) {
+                _ensureTextAtlas(font);
+            }
+
+            const int id = static_cast<int>(fonts.size());
+            fontIds[{ font.path, font.size }] = id;
+            fonts.push_back(std::move(*entry));
+            return id;
+        };
+    });
+}
+
+size_t SDLWrapper::uploadAssets(double budgetMs) {
+    ProfileScope scope(profiler, ProfileCounter::AssetUpload);
+    return assetLoader ? assetLoader->upload(budgetMs / 1000.0) : 0;
+}
+
+AssetState SDLWrapper::getAssetState(int request) const {
+    return assetLoader ? assetLoader->state(request) : AssetState::Failed;
+}
+
+int SDLWrapper::getAssetId(int request) const {
+    return assetLoader ? assetLoader->id(request) : -1;
+}
+
+size_t SDLWrapper::getPendingAssets() const {
+    return assetLoader ? assetLoader->pending() : 0;
+}
+
+SDLWrapper::FontEntry::~FontEntry() {
+    atlas.release();
+    if (font) {
+        std::lock_guard<std::mutex> guard(fontFaces);
+        TTF_CloseFont(font);
+    }
+}
+
+int SDLWrapper::openFont(const std::string& path, int size) {
+    auto existing = fontIds.find({ path, size });
+    if (existing != fontIds.end()) {
+        return existing->second;
+    }
+
+    TTF_Font* opened;
+    {
+        std::lock_guard<std::mutex> guard(fontFaces);
+        opened = TTF_OpenFont(path.c_str(), size);
+    }
+    if (opened == nullptr) {
+        SDL_Log("Failed to load font '%s' (size %d)! TTF Error: %s\n", path.c_str(), size, TTF_GetError());
+        return -1;
+    }
+
+    auto entry = std::make_unique<FontEntry>();
+    entry->path = path;
+    entry->size = size;
+    entry->font = opened;
+    // Fonts opened before createRenderer get their atlas on first draw instead
+    if (renderer) {
+        entry->atlas.build(renderer, opened);
+    }
+
+    // Ids are never reused, so cached labels of a closed font can't match a new one
+    const int id = static_cast<int>(fonts.size());
+    fonts.push_back(std::move(entry));
+    fontIds[{ path, size }] = id;
+    return id;
+}
+
+void SDLWrapper::closeFont(int id) {
+    FontEntry* entry = _font(id);
+    if (!entry) return;
+
+    fontIds.erase({ entry->path, entry->size });
+    fonts[id].reset();
+    if (currentFont == id) {
+        currentFont = -1;
+    }
+}
+
+bool SDLWrapper::setFont(int id) {
+    if (!_font(id)) {
+        SDL_Log("Cannot select font %d: no such font!\n", id);
+        return false;
+    }
+    currentFont = id;
+    return true;
+}
+
+int SDLWrapper::getFont() const {
+    return currentFont;
+}
+
+bool SDLWrapper::loadFont(const std::string& path, int size) {
+    const int id = openFont(path, size);
+    return id >= 0 && setFont(id);
+}
+
+SDLWrapper::FontEntry* SDLWrapper::_font(int id) {
+    if (id < 0 || id >= static_cast<int>(fonts.size())) {
+        return nullptr;
+    }
+    return fonts[id].get();
+}
+
+bool SDLWrapper::_ensureTextAtlas(FontEntry& entry) {
+    if (entry.atlas.isBuiltFor(entry.font)) {
+        return true;
+    }
+    // Fonts from the loader thread arrive with their glyphs already rasterised
+    if (entry.atlas.isPreparedFor(entry.font) && entry.atlas.upload(renderer)) {
+        profiler.count(ProfileCounter::TextureUpload);
+        return true;
+    }
+    if (!entry.atlas.build(renderer, entry.font)) return false;
+    profiler.count(ProfileCounter::TextureUpload);
+    return true;
+}
+
+void SDLWrapper::drawText(int fontId, const std::string& text, int x, int y, SDL_Color color) {
+    ProfileScope scope(profiler, ProfileCounter::Text);
+    FontEntry* entry = _font(fontId);
+    if (entry == nullptr) {
+        SDL_Log("Cannot draw text: Font not loaded!\n");
+        return;
+    }
+
+    if (entry->atlas.covers(text) && _ensureTextAtlas(*entry)) {
+        entry->atlas.draw(renderer, text, x, y, color);
+        return;
+    }
+
+    // Characters outside the atlas go through the per-call rasteriser
+    SDL_Surface* textSurface = TTF_RenderText_Solid(entry->font, text.c_str(), color);
+    if (textSurface == nullptr) {
+        SDL_Log("Unable to render text surface!  TTF Error: %s\n", TTF_GetError());
+        return;
+    }
+    profiler.count(ProfileCounter::TextRaster);
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, textSurface);
+    if (texture == nullptr) {
+        SDL_Log("Unable to create texture from rendered text! SDL Error: %s\n", SDL_GetError());
+    } else {
+        profiler.count(ProfileCounter::TextureUpload);
+        SDL_Rect dstRect = { x, y, textSurface->w, textSurface->h };
+        SDL_RenderCopy(renderer, texture, nullptr, &dstRect);
+        SDL_DestroyTexture(texture);
+    }
+
+    SDL_FreeSurface(textSurface);
+}
+
+void SDLWrapper::drawText(int fontId, const std::string& text, int x, int y, Uint8 r, Uint8 g, Uint8 b) {
+    SDL_Color color = { r, g, b, 255 };
+    drawText(fontId, text, x, y, color);
+}
+
+void SDLWrapper::drawText(const std::string& text, int x, int y, SDL_Color color) {
+    drawText(currentFont, text, x, y, color);
+}
+
+void SDLWrapper::drawText(const std::string& text, int x, int y, Uint8 r, Uint8 g, Uint8 b) {
+    SDL_Color color = { r, g, b, 255 };
+    drawText(currentFont, text, x, y, color);
+}
+
+
+SDL_Rect SDLWrapper::getTextSize(int fontId, const std::string& text) {
+    SDL_Rect rect = {0, 0, 0, 0};
+    FontEntry* entry = _font(fontId);
+    if (entry) {
+        if (entry->atlas.covers(text) && _ensureTextAtlas(*entry)) {
+            return entry->atlas.measure(text);
+        }
+        TTF_SizeText(entry->font, text.c_str(), &rect.w, &rect.h);
+    } else {
+        SDL_Log("Cannot get text size: Font not loaded!\n");
+    }
+    return rect;
+}
+
+SDL_Rect SDLWrapper::getTextSize(const std::string& text) {
+    return getTextSize(currentFont, text);
+}
+
+void SDLWrapper::drawLabel(int fontId, const std::string& text, int x, int y, Uint8 r, Uint8 g, Uint8 b) {
+    ProfileScope scope(profiler, ProfileCounter::Label);
+    FontEntry* entry = _font(fontId);
+    if (entry == nullptr) {
+        SDL_Log("Cannot draw label: Font not loaded!\n");
+        return;
+    }
+    if (text.empty()) return;
+
+    const LabelKey key = { static_cast<Uint32>(fontId), entry->size, (Uint32(r) << 24) | (Uint32(g) << 16) | (Uint32(b) << 8) | 0xFF, text };
+    int w = 0, h = 0;
+    SDL_Texture* texture = labelCache.find(key, w, h);
+
+    if (texture == nullptr) {
+        SDL_Color color = { r, g, b, 255 };
+        SDL_Surface* surface = TTF_RenderUTF8_Blended(entry->font, text.c_str(), color);
+        if (surface == nullptr) {
+            SDL_Log("Unable to render label surface!  TTF Error: %s\n", TTF_GetError());
+            return;
+        }
+        profiler.count(ProfileCounter::TextRaster);
+        texture = SDL_CreateTextureFromSurface(renderer, surface);
+        w = surface->w;
+        h = surface->h;
+        SDL_FreeSurface(surface);
+        if (texture == nullptr) {
+            SDL_Log("Unable to create texture from rendered label! SDL Error: %s\n", SDL_GetError());
+            return;
+        }
+        profiler.count(ProfileCounter::TextureUpload);
+        labelCache.insert(key, texture, w, h);
+    }
+
+    SDL_Rect dstRect = { x, y, w, h };
+    SDL_RenderCopy(renderer, texture, nullptr, &dstRect);
+}
+
+void SDLWrapper::drawLabel(const std::string& text, int x, int y, Uint8 r, Uint8 g, Uint8 b) {
+    drawLabel(currentFont, text, x, y, r, g, b);
+}
+
+void SDLWrapper::setLabelCacheBudget(size_t bytes) {
+    labelCache.setBudget(bytes);
+}
+
+void SDLWrapper::clearLabelCache() {
+    labelCache.clear();
+}
+
+LabelCacheStats SDLWrapper::getLabelCacheStats() const {
+    return labelCache.stats();
+}
+
+bool SDLWrapper::pollEvent(SDL_Event& event) {
+    if (SDL_PollEvent(&event) == 0) return false;
+    _noteEvent(event);
+    return true;
+}
+
+void SDLWrapper::_noteEvent(const SDL_Event& event) {
+    // Called by pollEvent and pollEvents on the main thread, the one that pumps events and renders
+    if (event.type == SDL_RENDER_DEVICE_RESET) {
+        canvasLost.store(true);
+        targetResets++;
+        deviceResets++;
+        damage.invalidateAll();
+    } else if (event.type == SDL_RENDER_TARGETS_RESET) {
+        targetResets++;
+        damage.invalidateAll();
+    } else if (event.type == SDL_WINDOWEVENT) {
+        switch (event.window.event) {
+        case SDL_WINDOWEVENT_EXPOSED:
+        case SDL_WINDOWEVENT_SHOWN:
+        case SDL_WINDOWEVENT_RESTORED:
+        case SDL_WINDOWEVENT_SIZE_CHANGED:
+            damage.invalidateAll();
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static EventRecord toEventRecord(const SDL_Event& event) {
+    EventRecord record = {};
+    record.type = event.type;
+    record.timestamp = event.common.timestamp;
+
+    switch (event.type) {
+    case SDL_KEYDOWN:
+    case SDL_KEYUP:
+        record.scancode = event.key.keysym.scancode;
+        record.keycode = event.key.keysym.sym;
+        record.mod = event.key.keysym.mod;
+        record.repeat = event.key.repeat;
+        break;
+    case SDL_MOUSEMOTION:
+        record.x = event.motion.x;
+        record.y = event.motion.y;
+        record.xrel = event.motion.xrel;
+        record.yrel = event.motion.yrel;
+        break;
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+        record.button = event.button.button;
+        record.x = event.button.x;
+        record.y = event.button.y;
+        break;
+    case SDL_MOUSEWHEEL:
+        record.x = event.wheel.x;
+        record.y = event.wheel.y;
+        break;
+    case SDL_WINDOWEVENT:
+        record.window = event.window.event;
+        record.x = event.window.data1;
+        record.y = event.window.data2;
+        break;
+    default:
+        break;
+    }
+    return record;
+}
+
+size_t SDLWrapper::pollEvents(EventRecord* out, size_t max, int timeoutMs) {
+    if (max == 0) return 0;
+
+    size_t count = 0;
+    SDL_Event event;
+    if (timeoutMs > 0) {
+        if (!SDL_WaitEventTimeout(&event, timeoutMs)) {
+            return 0;
+        }
+        _noteEvent(event);
+        out[count++] = toEventRecord(event);
+    }
+    while (count < max && SDL_PollEvent(&event)) {
+        _noteEvent(event);
+        out[count++] = toEventRecord(event);
+    }
+    return count;
+}
+
+Uint32 SDLWrapper::getTicks() {
+    return SDL_GetTicks();
+}
+
+void SDLWrapper::delay(Uint32 ms) {
+    SDL_Delay(ms);
+}
+
+void SDLWrapper::setTargetFps(int fps) {
+    frameBudget = fps > 0 ? SDL_GetPerformanceFrequency() / static_cast<Uint64>(fps) : 0;
+}
+
+double SDLWrapper::paceFrame() {
+    ProfileScope scope(profiler, ProfileCounter::Sleep);
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 previous = lastFrame;
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    if (previous != 0 && frameBudget != 0) {
+        const Uint64 deadline = previous + frameBudget;
+        // SDL_Delay can overshoot by a scheduler quantum, so sleep to within ~1ms and spin the rest
+        const Uint64 slack = frequency / 1000;
+        while (now < deadline) {
+            const Uint64 remaining = deadline - now;
+            if (remaining > 2 * slack) {
+                SDL_Delay(static_cast<Uint32>((remaining - slack) * 1000 / frequency));
+            }
+            now = SDL_GetPerformanceCounter();
+        }
+    }
+
+    lastFrame = now;
+    return previous != 0 ? static_cast<double>(now - previous) / static_cast<double>(frequency) : 0.0;
+}
+
+const Uint8* SDLWrapper::getKeyboardState(int* numkeys) {
+    return SDL_GetKeyboardState(numkeys);
+}
+
+bool SDLWrapper::isKeyPressed(SDL_Scancode key) {
+    int numkeys;
+    const Uint8* keyboardState = SDL_GetKeyboardState(&numkeys);
+    if (keyboardState) {
+        return keyboardState[key];
+    }
+    return false;
+}
+
+SDL_Renderer* SDLWrapper::getRenderer() const {
+    return renderer;
+}
+
+int SDLWrapper::getWidth() const {
+    return width;
+}
+
+int SDLWrapper::getHeight() const {
+    return height;
+}
+
+std::tuple<int, int> SDLWrapper::getMousePosition() {
+    int mouseX, mouseY;
+    SDL_GetMouseState(&mouseX, &mouseY);
+
+    int x = mouseX;
+    int y = mouseY;
+
+    return std::make_tuple(x, y); // Return the tuple
+}
+
+bool SDLWrapper::isMouseButtonDown(Uint8 button) {
+    return SDL_GetMouseState(nullptr, nullptr) & SDL_BUTTON(button);
+}
+
+bool SDLWrapper::isWindowFocused() {
+    if (!window) return false;
+    Uint32 flags = SDL_GetWindowFlags(window);
+    return (flags & SDL_WINDOW_INPUT_FOCUS) != 0;
+}
+
@@ -0,0 +1,332 @@
+#ifndef SDL_WRAPPER_H
+#define SDL_WRAPPER_H
+
+#include <SDL.h>
+#include <SDL_ttf.h> // Include for text rendering
+#include "asset_loader.h"
+#include "damage_tracker.h"
+#include "frame_encoder.h"
+#include "frame_profiler.h"
+#include "glyph_atlas.h"
+#include "label_cache.h"
+#include "geometry.h"
+#include "mesh.h"
+#include "sprite_atlas.h"
+#include "sprite_batch.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class BatchPrimitive : Uint8 {
+    FillRect,
+    DrawRect,
+    Line
+};
+
+// How fillCircle rasterises: one span per row, or the legacy one point per pixel
+enum class CircleFillMode {
+    Scanline,
+    PerPixel
+};
+
+// Which backend createRenderer asks for. Accelerated falls back to software if unavailable.
+enum class RendererMode {
+    Software,
+    Accelerated
+};
+
+struct BatchCommand {
+    BatchPrimitive kind;
+    Uint32 color; // Packed 0xRRGGBB
+    SDL_Rect rect; // For lines: x1, y1, x2, y2
+};
+
+// Flat, fixed-size view of the SDL_Event fields the engine reads, so a whole queue drains into one array
+struct EventRecord {
+    Uint32 type;
+    Uint32 timestamp;
+    Sint32 scancode; // Key events
+    Sint32 keycode;
+    Uint16 mod;
+    Uint8 repeat;
+    Uint8 button;    // Mouse button events
+    Sint32 x, y;     // Mouse position, wheel amount, or window event data
+    Sint32 xrel, yrel;
+    Uint32 window;   // SDL_WindowEventID for window events
+};
+
+// Not thread-safe: every call, like SDL's own video and render calls, belongs on the thread that made the window
+class SDLWrapper {
+public:
+    SDLWrapper(int width, int height, const std::string& title);
+    ~SDLWrapper();
+
+    // Headless skips the video subsystem, so it works without a display server; render with
+    // createHeadlessRenderer instead of createWindow and createRenderer
+    bool initialize(bool headless = false);
+    void createWindow();
+    void createRenderer(RendererMode mode = RendererMode::Accelerated, bool vsync = false, bool targetTexture = true);
+    // A software renderer drawing into a width x height RGBA32 surface, with no window
+    bool createHeadlessRenderer();
+    bool isHeadless() const;
+    bool isAccelerated() const;
+    bool isVsyncEnabled() const;
+    void clearScreen(Uint8 r, Uint8 g, Uint8 b);
+    void updateScreen();
+    void drawRect(int x, int y, int w, int h, Uint8 r, Uint8 g, Uint8 b);
+
+    // Drawing functions
+    void drawLine(int x1, int y1, int x2, int y2, Uint8 r, Uint8 g, Uint8 b);
+    void drawPoint(int x, int y, Uint8 r, Uint8 g, Uint8 b);
+    void drawCircle(int centerX, int centerY, int radius, Uint8 r, Uint8 g, Uint8 b);
+    void drawCircleAA(int centerX, int centerY, float radius, Uint8 r, Uint8 g, Uint8 b);
+    void fillCircle(int centerX, int centerY, int radius, Uint8 r, Uint8 g, Uint8 b, CircleFillMode mode = CircleFillMode::Scanline);
+    void drawPolygon(const std::vector<std::pair<int, int>>& points, Uint8 r, Uint8 g, Uint8 b);
+    void fillPolygon(const std::vector<std::pair<int, int>>& points, Uint8 r, Uint8 g, Uint8 b, Uint8 a = 255);
+    // Raw triangle submission: xy holds vertexCount (x, y) pairs, rgba vertexCount colours (or null for
+    // opaque white), indices indexCount entries (or null to take vertices three at a time).
+    void drawGeometry(const float* xy, size_t vertexCount, const Uint8* rgba, const int* indices, size_t indexCount);
+    void fillRect(int x, int y, int w, int h, Uint8 r, Uint8 g, Uint8 b);
+    void drawTexture(SDL_Texture* texture, int x, int y);
+    void drawTexture(SDL_Texture* texture, SDL_Rect* srcRect, SDL_Rect* dstRect);
+
+    // Draws an indexed triangle mesh: vertices are vertexCount x (x, y, z), indices triangleCount x 3,
+    // and mvp a row-major 4x4 model-view-projection matrix. Submitted as one SDL_RenderGeometry call.
+    void drawMesh(const float* vertices, size_t vertexCount, const int* indices, size_t triangleCount,
+                  const float* mvp, Uint8 r, Uint8 g, Uint8 b,
+                  MeshMode mode = MeshMode::Wireframe, CullMode cull = CullMode::None, float lineWidth = 1.0f);
+
+    // Batched drawing. Rows are packed as (x, y, w, h, r, g, b); lines use (x1, y1, x2, y2, r, g, b).
+    // Commands are queued until flush() and replayed with one colour change per run of equal colours.
+    // Sprites submitted to the batch are drawn after the primitives, see submitSprites.
+    void beginBatch();
+    void submitRects(const int* rows, size_t count, bool sortByColor = false);
+    void submitOutlines(const int* rows, size_t count, bool sortByColor = false);
+    void submitLines(const int* rows, size_t count, bool sortByColor = false);
+    void flush();
+
+    // Texture loading and manipulation
+    SDL_Texture* loadTexture(const std::string& path);
+    SDL_Texture* createTextureFromSurface(SDL_Surface* surface);
+    SDL_Texture* createTexture(int width, int height);
+    void freeTexture(SDL_Texture* texture);
+    void setTextureBlendMode(SDL_Texture* texture, SDL_BlendMode blendMode);
+    void setTextureAlphaMod(SDL_Texture* texture, Uint8 alpha);
+    void setTextureColorMod(SDL_Texture* texture, Uint8 r, Uint8 g, Uint8 b);
+
+    // Texture registry. Each loaded image gets its own texture behind an integer id (-1 on failure),
+    // so nothing outside the wrapper holds an SDL_Texture*. w or h of -1 draws at the texture's size.
+    int openTexture(const std::string& path);
+    void closeTexture(int id);
+    bool getTextureSize(int id, int* w, int* h);
+    void drawTexture(int id, int x, int y, int w = -1, int h = -1);
+    void drawTextureRegion(int id, const SDL_Rect& src, const SDL_Rect& dst);
+    void setTextureBlendMode(int id, SDL_BlendMode blendMode);
+    void setTextureAlphaMod(int id, Uint8 alpha);
+    void setTextureColorMod(int id, Uint8 r, Uint8 g, Uint8 b);
+
+    // Sprites, packed into shared atlas pages when loaded and addressed by integer id (-1 on failure).
+    // createSprite takes w x h tightly packed RGBA32 pixels.
+    int loadSprite(const std::string& path);
+    int createSprite(const Uint8* rgba, int w, int h);
+    void freeSprite(int id);
+    bool getSpriteSize(int id, int* w, int* h) const;
+    size_t getSpritePageCount() const;
+    // Queues rows of (sprite, x, y, w, h, r, g, b, a, layer) with the batch; flush draws them with one
+    // SDL_RenderGeometry call per run of the same layer and atlas page (see SpriteBatch)
+    void submitSprites(const int* rows, size_t count);
+    SpriteBatchStats getSpriteStats() const;
+
+    // Font registry. Each (path, size) is opened once and kept behind an integer id (-1 on failure);
+    // loadFont opens or reuses a font and makes it the default for the overloads without an id.
+    int openFont(const std::string& path, int size);
+    void closeFont(int id);
+    bool setFont(int id);
+    int getFont() const;
+    bool loadFont(const std::string& path, int size);
+
+    // Streaming framebuffers, addressed by integer id (-1 on failure). lockFramebuffer maps the
+    // texture's RGBA32 pixels for writing; the mapping is write-only and only valid until unlock.
+    int createFramebuffer(int w, int h);
+    bool lockFramebuffer(int id, void** pixels, int* pitch);
+    void unlockFramebuffer(int id);
+    void drawFramebuffer(int id, int x, int y, int w = -1, int h = -1);
+    void freeFramebuffer(int id);
+    bool getFramebufferSize(int id, int* w, int* h);
+
+    // Text rendering
+    void drawText(int fontId, const std::string& text, int x, int y, SDL_Color color);
+    void drawText(int fontId, const std::string& text, int x, int y, Uint8 r, Uint8 g, Uint8 b);
+    void drawText(const std::string& text, int x, int y, SDL_Color color);
+    void drawText(const std::string& text, int x, int y, Uint8 r, Uint8 g, Uint8 b);
+    SDL_Rect getTextSize(int fontId, const std::string& text);
+    SDL_Rect getTextSize(const std::string& text);
+
+    // Text that rarely changes: rendered once per (font, size, text, colour) and kept in an LRU cache
+    void drawLabel(int fontId, const std::string& text, int x, int y, Uint8 r, Uint8 g, Uint8 b);
+    void drawLabel(const std::string& text, int x, int y, Uint8 r, Uint8 g, Uint8 b);
+    void setLabelCacheBudget(size_t bytes);
+    void clearLabelCache();
+    LabelCacheStats getLabelCacheStats() const;
+
+    // Asynchronous loading. Each call queues the file for decoding on a loader thread and returns a
+    // request handle straight away; uploadAssets, called once a frame on the render thread, turns
+    // finished decodes into textures, sprites and fonts until budgetMs is spent and returns how many.
+    int loadTextureAsync(const std::string& path);
+    int loadSpriteAsync(const std::string& path);
+    int openFontAsync(const std::string& path, int size);
+    size_t uploadAssets(double budgetMs);
+    // Once a request is Ready, getAssetId is its texture, sprite or font id
+    AssetState getAssetState(int request) const;
+    int getAssetId(int request) const;
+    size_t getPendingAssets() const;
+
+    // Partial redraw for mostly static scenes. While enabled the frame is kept in a persistent target
+    // texture. track describes what is drawn where (see DamageTracker); beginFrame then clips drawing
+    // and clearScreen to what changed, or returns false if nothing did, and updateScreen copies the
+    // texture to the screen before presenting. Enabling fails without render target support.
+    bool setPartialRedraw(bool enabled);
+    bool isPartialRedraw() const;
+    bool track(Uint64 key, Uint64 signature, int x, int y, int w, int h);
+    void invalidateRect(int x, int y, int w, int h);
+    void invalidateAll();
+    bool beginFrame();
+    // Whether anything in a rect is redrawn this frame; always true without partial redraw
+    bool isDirty(int x, int y, int w, int h) const;
+    SDL_Rect getFrameDamage() const;
+
+    // Per-frame draw call counts and timings, off by default. Frames close at the end of
+    // updateScreen; with trace on each profiled call is kept as a span for the Chrome trace too.
+    void setProfiling(bool enabled, bool trace = false);
+    FrameProfiler& getProfiler() { return profiler; }
+
+    // Frame capture, headless or not; call after updateScreen. captureFrame returns the output as a
+    // new RGBA32 surface the caller frees, or null on failure. saveFramePng captures now and writes the
+    // PNG on a background thread, blocking only if several frames are already waiting to be written.
+    SDL_Surface* captureFrame();
+    bool saveFramePng(const std::string& path);
+    void waitForEncodes();
+    size_t getPendingEncodes() const;
+    size_t getFailedEncodes() const;
+
+    // Event handling
+    bool pollEvent(SDL_Event& event);
+    // Drains up to max queued events into out. With timeoutMs > 0 an empty queue waits that long for the first one.
+    size_t pollEvents(EventRecord* out, size_t max, int timeoutMs = 0);
+
+    // Timing and delays
+    Uint32 getTicks();
+    void delay(Uint32 ms);
+
+    // Frame pacing. paceFrame sleeps only for whatever is left of the 1 / fps budget since the
+    // previous call and returns the seconds elapsed between the two calls.
+    void setTargetFps(int fps);
+    double paceFrame();
+
+    // Input handling
+    const Uint8* getKeyboardState(int* numkeys);
+    bool isKeyPressed(SDL_Scancode key);
+
+    // Call after setting the renderer's draw colour other than through the wrapper, e.g. from a TileLayer
+    void invalidateDrawColor() { drawColorKnown = false; }
+    // How many SDL_RENDER_TARGETS_RESET and SDL_RENDER_DEVICE_RESET events polling has seen. Render target
+    // contents are lost on either and the textures themselves on a device reset, which counts as both
+    Uint32 getTargetResets() const { return targetResets; }
+    Uint32 getDeviceResets() const { return deviceResets; }
+
+    // Getters
+    SDL_Renderer* getRenderer() const;
+    int getWidth() const;
+    int getHeight() const;
+
+    std::tuple<int, int> getMousePosition(); // Return tuple of x and y
+    bool isMouseButtonDown(Uint8 button);
+    bool isWindowFocused();
+
+private:
+    SDL_Window* window = nullptr;
+    SDL_Renderer* renderer = nullptr;
+    int width, height;
+    std::string title;
+    bool initialized = false;
+    bool headless = false; // Initialised without the video subsystem
+    SDL_Surface* headlessTarget = nullptr; // What the headless renderer draws into
+    Uint32 rendererFlags = 0; // As reported by SDL_GetRendererInfo
+
+    Uint64 frameBudget = 0; // Performance counter ticks per frame, 0 means uncapped
+    Uint64 lastFrame = 0;
+    struct FontEntry {
+        std::string path;
+        int size = 0;
+        TTF_Font* font = nullptr;
+        GlyphAtlas atlas;
+
+        ~FontEntry();
+    };
+
+    std::vector<std::unique_ptr<FontEntry>> fonts; // Indexed by font id, closed slots are null
+    std::map<std::pair<std::string, int>, int> fontIds;
+    int currentFont = -1;
+    LabelCache labelCache;
+
+    struct Framebuffer {
+        SDL_Texture* texture = nullptr;
+        int w = 0, h = 0;
+        bool locked = false;
+    };
+    std::vector<Framebuffer> framebuffers; // Indexed by id, freed slots have a null texture
+
+    struct TextureEntry {
+        SDL_Texture* texture = nullptr;
+        int w = 0, h = 0;
+    };
+    std::vector<TextureEntry> textures; // Indexed by id, closed slots have a null texture
+
+    SpriteAtlas spriteAtlas;
+    SpriteBatch spriteBatch;
+
+    std::unique_ptr<AssetLoader> assetLoader; // Started by the first async load
+    std::unique_ptr<FrameEncoder> frameEncoder; // Started by the first saveFramePng
+
+    DamageTracker damage;
+    SDL_Texture* canvas = nullptr; // The retained frame while partial redraw is on
+    int canvasW = 0, canvasH = 0;
+    bool partialRedraw = false;
+    bool inFrame = false; // Between beginFrame and updateScreen
+    std::atomic<bool> canvasLost{ false }; // Set while polling events on a render device reset
+    Uint32 targetResets = 0, deviceResets = 0;
+
+    FrameProfiler profiler;
+    Uint32 drawColor = 0; // Last colour set through _setDrawColor, as RGBA, for counting changes
+    bool drawColorKnown = false; // False once something else may have changed it
+
+    MeshRasterizer meshRasterizer;
+
+    std::vector<BatchCommand> batch;
+    std::vector<SDL_Rect> batchRects;
+    std::vector<SDL_FPoint> polygonPoints;
+    std::vector<int> polygonIndices;
+    std::vector<SDL_Vertex> geometryVertices;
+    std::vector<SDL_Rect> circleSpans;
+    std::vector<SDL_Point> circlePoints;
+    std::vector<SDL_Vertex> circleVertices;
+    std::vector<int> circleIndices;
+
+    void _noteEvent(const SDL_Event& event);
+    void _endFrame();
+    void _setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+    void _submitBatch(BatchPrimitive kind, const int* rows, size_t count, bool sortByColor);
+    FontEntry* _font(int id);
+    Framebuffer* _framebuffer(int id);
+    TextureEntry* _texture(int id);
+    int _addTexture(SDL_Texture* texture);
+    AssetLoader& _assets();
+    bool _ensureTextAtlas(FontEntry& entry);
+    void _renderBlended(const SDL_Vertex* vertices, int vertexCount, const int* indices, int indexCount);
+    void _pushCoveragePixel(int x, int y, SDL_Color color, float coverage);
+
+};
+
+#endif